@@ -0,0 +1,345 @@
+//
+// Benchmarks the address computation and search stages across payload sizes and page lengths
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "babel_engine.h"
+#include "fitting.h"
+#include "stats.h"
+
+
+using namespace Babel;
+
+
+// Count every allocation made by the benchmarks, so allocations per operation can be reported
+static std::atomic<size_t> allocationCount{0};
+
+void* operator new(const std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// GMP allocates through its own functions, which are counted the same way
+void* gmpAllocate(const size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size);
+}
+
+void* gmpReallocate(void* ptr, size_t, const size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::realloc(ptr, size);
+}
+
+void gmpFree(void* ptr, size_t) { std::free(ptr); }
+
+
+/**
+ * The configuration of a benchmark run, taken from the command line
+ */
+struct BenchOptions {
+    // The time spent measuring each benchmark
+    std::chrono::milliseconds duration{200};
+    // The most times each benchmark is run
+    size_t maxIterations = 100000;
+    // Only benchmarks whose name contains this string are run
+    std::string filter;
+    // The file to write the results to as JSON, if any
+    std::string jsonPath;
+};
+
+
+/**
+ * The measurements of a single benchmark
+ */
+struct BenchResult {
+    std::string name;
+    size_t pageLen = 0;
+    size_t payloadLen = 0;
+    size_t iterations = 0;
+    double mbPerSec = 0;
+    double meanNs = 0;
+    double p50Ns = 0;
+    double p90Ns = 0;
+    double p99Ns = 0;
+    double maxNs = 0;
+    double allocationsPerOp = 0;
+};
+
+
+/**
+ * Run an operation repeatedly, timing every run
+ * @param options The configuration of the run
+ * @param name The name of the benchmark
+ * @param pageLen The page length the operation works with
+ * @param payloadLen The number of bytes each run processes, used for the throughput
+ * @param op The operation to measure
+ * @return The measurements of the benchmark
+ */
+template<typename Op>
+BenchResult measure(const BenchOptions& options, const std::string& name, const size_t pageLen, const size_t payloadLen, Op&& op) {
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up caches, lazily initialized tables and scratch buffers
+    op();
+
+    std::vector<double> latencies;
+    latencies.reserve(options.maxIterations);
+    const size_t allocationsBefore = allocationCount.load();
+    const Clock::time_point end = Clock::now() + options.duration;
+    double totalNs = 0;
+    while (latencies.size() < options.maxIterations && (latencies.size() < 5 || Clock::now() < end)) {
+        const Clock::time_point start = Clock::now();
+        op();
+        const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        totalNs += ns;
+        latencies.push_back(ns);
+    }
+    const size_t allocations = allocationCount.load() - allocationsBefore;
+
+    std::sort(latencies.begin(), latencies.end());
+    BenchResult result;
+    result.name = name;
+    result.pageLen = pageLen;
+    result.payloadLen = payloadLen;
+    result.iterations = latencies.size();
+    result.mbPerSec = static_cast<double>(payloadLen) * static_cast<double>(latencies.size()) / (totalNs / 1e9) / 1e6;
+    result.meanNs = totalNs / static_cast<double>(latencies.size());
+    result.p50Ns = percentile(latencies, 50);
+    result.p90Ns = percentile(latencies, 90);
+    result.p99Ns = percentile(latencies, 99);
+    result.maxNs = latencies.back();
+    result.allocationsPerOp = static_cast<double>(allocations) / static_cast<double>(latencies.size());
+    return result;
+}
+
+
+/**
+ * Print a result as a row of the results table
+ */
+void printResult(const BenchResult& result) {
+    std::cout << std::left << std::setw(32) << result.name << std::right
+              << std::setw(10) << result.pageLen << std::setw(10) << result.payloadLen
+              << std::setw(10) << result.iterations << std::fixed << std::setprecision(1)
+              << std::setw(12) << result.mbPerSec
+              << std::setw(12) << result.p50Ns / 1e3 << std::setw(12) << result.p90Ns / 1e3
+              << std::setw(12) << result.p99Ns / 1e3 << std::setprecision(2)
+              << std::setw(10) << result.allocationsPerOp << std::endl;
+}
+
+
+/**
+ * Write the results as a JSON document
+ */
+void writeJson(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"pageLen\": " << r.pageLen << ", \"payloadLen\": " << r.payloadLen
+            << ", \"iterations\": " << r.iterations << std::setprecision(6) << std::defaultfloat
+            << ", \"mbPerSec\": " << r.mbPerSec << ", \"meanNs\": " << r.meanNs << ", \"p50Ns\": " << r.p50Ns
+            << ", \"p90Ns\": " << r.p90Ns << ", \"p99Ns\": " << r.p99Ns << ", \"maxNs\": " << r.maxNs
+            << ", \"allocationsPerOp\": " << r.allocationsPerOp << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+
+/**
+ * Parse the command line into the configuration of the run
+ */
+BenchOptions parseArgs(const int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--duration-ms" && hasValue) options.duration = std::chrono::milliseconds(std::stoul(argv[++i]));
+        else if (arg == "--max-iterations" && hasValue) options.maxIterations = std::stoul(argv[++i]);
+        else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--duration-ms N] [--max-iterations N] [--filter NAME] [--json FILE]" << std::endl;
+            std::exit(arg == "--help" ? 0 : 1);
+        }
+    }
+    return options;
+}
+
+
+int main(const int argc, char** argv) {
+    const BenchOptions options = parseArgs(argc, argv);
+    mp_set_memory_functions(gmpAllocate, gmpReallocate, gmpFree);
+
+    std::vector<BenchResult> results;
+    const auto run = [&](const std::string& name, const size_t pageLen, const size_t payloadLen, auto&& op) {
+        if (name.find(options.filter) == std::string::npos) return;
+        results.push_back(measure(options, name, pageLen, payloadLen, op));
+        printResult(results.back());
+    };
+
+    std::cout << std::left << std::setw(32) << "benchmark" << std::right << std::setw(10) << "page" << std::setw(10)
+              << "payload" << std::setw(10) << "iters" << std::setw(12) << "MB/s" << std::setw(12) << "p50 us"
+              << std::setw(12) << "p90 us" << std::setw(12) << "p99 us" << std::setw(10) << "allocs" << std::endl;
+
+    std::mt19937_64 rng(42);
+    const auto randomBytes = [&](const size_t len) {
+        std::vector<unsigned char> bytes(len);
+        for (unsigned char& byte : bytes) byte = static_cast<unsigned char>(rng());
+        return bytes;
+    };
+
+    for (const size_t pageLen : {size_t{512}, size_t{1024 * 4}, static_cast<size_t>(MAX_PAGE_LEN), size_t{1024 * 1024}}) {
+        EngineOptions engineOptions;
+        engineOptions.seed = 42;
+        engineOptions.pageLen = pageLen;
+        Engine engine(engineOptions);
+
+        engineOptions.paddingGenerator = [] { return std::make_unique<MersennePaddingGenerator>(); };
+        Engine mersenneEngine(engineOptions);
+
+        engineOptions.paddingGenerator = nullptr;
+        engineOptions.alphabet = AddressAlphabet::Base64Url;
+        Engine urlEngine(engineOptions);
+
+        engineOptions.alphabet = DEFAULT_ADDRESS_ALPHABET;
+        engineOptions.zeroFilledAddresses = true;
+        Engine zeroFilledEngine(engineOptions);
+        engineOptions.zeroFilledAddresses = false;
+
+        engineOptions.searchCache = std::make_shared<SearchCache>();
+        Engine cachedEngine(engineOptions);
+
+        // The index file is unlinked at once, as it stays mapped for as long as this run uses it
+        const std::string indexPath = (std::filesystem::temp_directory_path() / ("babel_bench_" + std::to_string(pageLen) + ".idx")).string();
+        std::filesystem::remove(indexPath);
+        AddressIndexOptions indexOptions;
+        indexOptions.pageLen = pageLen;
+        engineOptions.searchCache = nullptr;
+        engineOptions.addressIndex = std::make_shared<AddressIndex>(indexPath, indexOptions);
+        std::filesystem::remove(indexPath);
+        Engine indexedEngine(engineOptions);
+
+        CounterPaddingGenerator counterPadding;
+        MersennePaddingGenerator mersennePadding;
+        std::string address;
+        std::vector<unsigned char> page;
+        std::vector<unsigned char> fitted;
+        for (const size_t payloadLen : {size_t{64}, size_t{1024}, pageLen}) {
+            if (payloadLen > pageLen) continue;
+            const std::vector<unsigned char> data = randomBytes(payloadLen);
+
+            run("fitData/zero", pageLen, payloadLen, [&] { fitData(data, false, pageLen, rng, counterPadding, fitted); });
+            run("fitData/random", pageLen, payloadLen, [&] { fitData(data, true, pageLen, rng, counterPadding, fitted); });
+            run("fitData/random-mersenne", pageLen, payloadLen, [&] {
+                fitData(data, true, pageLen, rng, mersennePadding, fitted);
+            });
+            run("computeAddress/zero", pageLen, payloadLen, [&] { engine.computeAddress(data, false, address); });
+            run("computeAddress/random", pageLen, payloadLen, [&] { engine.computeAddress(data, true, address); });
+            run("computeAddress/random-mersenne", pageLen, payloadLen, [&] {
+                mersenneEngine.computeAddress(data, true, address);
+            });
+            run("computeAddress/zero-url", pageLen, payloadLen, [&] { urlEngine.computeAddress(data, false, address); });
+            run("computeAddress/zero-filled", pageLen, payloadLen, [&] {
+                zeroFilledEngine.computeAddress(data, false, address);
+            });
+            run("computeAddress/indexed", pageLen, payloadLen, [&] { indexedEngine.computeAddress(data, false, address); });
+            run("sha256", pageLen, payloadLen, [&] { sha256(ByteView(data)); });
+            // Searched addresses are computed outside the timed runs, so filtered runs still have one to search
+            engine.computeAddress(data, true, address);
+            run("search", pageLen, pageLen, [&] { engine.search(address, page); });
+            const std::string urlAddress = transcodeAddress(address, DEFAULT_ADDRESS_ALPHABET, AddressAlphabet::Base64Url);
+            run("search/url", pageLen, pageLen, [&] { urlEngine.search(urlAddress, page); });
+            const std::string zeroFilledAddress = zeroFilledEngine.computeAddress(data, false);
+            run("search/zero-filled", pageLen, pageLen, [&] { engine.search(zeroFilledAddress, page); });
+        }
+
+        const std::string shortAddress = "simpleaddress:2:4:4:300";
+        run("search/short", pageLen, pageLen, [&] { engine.search(shortAddress, page); });
+        run("search/cached", pageLen, pageLen, [&] { cachedEngine.searchShared(shortAddress); });
+        // Previews decode only the start of the page, so they should cost the same at every page length
+        const size_t previewLen = std::min(pageLen, size_t{1024});
+        std::vector<unsigned char> preview(previewLen);
+        run("searchRange/1k", pageLen, previewLen, [&] { engine.searchRange(address, 0, ByteBuffer(preview)); });
+        run("searchRange/short-1k", pageLen, previewLen, [&] { engine.searchRange(shortAddress, 0, ByteBuffer(preview)); });
+
+        std::string fittedAddress;
+        for (const PaddingScheme scheme : {PaddingScheme::Counter, PaddingScheme::Legacy}) {
+            const std::string name = scheme == PaddingScheme::Counter ? "fitAddress/counter" : "fitAddress/legacy";
+            run(name, pageLen, minAddressLength(pageLen), [&] {
+                fitAddress("simpleaddress", scheme, minAddressLength(pageLen), fittedAddress);
+            });
+        }
+    }
+
+    for (const size_t len : {size_t{64}, size_t{1024}, size_t{1024 * 16}, size_t{1024 * 256}}) {
+        const std::vector<unsigned char> bytes = randomBytes(len);
+        const mpz_class num = baseToNum(bytes, 256);
+
+        for (const int base : {16, 32, 64, 256}) {
+            const std::vector<unsigned char> digits = numToBase(num, base);
+            run("numToBase/" + std::to_string(base), 0, len, [&] { numToBase(num, base); });
+            run("baseToNum/" + std::to_string(base), 0, len, [&] { baseToNum(digits, base); });
+        }
+
+        // Charsets whose sizes are not powers of two go through the divide-and-conquer radix codec, and base85 has no
+        // negative sign, which the raw bytes read as when they start with '-'
+        const mpz_class magnitude = abs(num);
+        for (const auto& [name, charset] : {std::pair{"babel", BABEL_TEXT_DIGITS}, std::pair{"58", BASE58_DIGITS},
+                                            std::pair{"85", BASE85_DIGITS}}) {
+            const std::vector<unsigned char> digits = numToBase(magnitude, charset);
+            run(std::string("numToBase/") + name, 0, len, [&] { numToBase(magnitude, charset); });
+            run(std::string("baseToNum/") + name, 0, len, [&] { baseToNum(digits, charset); });
+        }
+    }
+
+    const std::string address = computeAddress(randomBytes(64), false);
+    run("getAddressComponents", MAX_PAGE_LEN, address.length(), [&] { getAddressComponents(address); });
+    run("parseAddress", MAX_PAGE_LEN, address.length(), [&] { parseAddress(address); });
+
+    std::vector<unsigned char> packed(maxPackedAddressLength(MAX_PAGE_LEN));
+    std::vector<char> unpacked(MAX_ADDRESS_LEN);
+    const size_t packedLen = packAddress(address, ByteBuffer(packed));
+    run("packAddress", MAX_PAGE_LEN, address.length(), [&] { packAddress(address, ByteBuffer(packed)); });
+    run("unpackAddress", MAX_PAGE_LEN, address.length(), [&] {
+        unpackAddress(ByteView(packed.data(), packedLen), CharBuffer(unpacked));
+    });
+
+    if constexpr (INSTRUMENTATION_ENABLED) {
+        // Break the time of every benchmark down by the stages it ran
+        const InstrumentationStats stats = instrumentationStats();
+        std::cout << '\n' << std::left << std::setw(16) << "stage" << std::right << std::setw(10) << "calls"
+                  << std::setw(10) << "ms" << std::setw(10) << "MB" << std::setw(13) << "allocations" << std::endl;
+        for (size_t i = 0; i < STAGE_COUNT; ++i) {
+            const StageStats& stage = stats.stages[i];
+            std::cout << std::left << std::setw(16) << stageName(static_cast<Stage>(i)) << std::right
+                      << std::setw(10) << stage.calls << std::setw(10) << stage.nanoseconds / 1000000
+                      << std::setw(10) << stage.bytes / 1000000 << std::setw(13) << stage.allocations << std::endl;
+        }
+    }
+
+    if (!options.jsonPath.empty()) {
+        std::ofstream json(options.jsonPath);
+        writeJson(json, results);
+        if (!json) {
+            std::cerr << "Failed to write " << options.jsonPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
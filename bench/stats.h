@@ -0,0 +1,24 @@
+#ifndef BABEL_STATS_H
+#define BABEL_STATS_H
+
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace Babel {
+
+    /**
+     * Get a percentile of sorted latencies, shared by the latency reports of babel_bench and babel_loadgen
+     * @param sorted The latencies, in ascending order
+     * @param percentile The percentile to get, in the range [0, 100]
+     * @return The latency at the percentile, or zero if there are none
+     */
+    inline double percentile(const std::vector<double>& sorted, const double percentile) {
+        if (sorted.empty()) return 0;
+        const size_t index = static_cast<size_t>(percentile / 100 * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+}
+
+#endif //BABEL_STATS_H
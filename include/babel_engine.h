@@ -3,7 +3,21 @@
 
 
 #include <gmpxx.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace Babel {
@@ -20,13 +34,212 @@ namespace Babel {
     }
     inline std::vector<unsigned char> BASE256_CHARSET = build256Charset();
 
+    /**
+     * Get the length below which hexagons are padded before they are searched
+     * @param pageLen The number of bytes in a page
+     * @return The minimum address length for the page length
+     */
+    constexpr size_t minAddressLength(const size_t pageLen) { return pageLen * 4 / 3; }
+
+    /**
+     * Get the maximum number of digits in the hexagon of a page, which holds the page bytes and a four byte seed
+     * @param pageLen The number of bytes in a page
+     * @return The maximum number of base64 digits in a hexagon
+     */
+    constexpr size_t maxHexagonLength(const size_t pageLen) { return (pageLen + 4 + 2) / 3 * 4; }
+
     constexpr int MAX_PAGE_LEN = 1024 * 64;
-    constexpr int MIN_ADDRESS_LEN = MAX_PAGE_LEN * 4 / 3;
+    constexpr int MIN_ADDRESS_LEN = minAddressLength(MAX_PAGE_LEN);
 
     constexpr int WALLS_PER_HEXAGON = 4;
     constexpr int SHELVES_PER_WALL = 5;
     constexpr int VOLUMES_PER_SHELF = 32;
     constexpr int PAGES_PER_VOLUME = 410;
+    constexpr int COORDINATES_PER_HEXAGON = WALLS_PER_HEXAGON * SHELVES_PER_WALL * VOLUMES_PER_SHELF * PAGES_PER_VOLUME;
+
+    // The longest wall, shelf, volume and page of a computed address, with their separating colons
+    constexpr size_t MAX_COORDINATE_LEN = 4 + 1 + 1 + 2 + 3;
+
+    /**
+     * Get the maximum length of a computed address, the size of a buffer that can hold any address of a page length
+     * @param pageLen The number of bytes in a page
+     * @return The maximum number of characters in a computed address
+     */
+    constexpr size_t maxAddressLength(const size_t pageLen) { return maxHexagonLength(pageLen) + MAX_COORDINATE_LEN; }
+
+    constexpr size_t MAX_ADDRESS_LEN = maxAddressLength(MAX_PAGE_LEN);
+
+    /**
+     * Get the length of the packed binary form of an address, a header byte, the hexagon digits at six bits each, then
+     * a four byte coordinate
+     * @param hexagonLen The number of digits in the hexagon, not counting any negative sign or zero-fill mark
+     * @return The number of bytes in the packed address
+     */
+    constexpr size_t packedAddressLength(const size_t hexagonLen) { return 1 + hexagonLen / 4 * 3 + hexagonLen % 4 + 4; }
+
+    /**
+     * Get the size of a buffer that can hold the packed form of any address computed for a page length
+     * @param pageLen The number of bytes in a page
+     * @return The maximum number of bytes in a packed address
+     */
+    constexpr size_t maxPackedAddressLength(const size_t pageLen) { return packedAddressLength(maxHexagonLength(pageLen)); }
+
+
+    /**
+     * A view of a contiguous sequence that does not own its elements, standing in for C++20's std::span
+     * @tparam T The type of the elements, const for read-only views
+     */
+    template<typename T>
+    class Span {
+    public:
+        constexpr Span() = default;
+        constexpr Span(T* data, const size_t size) : data_(data), size_(size) {}
+
+        /**
+         * View the elements of a contiguous container, such as a std::vector, std::string or std::array
+         */
+        template<typename Container, typename = std::enable_if_t<std::is_convertible_v<
+                std::remove_pointer_t<decltype(std::declval<Container&>().data())>(*)[], T(*)[]>>>
+        constexpr Span(Container& container) : data_(container.data()), size_(container.size()) {}
+
+        [[nodiscard]] constexpr T* data() const { return data_; }
+        [[nodiscard]] constexpr size_t size() const { return size_; }
+        [[nodiscard]] constexpr bool empty() const { return size_ == 0; }
+        [[nodiscard]] constexpr T* begin() const { return data_; }
+        [[nodiscard]] constexpr T* end() const { return data_ + size_; }
+        constexpr T& operator[](const size_t i) const { return data_[i]; }
+
+        /**
+         * View part of this sequence
+         * @param offset The index of the first element of the part
+         * @param count The number of elements in the part, clamped to the end of the sequence
+         */
+        [[nodiscard]] constexpr Span subspan(const size_t offset, const size_t count = SIZE_MAX) const {
+            const size_t first = offset < size_ ? offset : size_;
+            return {data_ + first, count < size_ - first ? count : size_ - first};
+        }
+
+    private:
+        T* data_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    // A read-only view of bytes, such as the data given to computeAddress()
+    using ByteView = Span<const unsigned char>;
+    // A caller-owned buffer of bytes, such as the page written by search()
+    using ByteBuffer = Span<unsigned char>;
+    // A caller-owned buffer of characters, such as the address written by computeAddress()
+    using CharBuffer = Span<char>;
+
+
+    /**
+     * The schemes used to pad hexagons that are shorter than the minimum address length
+     */
+    enum class PaddingScheme {
+        // Reseed a Mersenne Twister with the std::hash of the hexagon for every character, kept for older addresses
+        Legacy,
+        // Draw characters from a counter-based generator keyed by a portable hash of the hexagon
+        Counter
+    };
+
+    // Legacy stays the default so short addresses stored by earlier versions still resolve to the same pages
+    constexpr PaddingScheme DEFAULT_PADDING_SCHEME = PaddingScheme::Legacy;
+
+
+    // The digits of the power-of-two alphabets, in order of their values
+    constexpr std::string_view BASE16_DIGITS = "0123456789ABCDEF";
+    constexpr std::string_view BASE32_DIGITS = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+    constexpr std::string_view BASE64_DIGITS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    constexpr std::string_view BASE64URL_DIGITS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+
+    /**
+     * The alphabets the hexagons of addresses are written in.  Every alphabet has the same digits under different
+     * characters, so an address can be moved between alphabets character by character and still finds the same page.
+     */
+    enum class AddressAlphabet : uint8_t {
+        // Standard base64, whose '+' and '/' must be escaped in URLs and file names
+        Base64,
+        // URL and filename safe base64, writing '-' and '_' for the last two digits and '~' for the negative sign
+        Base64Url
+    };
+
+    constexpr AddressAlphabet DEFAULT_ADDRESS_ALPHABET = AddressAlphabet::Base64;
+
+
+    /**
+     * Get the digits of an address alphabet, in order of their values
+     */
+    constexpr std::string_view alphabetDigits(const AddressAlphabet alphabet) {
+        return alphabet == AddressAlphabet::Base64Url ? BASE64URL_DIGITS : BASE64_DIGITS;
+    }
+
+
+    /**
+     * Get the character that starts a negative hexagon in an address alphabet
+     */
+    constexpr char alphabetSign(const AddressAlphabet alphabet) {
+        return alphabet == AddressAlphabet::Base64Url ? '~' : '-';
+    }
+
+
+    // The character that ends a zero-filled hexagon, whose digits are followed by zero digits up to the width of a page
+    constexpr char ZERO_FILL_MARK = '.';
+
+
+    /**
+     * Generates the random bytes that surround data shorter than a page.  A generator must give the same bytes whether a
+     * range is filled at once or in consecutive pieces whose lengths are multiples of eight.
+     */
+    class PaddingGenerator {
+    public:
+        virtual ~PaddingGenerator() = default;
+
+        /**
+         * Restart the generator from a seed
+         * @param seed The seed of the generator
+         */
+        virtual void seed(uint64_t seed) = 0;
+
+        /**
+         * Fill a buffer with the next random bytes of the generator
+         * @param dst The buffer to fill
+         * @param len The number of bytes to fill
+         */
+        virtual void fill(unsigned char* dst, size_t len) = 0;
+    };
+
+
+    /**
+     * Draws padding eight bytes at a time from a counter-based generator, each word being the SplitMix64 output of its
+     * index.  No word depends on the one before it, so the fill loop has no serial dependency and vectorizes.
+     */
+    class CounterPaddingGenerator final : public PaddingGenerator {
+    public:
+        void seed(uint64_t seed) override;
+        void fill(unsigned char* dst, size_t len) override;
+
+    private:
+        uint64_t key_ = 0;
+        uint64_t counter_ = 0;
+    };
+
+
+    /**
+     * Draws padding eight bytes at a time from a 64-bit Mersenne Twister, as earlier versions of this library did
+     */
+    class MersennePaddingGenerator final : public PaddingGenerator {
+    public:
+        void seed(uint64_t seed) override;
+        void fill(unsigned char* dst, size_t len) override;
+
+    private:
+        std::mt19937_64 rng_;
+    };
+
+
+    // Creates the padding generator of an engine
+    using PaddingGeneratorFactory = std::function<std::unique_ptr<PaddingGenerator>()>;
 
 
     struct LibraryCoordinate {
@@ -38,6 +251,66 @@ namespace Babel {
     };
 
 
+    /**
+     * The wall, shelf, volume and page of a library coordinate as numbers, each starting from one
+     */
+    struct PackedCoordinate {
+        uint8_t wall = 1;
+        uint8_t shelf = 1;
+        uint8_t volume = 1;
+        uint16_t page = 1;
+
+        /**
+         * Get the seed of the coordinate, the integer its zero-padded page, volume, shelf and wall spell in that order
+         */
+        [[nodiscard]] constexpr unsigned int seed() const {
+            return page * 10000u + volume * 100u + shelf * 10u + wall;
+        }
+
+        /**
+         * Get the position of the coordinate among those of a hexagon, which are ordered by wall, shelf, volume, then
+         * page
+         */
+        [[nodiscard]] constexpr uint32_t index() const {
+            return ((static_cast<uint32_t>(wall - 1) * SHELVES_PER_WALL + shelf - 1) * VOLUMES_PER_SHELF + volume - 1) *
+                   PAGES_PER_VOLUME + page - 1;
+        }
+
+        /**
+         * Get the coordinate at a position among those of a hexagon, wrapping around past the last coordinate
+         * @param index The position of the coordinate
+         * @return The coordinate at the position
+         */
+        static constexpr PackedCoordinate fromIndex(uint64_t index) {
+            index %= COORDINATES_PER_HEXAGON;
+            PackedCoordinate coord;
+            coord.page = static_cast<uint16_t>(index % PAGES_PER_VOLUME + 1);
+            index /= PAGES_PER_VOLUME;
+            coord.volume = static_cast<uint8_t>(index % VOLUMES_PER_SHELF + 1);
+            index /= VOLUMES_PER_SHELF;
+            coord.shelf = static_cast<uint8_t>(index % SHELVES_PER_WALL + 1);
+            coord.wall = static_cast<uint8_t>(index / SHELVES_PER_WALL + 1);
+            return coord;
+        }
+
+        constexpr bool operator==(const PackedCoordinate &other) const {
+            return wall == other.wall && shelf == other.shelf && volume == other.volume && page == other.page;
+        }
+
+        constexpr bool operator!=(const PackedCoordinate &other) const { return !(*this == other); }
+    };
+
+
+    /**
+     * An address parsed into a view of its hexagon and a numeric coordinate
+     */
+    struct ParsedAddress {
+        // The hexagon, viewed within the parsed address
+        std::string_view hexagon;
+        PackedCoordinate coordinate;
+    };
+
+
     /**
      * Get the characters that compose a number encoded in a given base
      * @param base The base to get the charset for
@@ -79,6 +352,106 @@ namespace Babel {
     mpz_class baseToNum(const std::vector<unsigned char> &vec, int base);
 
 
+    // The digits of common alphabets whose sizes are not powers of two, in order of their values
+    constexpr std::string_view BABEL_TEXT_DIGITS = "abcdefghijklmnopqrstuvwxyz ,.";
+    constexpr std::string_view BASE58_DIGITS = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    constexpr std::string_view BASE85_DIGITS =
+            "!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstu";
+
+
+    /**
+     * Converts big integers to and from the digits of any charset.  A number is split in half by a cached power of the
+     * base, and each half is converted on its own down to numbers of a few words, so conversions take the time of
+     * GMP's subquadratic division and multiplication rather than a quadratic digit-by-digit loop.  The powers are
+     * computed as numbers of new lengths are converted, so a codec is not thread-safe, and each thread should use its
+     * own.
+     */
+    class RadixCodec {
+    public:
+        /**
+         * @param charset The characters of the digits in order of their values, between 2 and 256 distinct characters
+         * @throws std::invalid_argument If the charset is too short, too long or repeats a character
+         */
+        explicit RadixCodec(std::string_view charset);
+
+        /**
+         * Get the number of digits in the charset
+         */
+        [[nodiscard]] size_t base() const { return charset_.size(); }
+
+        /**
+         * Get the characters of the digits in order of their values
+         */
+        [[nodiscard]] std::string_view charset() const { return charset_; }
+
+        /**
+         * Convert a GMP number to its digits, without leading zero digits.  Negative numbers start with '-', unless
+         * '-' is a digit of the charset.
+         * @param x The number to convert
+         * @return The digits of the number
+         * @throws std::invalid_argument If the number is negative and '-' is a digit of the charset
+         */
+        std::vector<unsigned char> numToBase(const mpz_class& x);
+
+        /**
+         * Convert digits to a GMP number, reading a leading '-' as the negative sign unless '-' is a digit
+         * @param vec The digits to convert
+         * @return The number represented by the digits
+         * @throws std::invalid_argument If a character is not a digit of the charset
+         */
+        mpz_class baseToNum(const std::vector<unsigned char>& vec);
+
+    private:
+        /**
+         * Make sure the powers of the base for the given number of levels are cached
+         */
+        void cachePowers(size_t levels);
+
+        /**
+         * Get the level of the first power of the base whose width holds a number of digits
+         */
+        [[nodiscard]] size_t levelFor(size_t digits) const;
+
+        /**
+         * Write a number below the power of a level as exactly the width of the level in digits
+         */
+        void writeDigits(const mpz_class& x, size_t level, unsigned char* dst) const;
+
+        /**
+         * Read at most the width of a level in digits
+         */
+        void readDigits(const unsigned char* digits, size_t len, size_t level, mpz_class& x) const;
+
+        std::string charset_;
+        short values_[256];
+        bool signed_;
+        // As many digits as fit in a word are converted at once, and numbers of LEAF_WORDS words digit by digit
+        unsigned long wordBase_;
+        size_t wordDigits_;
+        size_t leafDigits_;
+        // powers_[i] is the base to the power of leafDigits_ << i, the divisor that splits a number of level i + 1
+        std::vector<mpz_class> powers_;
+    };
+
+
+    /**
+     * Convert a GMP number to the digits of any charset, through a radix codec kept for the charset on each thread
+     * @param x The number to convert
+     * @param charset The characters of the digits in order of their values
+     * @return The number as a vector of digits
+     */
+    std::vector<unsigned char> numToBase(const mpz_class& x, std::string_view charset);
+
+
+    /**
+     * Convert the digits of any charset to a GMP number, through a radix codec kept for the charset on each thread
+     * @param vec The digits to convert
+     * @param charset The characters of the digits in order of their values
+     * @return The number represented by the digits
+     */
+    mpz_class baseToNum(const std::vector<unsigned char>& vec, std::string_view charset);
+
+
     /**
      * Get the decomposed components of an address
      * @param address The address to get the components of
@@ -87,6 +460,89 @@ namespace Babel {
     LibraryCoordinate getAddressComponents(const std::string &address);
 
 
+    /**
+     * Parse an address without allocating, reading each component of the coordinate with std::from_chars
+     * @param address The address to parse, hexagon:wall:shelf:volume:page
+     * @return A view of the hexagon and the numeric coordinate
+     * @throws std::invalid_argument If a component is missing, is not a number, is wider than its largest value, or is
+     * out of range
+     */
+    ParsedAddress parseAddress(std::string_view address);
+
+
+    /**
+     * Write the text form of a coordinate, :wall:shelf:volume:page with the volume and page padded with zeros
+     * @param coord The coordinate to write
+     * @param dst The buffer to write to, which must hold at least MAX_COORDINATE_LEN characters
+     * @return The number of characters written, always MAX_COORDINATE_LEN
+     */
+    size_t formatCoordinate(const PackedCoordinate &coord, char* dst);
+
+
+    /**
+     * Pack an address into its binary form, which stores the hexagon digits at six bits each and is a quarter smaller
+     * than the text
+     * @param address The address to pack
+     * @param packed The buffer to write the packed address to, which must hold at least packedAddressLength() bytes
+     * @param alphabet The alphabet the address is written in, the packed form is the same for every alphabet
+     * @return The number of bytes written
+     * @throws std::invalid_argument If the address cannot be parsed or its hexagon is not in the alphabet
+     * @throws std::length_error If the buffer is too small
+     */
+    size_t packAddress(std::string_view address, ByteBuffer packed, AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+
+    /**
+     * Pack an address into its binary form
+     * @param address The address to pack
+     * @param alphabet The alphabet the address is written in
+     * @return The packed address
+     */
+    std::vector<unsigned char> packAddress(std::string_view address, AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+
+    /**
+     * Get the number of characters in the text form of a packed address
+     * @param packed The packed address
+     * @return The number of characters unpackAddress() writes
+     * @throws std::invalid_argument If the packed address is malformed
+     */
+    size_t unpackedAddressLength(ByteView packed);
+
+
+    /**
+     * Unpack the binary form of an address back into its text form, with the volume and page padded with zeros.  Any
+     * address packed from its padded text form unpacks to exactly that text.
+     * @param packed The packed address
+     * @param address The buffer to write the address to, which must hold at least unpackedAddressLength() characters
+     * @param alphabet The alphabet to write the address in
+     * @return The number of characters written
+     * @throws std::invalid_argument If the packed address is malformed
+     * @throws std::length_error If the buffer is too small
+     */
+    size_t unpackAddress(ByteView packed, CharBuffer address, AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+
+    /**
+     * Unpack the binary form of an address back into its text form
+     * @param packed The packed address
+     * @param alphabet The alphabet to write the address in
+     * @return The text form of the address
+     */
+    std::string unpackAddress(ByteView packed, AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+
+    /**
+     * Rewrite an address in another alphabet, which finds the same page in an engine using that alphabet
+     * @param address The address to rewrite
+     * @param from The alphabet the address is written in
+     * @param to The alphabet to rewrite the address in
+     * @return The address in the new alphabet
+     * @throws std::invalid_argument If the address cannot be parsed or its hexagon is not in the alphabet
+     */
+    std::string transcodeAddress(std::string_view address, AddressAlphabet from, AddressAlphabet to);
+
+
     /**
      * Get the address of a given byte sequence
      * @param data The data to get the address of
@@ -96,6 +552,17 @@ namespace Babel {
     std::string computeAddress(const std::vector<unsigned char>& data, bool padRandom);
 
 
+    /**
+     * Get the address of a given byte sequence, writing it into a caller-owned buffer
+     * @param data The data to get the address of
+     * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+     * @param address The buffer to write the address to, which must hold at least MAX_ADDRESS_LEN characters
+     * @return The number of characters in the address
+     * @throws std::length_error If the buffer is too small
+     */
+    size_t computeAddress(ByteView data, bool padRandom, CharBuffer address);
+
+
     /**
      * Compute the address of the data provided by a stream
      * @param stream The stream to get data from
@@ -105,20 +572,1085 @@ namespace Babel {
     std::string computeStreamAddress(std::istream& stream, bool padRandom);
 
 
+    /**
+     * Compute the address of the data provided by a stream, writing the address out as the data is read
+     * @param stream The stream to get data from
+     * @param address The stream to write the address to
+     * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+     */
+    void computeStreamAddress(std::istream& stream, std::ostream& address, bool padRandom);
+
+
     /**
      * Search for a byte sequence by its address
      * @param address The address to search for
+     * @param scheme The scheme used to pad short hexagons
      * @return The byte sequence at the given address
      */
-    std::vector<unsigned char> search(const std::string &address);
+    std::vector<unsigned char> search(const std::string &address, PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Search for a byte sequence by its address, writing it into a caller-owned buffer
+     * @param address The address to search for
+     * @param page The buffer to write the byte sequence to, which must hold at least MAX_PAGE_LEN bytes
+     * @param scheme The scheme used to pad short hexagons
+     * @return The number of bytes written, always MAX_PAGE_LEN
+     * @throws std::length_error If the buffer is too small
+     */
+    size_t search(std::string_view address, ByteBuffer page, PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
 
 
     /**
      * Search for a byte sequence by its address
      * @param address The address to search for
      * @param stream The stream to write the byte sequence to
+     * @param scheme The scheme used to pad short hexagons
+     */
+    void searchStream(const std::string &address, std::ostream &stream, PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Search for part of a byte sequence by its address, decoding only that part
+     * @param address The address to search for
+     * @param offset The index of the first byte to get, at most MAX_PAGE_LEN
+     * @param length The number of bytes to get, fewer are returned if the range passes the end of the page
+     * @param scheme The scheme used to pad short hexagons
+     * @return The bytes of the range
+     * @throws std::out_of_range If the offset is past the end of the page
+     */
+    std::vector<unsigned char> searchRange(const std::string &address, size_t offset, size_t length,
+                                           PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Search for part of a byte sequence by its address, writing it into a caller-owned buffer
+     * @param address The address to search for
+     * @param offset The index of the first byte to get, at most MAX_PAGE_LEN
+     * @param range The buffer to fill with the bytes from the offset onwards
+     * @param scheme The scheme used to pad short hexagons
+     * @return The number of bytes written, fewer than the buffer holds if the range passes the end of the page
+     * @throws std::out_of_range If the offset is past the end of the page
+     */
+    size_t searchRange(std::string_view address, size_t offset, ByteBuffer range,
+                       PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Search for part of a byte sequence by its address, writing it to a stream as it is decoded
+     * @param address The address to search for
+     * @param offset The index of the first byte to write, at most MAX_PAGE_LEN
+     * @param length The number of bytes to write, fewer are written if the range passes the end of the page
+     * @param stream The stream to write the bytes to
+     * @param scheme The scheme used to pad short hexagons
+     * @throws std::out_of_range If the offset is past the end of the page
+     */
+    void searchRangeStream(const std::string &address, size_t offset, size_t length, std::ostream &stream,
+                           PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Get the addresses of many byte sequences at once, spread across a shared pool of worker threads
+     * @param data The data to get the addresses of
+     * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+     * @return The addresses of the byte sequences, in the same order as the data
+     */
+    std::vector<std::string> computeAddressBatch(const std::vector<std::vector<unsigned char>>& data, bool padRandom);
+
+
+    /**
+     * Search for many byte sequences at once, spread across a shared pool of worker threads
+     * @param addresses The addresses to search for
+     * @param scheme The scheme used to pad short hexagons
+     * @return The byte sequences at the given addresses, in the same order as the addresses
+     */
+    std::vector<std::vector<unsigned char>> searchBatch(const std::vector<std::string> &addresses,
+                                                        PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Get the address of the start of a file, encoding it straight from a memory mapping of the file
+     * @param path The path of the file
+     * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+     * @return The address of the file's data
+     */
+    std::string computeFileAddress(const std::string &path, bool padRandom);
+
+
+    /**
+     * Search for a byte sequence by its address, decoding it straight into a memory mapping of a file
+     * @param address The address to search for
+     * @param path The path of the file to create or overwrite with the byte sequence
+     * @param scheme The scheme used to pad short hexagons
+     */
+    void searchToFile(const std::string &address, const std::string &path, PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Address data of any length as a book of consecutive pages, spread across a shared pool of worker threads
+     * @param data The stream to get the data from
+     * @param book The stream to write the hexagon of each page to, one per line
+     * @param padRandom Whether to pad the last page with random bytes, otherwise pad with zeros
+     * @return The manifest address of the book
+     */
+    std::string computeBook(std::istream &data, std::ostream &book, bool padRandom);
+
+
+    /**
+     * Search for the data of a book, spread across a shared pool of worker threads
+     * @param manifest The manifest address of the book
+     * @param book The stream to read the hexagon of each page from, one per line
+     * @param data The stream to write the data to
+     * @param scheme The scheme used to pad short hexagons
+     */
+    void searchBook(const std::string &manifest, std::istream &book, std::ostream &data,
+                    PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Thrown by work that was cancelled before it finished
+     */
+    class OperationCancelled : public std::runtime_error {
+    public:
+        OperationCancelled() : std::runtime_error("The operation was cancelled") {}
+    };
+
+
+    /**
+     * A flag shared between the requester of some work and the work itself, which checks it between chunks and stops
+     * with OperationCancelled once it is set.  Copies share the same flag.
+     */
+    class CancellationToken {
+    public:
+        CancellationToken() : cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+        /**
+         * Ask the work holding this token to stop at its next chunk boundary
+         */
+        void cancel() const { cancelled_->store(true, std::memory_order_relaxed); }
+
+        /**
+         * Get whether the work holding this token has been asked to stop
+         */
+        [[nodiscard]] bool cancelled() const { return cancelled_->load(std::memory_order_relaxed); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> cancelled_;
+    };
+
+
+    /**
+     * Get the address of a given byte sequence on the shared executor, without blocking the calling thread
+     * @param data The data to get the address of
+     * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+     * @param token The token to cancel the computation with
+     * @return The future address of the byte sequence
+     */
+    std::future<std::string> computeAddressAsync(std::vector<unsigned char> data, bool padRandom,
+                                                 CancellationToken token = CancellationToken());
+
+
+    /**
+     * Compute the address of the data provided by a stream on the shared executor, without blocking the calling thread
+     * @param stream The stream to get data from, which must outlive the future
+     * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+     * @param token The token to cancel the computation with
+     * @return The future address of the stream's data
+     */
+    std::future<std::string> computeStreamAddressAsync(std::istream &stream, bool padRandom,
+                                                       CancellationToken token = CancellationToken());
+
+
+    /**
+     * Search for a byte sequence by its address on the shared executor, without blocking the calling thread
+     * @param address The address to search for
+     * @param token The token to cancel the search with
+     * @param scheme The scheme used to pad short hexagons
+     * @return The future byte sequence at the given address
+     */
+    std::future<std::vector<unsigned char>> searchAsync(std::string address, CancellationToken token = CancellationToken(),
+                                                        PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    /**
+     * Search for a byte sequence by its address on the shared executor, writing it to a stream
+     * @param address The address to search for
+     * @param stream The stream to write the byte sequence to, which must outlive the future
+     * @param token The token to cancel the search with
+     * @param scheme The scheme used to pad short hexagons
+     * @return A future that is ready once the byte sequence has been written
+     */
+    std::future<void> searchStreamAsync(std::string address, std::ostream &stream,
+                                        CancellationToken token = CancellationToken(),
+                                        PaddingScheme scheme = DEFAULT_PADDING_SCHEME);
+
+
+    // Whether the library was built with BABEL_INSTRUMENTATION, without which stages are neither timed nor traced
+#ifdef BABEL_INSTRUMENTATION
+    constexpr bool INSTRUMENTATION_ENABLED = true;
+#else
+    constexpr bool INSTRUMENTATION_ENABLED = false;
+#endif
+
+
+    /**
+     * The stages of computing and searching addresses that instrumentation times
+     */
+    enum class Stage : uint8_t {
+        // Fitting data to a page, when the page is copied for threads to encode
+        FitData,
+        // Padding a short hexagon before it is searched
+        FitAddress,
+        // Encoding a page as the hexagon of an address
+        Encode,
+        // Appending the coordinate to an encoded hexagon
+        AssembleAddress,
+        // Parsing the hexagon and coordinate out of an address
+        ParseAddress,
+        // Decoding a page from a fitted hexagon
+        Decode,
+        // Converting a big integer to a base with numToBase()
+        NumToBase,
+        // Converting digits in a base to a big integer with baseToNum()
+        BaseToNum
+    };
+
+    constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::BaseToNum) + 1;
+
+
+    /**
+     * Get the name of a stage, for reports
+     */
+    const char* stageName(Stage stage);
+
+
+    /**
+     * The counters of a stage, summed over every call on every thread
+     */
+    struct StageStats {
+        // The number of times the stage ran
+        uint64_t calls = 0;
+        // The total time spent in the stage
+        uint64_t nanoseconds = 0;
+        // The total number of bytes processed by the stage
+        uint64_t bytes = 0;
+        // The number of buffers the library allocated or grew during the stage
+        uint64_t allocations = 0;
+    };
+
+
+    /**
+     * A snapshot of the counters of every stage
+     */
+    struct InstrumentationStats {
+        // The counters of each stage, indexed by the stage
+        StageStats stages[STAGE_COUNT];
+
+        [[nodiscard]] const StageStats &operator[](const Stage stage) const { return stages[static_cast<size_t>(stage)]; }
+    };
+
+
+    /**
+     * Receives every stage as it finishes, given the stage, the nanoseconds it took and the bytes it processed.  It is
+     * called on the thread that ran the stage, so it must be thread-safe and should return quickly.
+     */
+    using TraceCallback = std::function<void(Stage, uint64_t, size_t)>;
+
+
+    /**
+     * Get a snapshot of the counters of every stage, which are all zero unless INSTRUMENTATION_ENABLED
+     */
+    InstrumentationStats instrumentationStats();
+
+
+    /**
+     * Set the counters of every stage back to zero
      */
-    void searchStream(const std::string &address, std::ostream &stream);
+    void resetInstrumentation();
+
+
+    /**
+     * Set the callback that receives every stage as it finishes, which is never called unless INSTRUMENTATION_ENABLED
+     * @param callback The callback, or an empty function to stop tracing
+     */
+    void setTraceCallback(TraceCallback callback);
+
+
+    class AsyncEngine;
+    class BatchEngine;
+    class Engine;
+    class HexagonDecoder;
+    class HexagonPadding;
+    class TaskQueue;
+    class ThreadPool;
+
+
+    // A page found by a search, shared between the cache and its readers and never modified once found
+    using SharedPage = std::shared_ptr<const std::vector<unsigned char>>;
+
+
+    /**
+     * The configuration of a search cache
+     */
+    struct SearchCacheOptions {
+        // The most bytes of pages and addresses the cache holds, split evenly across its shards
+        size_t capacity = 1024 * 1024 * 256;
+        // The number of independently locked shards, more of which lowers contention between threads
+        size_t shards = 16;
+    };
+
+
+    /**
+     * The counters of a search cache
+     */
+    struct SearchCacheStats {
+        // The searches answered from the cache
+        uint64_t hits = 0;
+        // The searches that had to decode their page
+        uint64_t misses = 0;
+        // The pages dropped to make room for others
+        uint64_t evictions = 0;
+        // The pages held by the cache
+        size_t entries = 0;
+        // The bytes of pages and addresses held by the cache
+        size_t bytes = 0;
+    };
+
+
+    /**
+     * Holds the pages of recently searched addresses, so repeated searches skip decoding.  Addresses are hashed to one
+     * of several shards, each with its own reader-writer lock.  Hits take the lock shared, so they never wait on each
+     * other, and mark their page with a reference bit rather than reordering a list.  Inserts take the lock exclusively
+     * and evict with the CLOCK algorithm, sweeping past pages whose bit is set and clearing it, approximating LRU.
+     * Pages are handed out as shared immutable buffers, so a hit copies nothing and an evicted page lives on until its
+     * last reader lets go.  A cache may be shared between any number of engines and threads.
+     */
+    class SearchCache {
+    public:
+        explicit SearchCache(const SearchCacheOptions &options = SearchCacheOptions());
+
+        ~SearchCache();
+
+        SearchCache(const SearchCache&) = delete;
+        SearchCache& operator=(const SearchCache&) = delete;
+
+        /**
+         * Get the configuration of this cache
+         */
+        [[nodiscard]] const SearchCacheOptions &options() const { return options_; }
+
+        /**
+         * Get the counters of this cache, summed across its shards
+         */
+        [[nodiscard]] SearchCacheStats stats() const;
+
+        /**
+         * Drop every page from this cache, leaving the counters as they are
+         */
+        void clear();
+
+    private:
+        struct Shard;
+
+        /**
+         * Find the page of an address searched by an engine with the given page length, padding scheme and alphabet
+         * @return The page, or null if it is not cached
+         */
+        SharedPage find(std::string_view address, size_t pageLen, PaddingScheme scheme, AddressAlphabet alphabet);
+
+        /**
+         * Cache the page of an address, evicting other pages as needed.  Pages larger than a shard are not cached.
+         * @return The cached page, which is the one already cached if another thread inserted the address first
+         */
+        SharedPage insert(std::string_view address, size_t pageLen, PaddingScheme scheme, AddressAlphabet alphabet,
+                          SharedPage page);
+
+        /**
+         * Get the shard of a key and its hash
+         */
+        Shard &shardOf(std::string_view address, size_t pageLen, PaddingScheme scheme, AddressAlphabet alphabet,
+                       uint64_t &hash) const;
+
+        SearchCacheOptions options_;
+        std::unique_ptr<Shard[]> shards_;
+
+        friend class Engine;
+    };
+
+
+    // The SHA-256 digest of some content
+    using ContentDigest = std::array<unsigned char, 32>;
+
+
+    /**
+     * Hash content with SHA-256, using the SHA extensions of the processor when it has them
+     * @param data The content to hash
+     * @return The digest of the content
+     */
+    ContentDigest sha256(ByteView data);
+
+
+    /**
+     * The configuration of an address index
+     */
+    struct AddressIndexOptions {
+        // The page length of the engines the index serves, as addresses only find their data at that page length
+        size_t pageLen = MAX_PAGE_LEN;
+        // The alphabet of the addresses the index holds
+        AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET;
+        // The number of hash buckets of a new index, rounded up to a power of two.  An existing index keeps its own.
+        size_t buckets = 1 << 16;
+        // Whether to open an existing index for lookups only, which any number of processes may do while one writes it
+        bool readOnly = false;
+    };
+
+
+    /**
+     * The counters of an address index
+     */
+    struct AddressIndexStats {
+        // The lookups answered by the index, in this process
+        uint64_t hits = 0;
+        // The lookups the index had no address for, in this process
+        uint64_t misses = 0;
+        // The addresses held by the index
+        size_t entries = 0;
+        // The bytes of the index file in use
+        size_t bytes = 0;
+    };
+
+
+    /**
+     * A persistent index from the SHA-256 digest of data to an address already computed for it, so repeated data gets
+     * its existing address back without being encoded again.  The index is a hash table in a memory-mapped file, whose
+     * buckets hold the offset of the newest record in their chain.  Records are only ever appended, each written in
+     * full before the bucket is pointed at it, so readers never see a partial record and need no locks between
+     * processes.  Opening an index maps the file as it is, with no loading step.
+     *
+     * One process at a time may open an index for writing, which is enforced with an advisory lock, and any number
+     * may open it read-only and see its inserts as they are made.  An index may be shared between any number of
+     * engines and threads of a process.  The file holds native-endian integers, so it is not portable between
+     * machines of different byte orders.
+     */
+    class AddressIndex {
+    public:
+        /**
+         * Open the index at a path, creating it if it does not exist and it is opened for writing
+         * @param path The path of the index file
+         * @param options The configuration of the index
+         * @throws std::system_error If the file cannot be opened, locked or mapped
+         * @throws std::runtime_error If the file is not an address index, or was built for another page length or
+         * alphabet
+         */
+        explicit AddressIndex(const std::string &path, const AddressIndexOptions &options = AddressIndexOptions());
+
+        ~AddressIndex();
+
+        AddressIndex(const AddressIndex&) = delete;
+        AddressIndex& operator=(const AddressIndex&) = delete;
+
+        /**
+         * Get the configuration of this index, with the bucket count of the file
+         */
+        [[nodiscard]] const AddressIndexOptions &options() const { return options_; }
+
+        /**
+         * Get the counters of this index
+         */
+        [[nodiscard]] AddressIndexStats stats() const;
+
+        /**
+         * Flush the records written so far to disk, blocking until they are stored
+         */
+        void sync();
+
+    private:
+        /**
+         * Find the address of data with a digest, copying it into a buffer
+         * @return The length of the address, or zero if the index has no address for the digest
+         */
+        size_t find(const ContentDigest &digest, CharBuffer address);
+
+        /**
+         * Add the address of data with a digest, unless the index already has one or is read-only
+         */
+        void insert(const ContentDigest &digest, std::string_view address);
+
+        /**
+         * Look up a digest in the current mapping
+         * @param stale Set if the chain of the digest runs past the mapping, which must then be remapped
+         * @return The length of the address, or zero if it was not found
+         */
+        size_t lookup(const ContentDigest &digest, CharBuffer address, bool &stale) const;
+
+        /**
+         * Map the whole file again, after it has grown
+         */
+        void remap();
+
+        AddressIndexOptions options_;
+        std::string path_;
+        int fd_ = -1;
+        unsigned char* data_ = nullptr;
+        size_t size_ = 0;
+        mutable std::shared_mutex mutex_;
+        std::atomic<uint64_t> hits_ = 0;
+        std::atomic<uint64_t> misses_ = 0;
+
+        friend class Engine;
+    };
+
+
+    /**
+     * The configuration of an engine
+     */
+    struct EngineOptions {
+        // The scheme used to pad short hexagons, Counter giving padding that is portable and faster to generate
+        PaddingScheme paddingScheme = DEFAULT_PADDING_SCHEME;
+        // The seed of the random generator used for coordinates and padding, drawn from std::random_device if not set
+        std::optional<uint64_t> seed;
+        // The number of bytes in each page, addresses are only searchable by engines with the same page length
+        size_t pageLen = MAX_PAGE_LEN;
+        // Creates the generator of the random bytes that pad data, a CounterPaddingGenerator if not set
+        PaddingGeneratorFactory paddingGenerator;
+        // The number of threads each page is encoded and decoded with, one per hardware thread if zero.  Pages are
+        // split into chunks of a few hundred KiB, so only pages longer than that are spread across threads.
+        size_t pageThreads = 1;
+        // The cache of searched pages, which may be shared between engines, or null to decode every search
+        std::shared_ptr<SearchCache> searchCache;
+        // The alphabet hexagons are written in, Base64Url giving addresses that are safe in URLs and file names
+        AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET;
+        // Whether addresses of data padded with zeros are zero-filled, leaving out the zero digits that end their
+        // hexagon so their length follows the data rather than the page.  Engines search both forms either way.
+        bool zeroFilledAddresses = false;
+        // The index of addresses already computed, which computeAddress() returns again for the same data when it is
+        // not padded randomly, or null to encode all data
+        std::shared_ptr<AddressIndex> addressIndex;
+    };
+
+
+    /**
+     * Computes and searches addresses while reusing its random generator and scratch buffers between calls.  An engine
+     * is not thread-safe, so each thread should use its own.  Once its buffers have grown to fit a page, computing
+     * addresses and searching into caller-owned outputs does not allocate.  The page length is chosen at runtime, see
+     * BasicEngine for engines whose page length is fixed at compile time.
+     */
+    class Engine {
+    public:
+        explicit Engine(const EngineOptions &options = EngineOptions());
+
+        Engine(Engine &&other) noexcept;
+        Engine &operator=(Engine &&other) noexcept;
+        ~Engine();
+
+        /**
+         * Get the configuration of this engine
+         */
+        [[nodiscard]] const EngineOptions &options() const { return options_; }
+
+        /**
+         * Get the number of bytes in the pages of this engine
+         */
+        [[nodiscard]] size_t pageLength() const { return options_.pageLen; }
+
+        /**
+         * Get the length below which this engine pads hexagons before searching them
+         */
+        [[nodiscard]] size_t minAddressLength() const { return Babel::minAddressLength(options_.pageLen); }
+
+        /**
+         * Get the size of a buffer that can hold any address computed by this engine
+         */
+        [[nodiscard]] size_t maxAddressLength() const { return Babel::maxAddressLength(options_.pageLen); }
+
+        /**
+         * Get the size of a buffer that can hold the address this engine computes for data of a given length, which
+         * is less than maxAddressLength() for zero-filled addresses
+         * @param dataLen The number of bytes of data
+         * @param padRandom Whether the data is padded with random bytes
+         */
+        [[nodiscard]] size_t maxAddressLength(size_t dataLen, bool padRandom) const;
+
+        /**
+         * Reseed the random generator and padding generator of this engine, so the coordinates and padding that follow
+         * are reproducible
+         * @param seed The new seed of the generators
+         */
+        void seed(uint64_t seed);
+
+        /**
+         * Generate a random integer in the range [1, maxValue], left-padded with zeros
+         * @param maxValue The maximum value of the random integer
+         * @return A random integer in the range [1, maxValue], left-padded with zeros
+         */
+        std::string genRandomPaddedInt(int maxValue);
+
+        /**
+         * Generate a random library coordinate
+         * @param coord The coordinate to write the wall, shelf, volume and page to
+         */
+        void genRandomLibraryCoordinate(LibraryCoordinate &coord);
+
+        /**
+         * Get the address of a given byte sequence
+         * @param data The data to get the address of
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @param address The string to write the address to, reusing its capacity
+         */
+        void computeAddress(const std::vector<unsigned char> &data, bool padRandom, std::string &address);
+
+        /**
+         * Get the address of a given byte sequence
+         * @param data The data to get the address of
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @return The address of the byte sequence
+         */
+        std::string computeAddress(const std::vector<unsigned char> &data, bool padRandom);
+
+        /**
+         * Get the address of a given byte sequence, encoding it straight from the caller's bytes into the caller's
+         * buffer.  Only random padding is generated into scratch space, a chunk at a time.
+         * @param data The data to get the address of
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @param address The buffer to write the address to, which must hold at least maxAddressLength(data.size(),
+         * padRandom) characters
+         * @return The number of characters in the address
+         * @throws std::length_error If the buffer is too small
+         */
+        size_t computeAddress(ByteView data, bool padRandom, CharBuffer address);
+
+        /**
+         * Compute the address of the data provided by a stream
+         * @param stream The stream to get data from
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @return The address of the stream's data
+         */
+        std::string computeStreamAddress(std::istream &stream, bool padRandom);
+
+        /**
+         * Compute the address of the data provided by a stream, writing the address out as the data is read.  The
+         * stream is read in fixed-size chunks, so memory use does not depend on the page length.  The only exception is
+         * random padding of a stream that cannot seek, which buffers up to a page of data to learn its length.
+         * @param stream The stream to get data from
+         * @param address The stream to write the address to
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         */
+        void computeStreamAddress(std::istream &stream, std::ostream &address, bool padRandom);
+
+        /**
+         * Search for a byte sequence by its address
+         * @param address The address to search for
+         * @param page The vector to write the byte sequence to, reusing its capacity
+         */
+        void search(const std::string &address, std::vector<unsigned char> &page);
+
+        /**
+         * Search for a byte sequence by its address
+         * @param address The address to search for
+         * @return The byte sequence at the given address
+         */
+        std::vector<unsigned char> search(const std::string &address);
+
+        /**
+         * Search for a byte sequence by its address, decoding it straight into the caller's buffer
+         * @param address The address to search for
+         * @param page The buffer to write the byte sequence to, which must hold at least pageLength() bytes
+         * @return The number of bytes written, always pageLength()
+         * @throws std::length_error If the buffer is too small
+         */
+        size_t search(std::string_view address, ByteBuffer page);
+
+        /**
+         * Search for a byte sequence by its address
+         * @param address The address to search for
+         * @param stream The stream to write the byte sequence to, chunk by chunk as the page is decoded
+         */
+        void searchStream(const std::string &address, std::ostream &stream);
+
+        /**
+         * Search for a byte sequence by its address, answering from the search cache when it holds the page.  Misses
+         * are decoded into a new page, which is added to the cache.
+         * @param address The address to search for
+         * @return The byte sequence at the given address, shared with the cache
+         */
+        SharedPage searchShared(std::string_view address);
+
+        /**
+         * Search for part of a byte sequence by its address.  Only the digits of the hexagon under the range are
+         * decoded, and only the padding digits under it are generated, so the cost follows the length of the range
+         * rather than the length of the page.  Cached pages are copied from the cache, but ranges are not cached.
+         * @param address The address to search for
+         * @param offset The index of the first byte to get, at most pageLength()
+         * @param length The number of bytes to get, fewer are returned if the range passes the end of the page
+         * @return The bytes of the range
+         * @throws std::out_of_range If the offset is past the end of the page
+         */
+        std::vector<unsigned char> searchRange(const std::string &address, size_t offset, size_t length);
+
+        /**
+         * Search for part of a byte sequence by its address, decoding it straight into the caller's buffer
+         * @param address The address to search for
+         * @param offset The index of the first byte to get, at most pageLength()
+         * @param range The buffer to fill with the bytes from the offset onwards
+         * @return The number of bytes written, fewer than the buffer holds if the range passes the end of the page
+         * @throws std::out_of_range If the offset is past the end of the page
+         */
+        size_t searchRange(std::string_view address, size_t offset, ByteBuffer range);
+
+        /**
+         * Search for part of a byte sequence by its address, writing it to a stream chunk by chunk as it is decoded
+         * @param address The address to search for
+         * @param offset The index of the first byte to write, at most pageLength()
+         * @param length The number of bytes to write, fewer are written if the range passes the end of the page
+         * @param stream The stream to write the bytes to
+         * @throws std::out_of_range If the offset is past the end of the page
+         */
+        void searchRangeStream(const std::string &address, size_t offset, size_t length, std::ostream &stream);
+
+        /**
+         * Get the address of the start of a file.  Up to a page of the file is mapped into memory and encoded straight
+         * from the mapping, so the data is never copied into a buffer.
+         * @param path The path of the file
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @return The address of the file's data
+         * @throws std::system_error If the file cannot be opened or mapped
+         */
+        std::string computeFileAddress(const std::string &path, bool padRandom);
+
+        /**
+         * Search for a byte sequence by its address, writing it to a file of pageLength() bytes.  The file is mapped
+         * into memory and the page is decoded straight into the mapping.  The address is checked before the file is
+         * touched, so an invalid address leaves any existing file as it was.
+         * @param address The address to search for
+         * @param path The path of the file to create or overwrite with the byte sequence
+         * @throws std::system_error If the file cannot be created or mapped
+         */
+        void searchToFile(const std::string &address, const std::string &path);
+
+    private:
+        /**
+         * Throw OperationCancelled if the work this engine is doing has been cancelled, called between chunks
+         */
+        void checkCancelled() const {
+            if (cancel_ != nullptr && cancel_->cancelled()) throw OperationCancelled();
+        }
+
+        /**
+         * Generate a random library coordinate as numbers, drawing the same values as genRandomLibraryCoordinate()
+         */
+        PackedCoordinate genRandomCoordinate();
+
+        /**
+         * Parse and fit an address, preparing a decoder for the page at it
+         */
+        HexagonDecoder pageDecoder(std::string_view address);
+
+        /**
+         * Parse an address, preparing a decoder that generates the padding of a short hexagon only where it is read
+         * @param address The address to search for
+         * @param padding Space for the padding of the hexagon, which must outlive the decoder
+         */
+        HexagonDecoder rangeDecoder(std::string_view address, std::optional<HexagonPadding> &padding);
+
+        /**
+         * Find the page at an address in the search cache
+         * @return The cached page, or null if there is no cache or it does not hold the page
+         */
+        SharedPage findCached(std::string_view address) const;
+
+        /**
+         * Check that a range starts within the page
+         * @return The number of bytes of the range within the page
+         */
+        size_t rangeLength(size_t offset, size_t length) const;
+
+        /**
+         * Decode the page at an address into a buffer of at least pageLength() bytes, bypassing the search cache
+         */
+        void decodePage(std::string_view address, unsigned char* page);
+
+        /**
+         * Encode the hexagon of data fitted to the page, without copying the data unless the page is spread across threads
+         * @return The number of digits in the hexagon
+         */
+        size_t encodeFitted(unsigned int coordSeed, ByteView data, bool padRandom, char* dst);
+
+        /**
+         * Encode the address of the data provided by a stream, passing the characters of the address to a sink
+         */
+        void streamAddress(std::istream &stream, bool padRandom, const std::function<void(const char*, size_t)> &sink);
+
+        /**
+         * Encode the hexagon of a page of a book, whose data starts the page
+         * @param coord The coordinate of the page
+         * @param page The page, holding dataLen bytes of data followed by space for the padding
+         * @param dataLen The number of bytes of data in the page, the rest is padded
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @param hexagon The buffer to write the hexagon to, which must hold at least maxHexagonLength() characters
+         * @return The number of characters in the hexagon
+         */
+        size_t encodeBookPage(const PackedCoordinate &coord, ByteBuffer page, size_t dataLen, bool padRandom,
+                              char* hexagon);
+
+        /**
+         * Decode a page of a book
+         * @param hexagon The hexagon of the page
+         * @param coord The coordinate of the page
+         * @param page The buffer to write the page to, which must hold at least pageLength() bytes
+         */
+        void searchBookPage(std::string_view hexagon, const PackedCoordinate &coord, ByteBuffer page);
+
+        friend class AsyncEngine;
+        friend class BatchEngine;
+
+        EngineOptions options_;
+        std::mt19937_64 rng_;
+        std::unique_ptr<PaddingGenerator> padding_;
+        std::vector<unsigned char> paddedData_;
+        std::vector<unsigned char> streamData_;
+        std::vector<unsigned char> chunk_;
+        std::vector<char> chars_;
+        std::vector<unsigned char> page_;
+        std::vector<unsigned char> high_;
+        std::string digits_;
+        std::unique_ptr<ThreadPool> pool_;
+        // The token of the asynchronous work this engine is doing, if any
+        const CancellationToken* cancel_ = nullptr;
+    };
+
+
+    /**
+     * An engine whose page length is fixed at compile time, so the page and address lengths are constant expressions
+     * @tparam PageLen The number of bytes in each page
+     */
+    template<size_t PageLen>
+    class BasicEngine : public Engine {
+        static_assert(PageLen > 0, "Pages must hold at least one byte");
+
+    public:
+        static constexpr size_t PAGE_LEN = PageLen;
+        static constexpr size_t MIN_ADDRESS_LEN = Babel::minAddressLength(PageLen);
+
+        explicit BasicEngine(EngineOptions options = EngineOptions()) : Engine(withPageLength(options)) {}
+
+    private:
+        static EngineOptions withPageLength(EngineOptions options) {
+            options.pageLen = PageLen;
+            return options;
+        }
+    };
+
+    using Engine512 = BasicEngine<512>;
+    using Engine4K = BasicEngine<1024 * 4>;
+    using Engine64K = BasicEngine<MAX_PAGE_LEN>;
+
+
+    /**
+     * The configuration of a batch engine
+     */
+    struct BatchOptions {
+        // The configuration of the engine of each worker
+        EngineOptions engine;
+        // The number of worker threads, one per hardware thread if zero
+        size_t threads = 0;
+    };
+
+
+    /**
+     * Computes and searches many addresses at once on a pool of worker threads, each with its own engine.  Workers
+     * steal items from each other as they run out, and results are written back in the order of the inputs.  A batch
+     * engine may be shared between threads, though their batches run one at a time.
+     */
+    class BatchEngine {
+    public:
+        explicit BatchEngine(const BatchOptions &options = BatchOptions());
+
+        ~BatchEngine();
+
+        /**
+         * Get the configuration of this batch engine
+         */
+        [[nodiscard]] const BatchOptions &options() const { return options_; }
+
+        /**
+         * Get the number of worker threads of this batch engine
+         */
+        [[nodiscard]] size_t threadCount() const { return engines_.size(); }
+
+        /**
+         * Get the addresses of many byte sequences.  When the engine options carry a seed, the address of the data at
+         * index i is the one an engine seeded with seed + i would compute, whichever worker computes it.
+         * @param data The data to get the addresses of
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @param addresses The vector to write the addresses to, in the same order as the data, reusing its capacity
+         */
+        void computeAddressBatch(const std::vector<std::vector<unsigned char>> &data, bool padRandom,
+                                 std::vector<std::string> &addresses);
+
+        /**
+         * Get the addresses of many byte sequences
+         * @param data The data to get the addresses of
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @return The addresses of the byte sequences, in the same order as the data
+         */
+        std::vector<std::string> computeAddressBatch(const std::vector<std::vector<unsigned char>> &data, bool padRandom);
+
+        /**
+         * Search for many byte sequences by their addresses
+         * @param addresses The addresses to search for
+         * @param pages The vector to write the byte sequences to, in the same order as the addresses, reusing its capacity
+         * @throws The first exception thrown by a search, once every other address has been searched
+         */
+        void searchBatch(const std::vector<std::string> &addresses, std::vector<std::vector<unsigned char>> &pages);
+
+        /**
+         * Search for many byte sequences by their addresses
+         * @param addresses The addresses to search for
+         * @return The byte sequences at the given addresses, in the same order as the addresses
+         */
+        std::vector<std::vector<unsigned char>> searchBatch(const std::vector<std::string> &addresses);
+
+        /**
+         * Get the addresses of the starts of many files, each encoded straight from a memory mapping of the file.  When
+         * the engine options carry a seed, the address of the file at index i is the one an engine seeded with seed + i
+         * would compute.
+         * @param paths The paths of the files
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @return The addresses of the files' data, in the same order as the paths
+         * @throws The first exception thrown for a file, once every other file has been addressed
+         */
+        std::vector<std::string> computeFileAddressBatch(const std::vector<std::string> &paths, bool padRandom);
+
+        /**
+         * Search for many byte sequences by their addresses, decoding each straight into a memory mapping of a file
+         * @param addresses The addresses to search for
+         * @param paths The paths of the files to write the byte sequences to, one per address
+         * @throws std::invalid_argument If there are not as many paths as addresses
+         * @throws The first exception thrown by a search, once every other address has been searched
+         */
+        void searchToFileBatch(const std::vector<std::string> &addresses, const std::vector<std::string> &paths);
+
+        /**
+         * Address data of any length as a book, a run of pages at consecutive library coordinates.  The data is read a
+         * window of pages at a time, whose pages are encoded in parallel and written out in order, so memory use does
+         * not depend on the length of the data.  The data fills each page from its start, and only the last page is
+         * padded.  Books longer than a hexagon holds wrap around to its first coordinate.  When the engine options
+         * carry a seed, the book is reproducible.
+         * @param data The stream to get the data from
+         * @param book The stream to write the hexagon of each page to, one per line
+         * @param padRandom Whether to pad the last page with random bytes, otherwise pad with zeros
+         * @return The manifest address of the book, book:length:wall:shelf:volume:page naming the length of the data
+         * and the coordinate of the first page
+         */
+        std::string computeBook(std::istream &data, std::ostream &book, bool padRandom);
+
+        /**
+         * Search for the data of a book, decoding a window of pages in parallel and writing them out in order
+         * @param manifest The manifest address of the book
+         * @param book The stream to read the hexagon of each page from, one per line
+         * @param data The stream to write the data to
+         * @throws std::invalid_argument If the manifest is malformed or the book has fewer pages than it names
+         */
+        void searchBook(const std::string &manifest, std::istream &book, std::ostream &data);
+
+    private:
+        BatchOptions options_;
+        std::vector<Engine> engines_;
+        std::unique_ptr<ThreadPool> pool_;
+    };
+
+
+    /**
+     * The configuration of an asynchronous engine
+     */
+    struct AsyncOptions {
+        // The configuration of the engine of each worker
+        EngineOptions engine;
+        // The number of worker threads, one per hardware thread if zero
+        size_t threads = 0;
+    };
+
+
+    /**
+     * Computes and searches addresses on its own worker threads, each with its own engine, handing results back as
+     * futures so callers such as event loops never block on the work.  Every operation takes a cancellation token,
+     * which is checked before the work starts and between chunks of the page, so abandoned work stops early and its
+     * future throws OperationCancelled.  Work still queued when the engine is destroyed is run before the workers stop.
+     */
+    class AsyncEngine {
+    public:
+        explicit AsyncEngine(const AsyncOptions &options = AsyncOptions());
+
+        ~AsyncEngine();
+
+        AsyncEngine(const AsyncEngine&) = delete;
+        AsyncEngine& operator=(const AsyncEngine&) = delete;
+
+        /**
+         * Get the configuration of this asynchronous engine
+         */
+        [[nodiscard]] const AsyncOptions &options() const { return options_; }
+
+        /**
+         * Get the number of worker threads of this asynchronous engine
+         */
+        [[nodiscard]] size_t threadCount() const;
+
+        /**
+         * Get the address of a given byte sequence.  When the engine options carry a seed, the nth address computed is
+         * the one an engine seeded with seed + n would compute.
+         * @param data The data to get the address of
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @param token The token to cancel the computation with
+         * @return The future address of the byte sequence
+         */
+        std::future<std::string> computeAddress(std::vector<unsigned char> data, bool padRandom,
+                                                CancellationToken token = CancellationToken());
+
+        /**
+         * Compute the address of the data provided by a stream
+         * @param stream The stream to get data from, which must outlive the future
+         * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+         * @param token The token to cancel the computation with
+         * @return The future address of the stream's data
+         */
+        std::future<std::string> computeStreamAddress(std::istream &stream, bool padRandom,
+                                                      CancellationToken token = CancellationToken());
+
+        /**
+         * Search for a byte sequence by its address
+         * @param address The address to search for
+         * @param token The token to cancel the search with
+         * @return The future byte sequence at the given address
+         */
+        std::future<std::vector<unsigned char>> search(std::string address, CancellationToken token = CancellationToken());
+
+        /**
+         * Search for a byte sequence by its address, writing it to a stream chunk by chunk
+         * @param address The address to search for
+         * @param stream The stream to write the byte sequence to, which must outlive the future
+         * @param token The token to cancel the search with
+         * @return A future that is ready once the byte sequence has been written
+         */
+        std::future<void> searchStream(std::string address, std::ostream &stream,
+                                       CancellationToken token = CancellationToken());
+
+    private:
+        /**
+         * Queue work for a worker, which runs it on its engine while watching the token
+         * @param token The token of the work
+         * @param seeded Whether the work computes an address, which is reseeded by its position when seeds are set
+         * @param work The work, given the engine of the worker running it
+         * @return The future result of the work
+         */
+        template<typename Result, typename Work>
+        std::future<Result> submit(const CancellationToken &token, bool seeded, Work work);
+
+        AsyncOptions options_;
+        std::vector<Engine> engines_;
+        std::atomic<uint64_t> submitted_{0};
+        std::unique_ptr<TaskQueue> queue_;
+    };
 }
 
 #endif //BABEL_ENGINE_LIBRARY_H
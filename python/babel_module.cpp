@@ -0,0 +1,513 @@
+//
+// The Python extension module of the library, which releases the GIL while pages are encoded and decoded
+//
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "babel_engine.h"
+
+
+using namespace Babel;
+
+
+// The bytes a Python stream is read or written in at a time
+constexpr size_t PY_STREAM_CHUNK_LEN = 1024 * 64;
+
+
+/**
+ * Raise the Python exception matching a C++ exception
+ */
+void raiseException(const std::exception& e) {
+    if (dynamic_cast<const std::system_error*>(&e)) PyErr_SetString(PyExc_OSError, e.what());
+    else if (dynamic_cast<const std::logic_error*>(&e)) PyErr_SetString(PyExc_ValueError, e.what());
+    else PyErr_SetString(PyExc_RuntimeError, e.what());
+}
+
+
+/**
+ * Run a call with the GIL released, translating any C++ exception into a Python one
+ * @return Whether the call succeeded, and otherwise a Python exception is set
+ */
+template<typename Call>
+bool withoutGIL(const Call& call) {
+    std::exception_ptr error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        call();
+    } catch (...) {
+        // The exception is raised once the GIL is held again
+        error = std::current_exception();
+    }
+    Py_END_ALLOW_THREADS
+    if (!error) return true;
+
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+        raiseException(e);
+    } catch (...) {
+        PyErr_SetString(PyExc_RuntimeError, "Unknown error");
+    }
+    return false;
+}
+
+
+/**
+ * Get a padding scheme from its Python value
+ * @return Whether the value names a scheme, and otherwise a Python exception is set
+ */
+bool toPaddingScheme(const int value, PaddingScheme& scheme) {
+    if (value != static_cast<int>(PaddingScheme::Legacy) && value != static_cast<int>(PaddingScheme::Counter)) {
+        PyErr_Format(PyExc_ValueError, "Invalid padding scheme: %d", value);
+        return false;
+    }
+    scheme = static_cast<PaddingScheme>(value);
+    return true;
+}
+
+
+/**
+ * The bytes of a Python object that supports the buffer protocol, held for as long as this lives
+ */
+class BufferArg {
+public:
+    BufferArg() = default;
+    ~BufferArg() { if (held_) PyBuffer_Release(&view_); }
+
+    BufferArg(const BufferArg&) = delete;
+    BufferArg& operator=(const BufferArg&) = delete;
+
+    /**
+     * Hold the bytes of an object, which must be contiguous
+     * @return Whether the object supports the buffer protocol, and otherwise a Python exception is set
+     */
+    bool hold(PyObject* object) {
+        held_ = PyObject_GetBuffer(object, &view_, PyBUF_C_CONTIGUOUS) == 0;
+        return held_;
+    }
+
+    [[nodiscard]] ByteView bytes() const { return {static_cast<const unsigned char*>(view_.buf), static_cast<size_t>(view_.len)}; }
+
+private:
+    Py_buffer view_{};
+    bool held_ = false;
+};
+
+
+/**
+ * The characters of an address given as a str or as any object that supports the buffer protocol
+ */
+class AddressArg {
+public:
+    /**
+     * @return Whether the object is an address, and otherwise a Python exception is set
+     */
+    bool hold(PyObject* object) {
+        if (PyUnicode_Check(object)) {
+            // The UTF-8 form of a str is cached on the str, so the address is not copied
+            Py_ssize_t len;
+            const char* chars = PyUnicode_AsUTF8AndSize(object, &len);
+            if (chars == nullptr) return false;
+            address_ = std::string_view(chars, static_cast<size_t>(len));
+            return true;
+        }
+        if (!buffer_.hold(object)) return false;
+        const ByteView bytes = buffer_.bytes();
+        address_ = std::string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        return true;
+    }
+
+    [[nodiscard]] std::string_view view() const { return address_; }
+
+private:
+    BufferArg buffer_;
+    std::string_view address_;
+};
+
+
+/**
+ * Hands a failed Python call from a stream buffer back to the thread that raises it, since the calls of the buffer run
+ * while the GIL is released and their errors cannot stay set
+ */
+class PythonError {
+public:
+    ~PythonError() {
+        Py_XDECREF(type_);
+        Py_XDECREF(value_);
+        Py_XDECREF(traceback_);
+    }
+
+    /**
+     * Take the error set by the failed call, if no earlier error was taken.  The GIL must be held.
+     */
+    void fetch() {
+        if (type_ == nullptr) PyErr_Fetch(&type_, &value_, &traceback_);
+        else PyErr_Clear();
+    }
+
+    /**
+     * Set the taken error again, if any, in place of any error raised since.  The GIL must be held.
+     * @return Whether an error was set
+     */
+    bool restore() {
+        if (type_ == nullptr) return false;
+        PyErr_Clear();
+        PyErr_Restore(type_, value_, traceback_);
+        type_ = value_ = traceback_ = nullptr;
+        return true;
+    }
+
+private:
+    PyObject* type_ = nullptr;
+    PyObject* value_ = nullptr;
+    PyObject* traceback_ = nullptr;
+};
+
+
+/**
+ * Release a memoryview, so that a reference kept to it raises rather than reaching the memory it wrapped.  The GIL must
+ * be held, and an error already set is kept.
+ * @return Whether the view was released, and otherwise the error of the release is set in place of any earlier one
+ */
+bool releaseView(PyObject* view) {
+    PyObject* type;
+    PyObject* value;
+    PyObject* traceback;
+    PyErr_Fetch(&type, &value, &traceback);
+    PyObject* released = PyObject_CallMethod(view, "release", nullptr);
+    if (released == nullptr) {
+        Py_XDECREF(type);
+        Py_XDECREF(value);
+        Py_XDECREF(traceback);
+        return false;
+    }
+    Py_DECREF(released);
+    PyErr_Restore(type, value, traceback);
+    return true;
+}
+
+
+/**
+ * A stream buffer that reads from a Python binary stream, taking the GIL only while the stream is read
+ */
+class PythonInputBuffer : public std::streambuf {
+public:
+    PythonInputBuffer(PyObject* stream, PythonError& error) : stream_(stream), error_(error) {}
+
+protected:
+    int_type underflow() override {
+        if (gptr() < egptr()) return traits_type::to_int_type(*gptr());
+
+        const PyGILState_STATE state = PyGILState_Ensure();
+        Py_ssize_t got = -1;
+        // Streams that can read into a buffer do so without an intermediate bytes object
+        PyObject* view = PyMemoryView_FromMemory(buffer_, sizeof(buffer_), PyBUF_WRITE);
+        PyObject* result = view ? PyObject_CallMethod(stream_, "readinto", "O", view) : nullptr;
+        // The view wraps this buffer, which a stream that kept the view must not reach once the read returns
+        if (view != nullptr && !releaseView(view)) Py_CLEAR(result);
+        Py_XDECREF(view);
+        if (result == nullptr && PyErr_ExceptionMatches(PyExc_AttributeError)) {
+            PyErr_Clear();
+            result = PyObject_CallMethod(stream_, "read", "n", static_cast<Py_ssize_t>(sizeof(buffer_)));
+            if (result != nullptr && PyBytes_Check(result)) {
+                got = std::min(PyBytes_GET_SIZE(result), static_cast<Py_ssize_t>(sizeof(buffer_)));
+                std::memcpy(buffer_, PyBytes_AS_STRING(result), static_cast<size_t>(got));
+            } else if (result != nullptr) {
+                PyErr_SetString(PyExc_TypeError, "Streams must read bytes");
+            }
+        } else if (result != nullptr) {
+            // A non-blocking stream with nothing to read gives None, which ends the data like an empty read
+            got = result == Py_None ? 0 : std::min(PyLong_AsSsize_t(result), static_cast<Py_ssize_t>(sizeof(buffer_)));
+        }
+        Py_XDECREF(result);
+        if (got < 0 || PyErr_Occurred()) {
+            error_.fetch();
+            got = 0;
+        }
+        PyGILState_Release(state);
+
+        setg(buffer_, buffer_, buffer_ + got);
+        return got == 0 ? traits_type::eof() : traits_type::to_int_type(buffer_[0]);
+    }
+
+private:
+    PyObject* stream_;
+    PythonError& error_;
+    char buffer_[PY_STREAM_CHUNK_LEN];
+};
+
+
+/**
+ * A stream buffer that writes to a Python binary stream, taking the GIL only while the stream is written
+ */
+class PythonOutputBuffer : public std::streambuf {
+public:
+    PythonOutputBuffer(PyObject* stream, PythonError& error) : stream_(stream), error_(error) {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+protected:
+    int_type overflow(const int_type c) override {
+        if (sync() != 0) return traits_type::eof();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* data, const std::streamsize len) override {
+        // Writes longer than the buffer go straight to the stream
+        if (len >= static_cast<std::streamsize>(sizeof(buffer_))) {
+            if (sync() != 0 || !write(data, static_cast<size_t>(len))) return 0;
+            return len;
+        }
+        return std::streambuf::xsputn(data, len);
+    }
+
+    int sync() override {
+        const auto len = static_cast<size_t>(pptr() - pbase());
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        return len == 0 || write(buffer_, len) ? 0 : -1;
+    }
+
+private:
+    /**
+     * Write bytes to the stream, repeating the write until raw streams have taken all of them
+     */
+    bool write(const char* data, size_t len) {
+        const PyGILState_STATE state = PyGILState_Ensure();
+        bool ok = true;
+        while (len > 0 && ok) {
+            // The bytes are copied, so the stream may keep them after the buffer is reused
+            PyObject* result = PyObject_CallMethod(stream_, "write", "y#", data, static_cast<Py_ssize_t>(len));
+            const Py_ssize_t written = result == nullptr ? -1 : result == Py_None ? static_cast<Py_ssize_t>(len) : PyLong_AsSsize_t(result);
+            Py_XDECREF(result);
+            if (written <= 0 || PyErr_Occurred()) {
+                if (!PyErr_Occurred()) PyErr_SetString(PyExc_OSError, "The stream took no bytes");
+                error_.fetch();
+                ok = false;
+                break;
+            }
+            data += written;
+            len -= static_cast<size_t>(std::min(written, static_cast<Py_ssize_t>(len)));
+        }
+        PyGILState_Release(state);
+        return ok;
+    }
+
+    PyObject* stream_;
+    PythonError& error_;
+    char buffer_[PY_STREAM_CHUNK_LEN];
+};
+
+
+PyObject* computeAddressPy(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"data", "pad_random", nullptr};
+    PyObject* dataObject;
+    int padRandom = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|p", const_cast<char**>(keywords), &dataObject, &padRandom)) return nullptr;
+
+    BufferArg data;
+    if (!data.hold(dataObject)) return nullptr;
+
+    // The address is written straight into a new str, which is shrunk to fit once its length is known
+    PyObject* address = PyUnicode_New(static_cast<Py_ssize_t>(MAX_ADDRESS_LEN), 127);
+    if (address == nullptr) return nullptr;
+    const CharBuffer chars(static_cast<char*>(PyUnicode_DATA(address)), MAX_ADDRESS_LEN);
+    size_t len = 0;
+    if (!withoutGIL([&] { len = computeAddress(data.bytes(), padRandom != 0, chars); })) {
+        Py_DECREF(address);
+        return nullptr;
+    }
+    if (PyUnicode_Resize(&address, static_cast<Py_ssize_t>(len)) != 0) return nullptr;
+    return address;
+}
+
+
+PyObject* searchPy(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"address", "scheme", nullptr};
+    PyObject* addressObject;
+    int schemeValue = static_cast<int>(DEFAULT_PADDING_SCHEME);
+    PaddingScheme scheme;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|i", const_cast<char**>(keywords), &addressObject, &schemeValue) ||
+        !toPaddingScheme(schemeValue, scheme))
+        return nullptr;
+
+    AddressArg address;
+    if (!address.hold(addressObject)) return nullptr;
+
+    // The page is decoded straight into a new bytes object, which no other code can see until it is returned
+    PyObject* page = PyBytes_FromStringAndSize(nullptr, MAX_PAGE_LEN);
+    if (page == nullptr) return nullptr;
+    const ByteBuffer bytes(reinterpret_cast<unsigned char*>(PyBytes_AS_STRING(page)), MAX_PAGE_LEN);
+    if (!withoutGIL([&] { search(address.view(), bytes, scheme); })) {
+        Py_DECREF(page);
+        return nullptr;
+    }
+
+    PyObject* view = PyMemoryView_FromObject(page);
+    Py_DECREF(page);
+    return view;
+}
+
+
+// The type of the named tuples returned by get_address_components()
+PyTypeObject* coordinateType = nullptr;
+
+PyStructSequence_Field coordinateFields[] = {
+    {"hexagon", "The hexagon that encodes the page"},
+    {"wall", "The wall of the page within its hexagon"},
+    {"shelf", "The shelf of the page within its wall"},
+    {"volume", "The volume of the page within its shelf"},
+    {"page", "The page within its volume"},
+    {nullptr, nullptr}
+};
+
+PyStructSequence_Desc coordinateDesc = {"babel.LibraryCoordinate", "The components of an address", coordinateFields, 5};
+
+
+PyObject* getAddressComponentsPy(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"address", nullptr};
+    PyObject* addressObject;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O", const_cast<char**>(keywords), &addressObject)) return nullptr;
+
+    AddressArg address;
+    if (!address.hold(addressObject)) return nullptr;
+
+    LibraryCoordinate coordinate;
+    const std::string addressText(address.view());
+    if (!withoutGIL([&] { coordinate = getAddressComponents(addressText); })) return nullptr;
+
+    PyObject* result = PyStructSequence_New(coordinateType);
+    if (result == nullptr) return nullptr;
+    const std::string* components[] = {&coordinate.hexagon, &coordinate.wall, &coordinate.shelf, &coordinate.volume, &coordinate.page};
+    for (Py_ssize_t i = 0; i < 5; ++i) {
+        PyObject* component = PyUnicode_FromStringAndSize(components[i]->data(), static_cast<Py_ssize_t>(components[i]->size()));
+        if (component == nullptr) {
+            Py_DECREF(result);
+            return nullptr;
+        }
+        PyStructSequence_SET_ITEM(result, i, component);
+    }
+    return result;
+}
+
+
+PyObject* computeStreamAddressPy(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"stream", "pad_random", nullptr};
+    PyObject* streamObject;
+    int padRandom = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|p", const_cast<char**>(keywords), &streamObject, &padRandom)) return nullptr;
+
+    PythonError error;
+    PythonInputBuffer buffer(streamObject, error);
+    std::istream stream(&buffer);
+    std::string address;
+    const bool ok = withoutGIL([&] { address = computeStreamAddress(stream, padRandom != 0); });
+    // An error of the stream comes first, since the library only saw it as the data ending early
+    if (error.restore()) return nullptr;
+    if (!ok) return nullptr;
+    return PyUnicode_FromStringAndSize(address.data(), static_cast<Py_ssize_t>(address.size()));
+}
+
+
+PyObject* searchStreamPy(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"address", "stream", "scheme", nullptr};
+    PyObject* addressObject;
+    PyObject* streamObject;
+    int schemeValue = static_cast<int>(DEFAULT_PADDING_SCHEME);
+    PaddingScheme scheme;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|i", const_cast<char**>(keywords), &addressObject, &streamObject,
+                                     &schemeValue) || !toPaddingScheme(schemeValue, scheme))
+        return nullptr;
+
+    AddressArg address;
+    if (!address.hold(addressObject)) return nullptr;
+
+    PythonError error;
+    PythonOutputBuffer buffer(streamObject, error);
+    std::ostream stream(&buffer);
+    const std::string addressText(address.view());
+    const bool ok = withoutGIL([&] {
+        searchStream(addressText, stream, scheme);
+        stream.flush();
+    });
+    if (error.restore()) return nullptr;
+    if (!ok) return nullptr;
+    Py_RETURN_NONE;
+}
+
+
+/**
+ * Get the entry of a function taking keyword arguments in a method table, which holds functions of another type
+ */
+PyCFunction keywordFunction(const PyCFunctionWithKeywords function) {
+    return reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(function));
+}
+
+
+PyMethodDef methods[] = {
+    {"compute_address", keywordFunction(computeAddressPy), METH_VARARGS | METH_KEYWORDS,
+     "compute_address(data, pad_random=False) -> str\n\n"
+     "Assign an address to the bytes of any object that supports the buffer protocol."},
+    {"search", keywordFunction(searchPy), METH_VARARGS | METH_KEYWORDS,
+     "search(address, scheme=PADDING_LEGACY) -> memoryview\n\n"
+     "Retrieve the page of an address, given as a str or bytes, as a read-only view of a new bytes object."},
+    {"get_address_components", keywordFunction(getAddressComponentsPy), METH_VARARGS | METH_KEYWORDS,
+     "get_address_components(address) -> LibraryCoordinate\n\n"
+     "Split an address into its hexagon, wall, shelf, volume and page."},
+    {"compute_stream_address", keywordFunction(computeStreamAddressPy), METH_VARARGS | METH_KEYWORDS,
+     "compute_stream_address(stream, pad_random=False) -> str\n\n"
+     "Assign an address to the bytes read from a binary stream until it ends."},
+    {"search_stream", keywordFunction(searchStreamPy), METH_VARARGS | METH_KEYWORDS,
+     "search_stream(address, stream, scheme=PADDING_LEGACY) -> None\n\n"
+     "Write the page of an address to a binary stream as it is decoded."},
+    {nullptr, nullptr, 0, nullptr}
+};
+
+
+PyModuleDef moduleDef = {
+    PyModuleDef_HEAD_INIT, "babel",
+    "Assigns addresses to sequences of bytes and retrieves the bytes from their addresses.  Pages are encoded and "
+    "decoded with the GIL released, so threads scale across cores.",
+    -1, methods, nullptr, nullptr, nullptr, nullptr
+};
+
+
+PyMODINIT_FUNC PyInit_babel() {
+    PyObject* module = PyModule_Create(&moduleDef);
+    if (module == nullptr) return nullptr;
+
+    if (coordinateType == nullptr) coordinateType = PyStructSequence_NewType(&coordinateDesc);
+    if (coordinateType == nullptr) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    Py_INCREF(coordinateType);
+    if (PyModule_AddObject(module, "LibraryCoordinate", reinterpret_cast<PyObject*>(coordinateType)) != 0) {
+        Py_DECREF(coordinateType);
+        Py_DECREF(module);
+        return nullptr;
+    }
+    if (PyModule_AddIntConstant(module, "MAX_PAGE_LEN", MAX_PAGE_LEN) != 0 ||
+        PyModule_AddIntConstant(module, "MAX_ADDRESS_LEN", static_cast<long>(MAX_ADDRESS_LEN)) != 0 ||
+        PyModule_AddIntConstant(module, "PADDING_LEGACY", static_cast<long>(PaddingScheme::Legacy)) != 0 ||
+        PyModule_AddIntConstant(module, "PADDING_COUNTER", static_cast<long>(PaddingScheme::Counter)) != 0) {
+        Py_DECREF(module);
+        return nullptr;
+    }
+    return module;
+}
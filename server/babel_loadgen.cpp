@@ -0,0 +1,309 @@
+//
+// Measures the throughput and latency of a babel_server under a steady load of pipelined requests
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "protocol.h"
+#include "stats.h"
+
+
+using namespace Babel::Protocol;
+using Babel::percentile;
+using Clock = std::chrono::steady_clock;
+
+
+/**
+ * The configuration of a load run, taken from the command line
+ */
+struct LoadOptions {
+    // The endpoint of the server
+    std::string endpoint = "unix:/tmp/babel.sock";
+    // The number of connections, each driven by its own thread
+    size_t connections = 4;
+    // The number of requests each connection keeps in flight
+    size_t depth = 8;
+    // The time spent sending requests
+    std::chrono::milliseconds duration{2000};
+    // The operation requested
+    Op op = Op::Search;
+    // The number of bytes of data each address is computed for
+    size_t payloadLen = 1024;
+    // The number of distinct addresses searched, which are computed before the run
+    size_t addresses = 64;
+    // Whether computed data is padded randomly
+    bool padRandom = false;
+    // The number of bytes of each range searched
+    size_t rangeLen = 4096;
+};
+
+
+/**
+ * The measurements of a connection
+ */
+struct LoadResult {
+    size_t requests = 0;
+    size_t errors = 0;
+    size_t bytes = 0;
+    std::vector<double> latencies;
+};
+
+
+/**
+ * Write every byte of a buffer to a blocking socket
+ */
+void writeFully(const int fd, const unsigned char* data, size_t len) {
+    while (len > 0) {
+        const ssize_t written = send(fd, data, len, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "Could not send request");
+        }
+        data += written;
+        len -= static_cast<size_t>(written);
+    }
+}
+
+
+/**
+ * Read exactly the length of a buffer from a blocking socket
+ */
+void readFully(const int fd, unsigned char* data, size_t len) {
+    while (len > 0) {
+        const ssize_t got = recv(fd, data, len, 0);
+        if (got == 0) throw std::runtime_error("The server closed the connection");
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "Could not read response");
+        }
+        data += got;
+        len -= static_cast<size_t>(got);
+    }
+}
+
+
+/**
+ * Build a request frame
+ */
+std::vector<unsigned char> makeRequest(const uint32_t id, const Op op, const uint8_t flags, const std::vector<unsigned char>& payload) {
+    std::vector<unsigned char> frame(HEADER_LEN + payload.size());
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(payload.size());
+    header.id = id;
+    header.code = static_cast<uint8_t>(op);
+    header.flags = flags;
+    writeHeader(frame.data(), header);
+    std::copy(payload.begin(), payload.end(), frame.begin() + HEADER_LEN);
+    return frame;
+}
+
+
+/**
+ * Read a response frame
+ * @param payload Set to the payload of the response
+ * @return The header of the response
+ */
+FrameHeader readResponse(const int fd, std::vector<unsigned char>& payload) {
+    unsigned char headerBytes[HEADER_LEN];
+    readFully(fd, headerBytes, HEADER_LEN);
+    const FrameHeader header = readHeader(headerBytes);
+    payload.resize(header.length);
+    readFully(fd, payload.data(), payload.size());
+    return header;
+}
+
+
+/**
+ * Compute the addresses searched during the run, one request at a time
+ * @param data The data the addresses are computed for
+ * @return The address of each piece of data
+ */
+std::vector<std::string> computeAddresses(const LoadOptions& options, const std::vector<std::vector<unsigned char>>& data) {
+    const int fd = openSocket(parseEndpoint(options.endpoint), false);
+    std::vector<std::string> addresses;
+    std::vector<unsigned char> payload;
+    for (size_t i = 0; i < data.size(); ++i) {
+        const std::vector<unsigned char> frame = makeRequest(static_cast<uint32_t>(i), Op::Compute, 0, data[i]);
+        writeFully(fd, frame.data(), frame.size());
+        const FrameHeader header = readResponse(fd, payload);
+        if (header.code != static_cast<uint8_t>(Status::Ok)) {
+            close(fd);
+            throw std::runtime_error("Could not compute an address: "+std::string(payload.begin(), payload.end()));
+        }
+        addresses.emplace_back(payload.begin(), payload.end());
+    }
+    close(fd);
+    return addresses;
+}
+
+
+/**
+ * Keep a number of requests in flight on a connection until the end of the run, then wait for the last of them
+ * @param data The data of each address
+ * @param addresses The addresses searched
+ */
+LoadResult drive(const LoadOptions& options, const std::vector<std::vector<unsigned char>>& data,
+                 const std::vector<std::string>& addresses, const size_t connection, const Clock::time_point end) {
+    const int fd = openSocket(parseEndpoint(options.endpoint), false);
+    LoadResult result;
+    std::unordered_map<uint32_t, std::pair<Clock::time_point, size_t>> inFlight;
+    std::vector<unsigned char> payload;
+    uint32_t nextId = 0;
+
+    // Each connection starts at its own item, so connections do not request the same items in lockstep
+    const auto send = [&] {
+        const size_t item = (connection * 7 + nextId) % data.size();
+        std::vector<unsigned char> request;
+        if (options.op == Op::Compute) {
+            request = data[item];
+        } else {
+            const std::string& address = addresses[item];
+            if (options.op == Op::SearchRange) {
+                request.resize(RANGE_PREFIX_LEN);
+                storeBigEndian64(request.data(), 0);
+                storeBigEndian64(request.data() + 8, options.rangeLen);
+            }
+            request.insert(request.end(), address.begin(), address.end());
+        }
+        const uint8_t flags = options.op == Op::Compute && options.padRandom ? FLAG_PAD_RANDOM : 0;
+        const std::vector<unsigned char> frame = makeRequest(nextId, options.op, flags, request);
+        inFlight[nextId++] = {Clock::now(), item};
+        writeFully(fd, frame.data(), frame.size());
+    };
+
+    try {
+        for (size_t i = 0; i < options.depth; ++i) send();
+        while (!inFlight.empty()) {
+            const FrameHeader header = readResponse(fd, payload);
+            const Clock::time_point now = Clock::now();
+            const auto it = inFlight.find(header.id);
+            if (it == inFlight.end()) throw std::runtime_error("Got a response to an unknown request: "+std::to_string(header.id));
+            result.latencies.push_back(std::chrono::duration<double, std::nano>(now - it->second.first).count());
+            result.requests++;
+            result.bytes += options.op == Op::Compute ? data[it->second.second].size() : payload.size();
+
+            // Searched pages start with the data their address was computed for
+            const std::vector<unsigned char>& expected = data[it->second.second];
+            const size_t checkLen = std::min(expected.size(), payload.size());
+            if (header.code != static_cast<uint8_t>(Status::Ok) ||
+                (options.op != Op::Compute && !std::equal(expected.begin(), expected.begin() + static_cast<long>(checkLen), payload.begin())))
+                result.errors++;
+
+            inFlight.erase(it);
+            if (now < end) send();
+        }
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+    return result;
+}
+
+
+/**
+ * Print the usage of the load generator and exit
+ */
+[[noreturn]] void exitWithUsage(const char* program, const int status) {
+    std::cerr << "Usage: " << program << " [--connect unix:PATH|tcp:PORT] [--connections N] [--depth N] [--duration-ms N]"
+              << " [--op compute|search|range] [--payload-len N] [--addresses N] [--range-len N] [--pad-random]" << std::endl;
+    std::exit(status);
+}
+
+
+/**
+ * Parse the command line into the configuration of the run
+ */
+LoadOptions parseArgs(const int argc, char** argv) {
+    LoadOptions options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--connect" && hasValue) options.endpoint = argv[++i];
+            else if (arg == "--connections" && hasValue) options.connections = std::max(1ul, std::stoul(argv[++i]));
+            else if (arg == "--depth" && hasValue) options.depth = std::max(1ul, std::stoul(argv[++i]));
+            else if (arg == "--duration-ms" && hasValue) options.duration = std::chrono::milliseconds(std::stoul(argv[++i]));
+            else if (arg == "--payload-len" && hasValue) options.payloadLen = std::max(1ul, std::stoul(argv[++i]));
+            else if (arg == "--addresses" && hasValue) options.addresses = std::max(1ul, std::stoul(argv[++i]));
+            else if (arg == "--range-len" && hasValue) options.rangeLen = std::stoul(argv[++i]);
+            else if (arg == "--pad-random") options.padRandom = true;
+            else if (arg == "--op" && hasValue && std::string(argv[i + 1]) == "compute") options.op = Op::Compute, ++i;
+            else if (arg == "--op" && hasValue && std::string(argv[i + 1]) == "search") options.op = Op::Search, ++i;
+            else if (arg == "--op" && hasValue && std::string(argv[i + 1]) == "range") options.op = Op::SearchRange, ++i;
+            else exitWithUsage(argv[0], arg == "--help" ? 0 : 1);
+        }
+    } catch (const std::exception&) {
+        // A value that is not a number, or is too large for one
+        exitWithUsage(argv[0], 1);
+    }
+    return options;
+}
+
+
+int main(const int argc, char** argv) {
+    const LoadOptions options = parseArgs(argc, argv);
+
+    std::mt19937_64 random(42);
+    std::vector<std::vector<unsigned char>> data(options.addresses, std::vector<unsigned char>(options.payloadLen));
+    for (std::vector<unsigned char>& item : data)
+        for (unsigned char& byte : item) byte = static_cast<unsigned char>(random());
+
+    std::vector<LoadResult> results(options.connections);
+    std::atomic<bool> failed{false};
+    Clock::time_point start;
+    try {
+        const std::vector<std::string> addresses = options.op == Op::Compute ? std::vector<std::string>() : computeAddresses(options, data);
+
+        start = Clock::now();
+        const Clock::time_point end = start + options.duration;
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < options.connections; ++i) {
+            threads.emplace_back([&, i] {
+                try {
+                    results[i] = drive(options, data, addresses, i, end);
+                } catch (const std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                    failed = true;
+                }
+            });
+        }
+        for (std::thread& thread : threads) thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    LoadResult total;
+    for (LoadResult& result : results) {
+        total.requests += result.requests;
+        total.errors += result.errors;
+        total.bytes += result.bytes;
+        total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+    }
+    std::sort(total.latencies.begin(), total.latencies.end());
+
+    std::cout << std::left << std::setw(14) << "requests" << std::setw(10) << "errors" << std::right
+              << std::setw(14) << "req/s" << std::setw(12) << "MB/s" << std::setw(12) << "p50 us"
+              << std::setw(12) << "p90 us" << std::setw(12) << "p99 us" << std::setw(12) << "max us" << std::endl;
+    std::cout << std::left << std::setw(14) << total.requests << std::setw(10) << total.errors << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << static_cast<double>(total.requests) / seconds
+              << std::setw(12) << static_cast<double>(total.bytes) / seconds / 1e6
+              << std::setw(12) << percentile(total.latencies, 50) / 1e3 << std::setw(12) << percentile(total.latencies, 90) / 1e3
+              << std::setw(12) << percentile(total.latencies, 99) / 1e3
+              << std::setw(12) << (total.latencies.empty() ? 0 : total.latencies.back()) / 1e3 << std::endl;
+    return failed || total.errors > 0 ? 1 : 0;
+}
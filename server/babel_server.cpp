@@ -0,0 +1,693 @@
+//
+// Serves address computations and searches to local clients over the length-prefixed protocol of protocol.h
+//
+
+#include <algorithm>
+#include <iterator>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/uio.h>
+
+#include "babel_engine.h"
+#include "protocol.h"
+#include "task_queue.h"
+
+
+using namespace Babel;
+using namespace Babel::Protocol;
+
+
+// The epoll tags of the descriptors that are not connections, which are tagged with ids from FIRST_CONNECTION
+constexpr uint64_t WAKE_TAG = 0;
+constexpr uint64_t SIGNAL_TAG = 1;
+constexpr uint64_t FIRST_LISTENER = 2;
+constexpr uint64_t FIRST_CONNECTION = 1 << 16;
+
+// The bytes read from a connection at a time
+constexpr size_t READ_CHUNK_LEN = 1024 * 64;
+// The most buffers written to a connection in one call
+constexpr int MAX_WRITE_BUFFERS = 64;
+
+
+/**
+ * The configuration of the server, taken from the command line
+ */
+struct ServerOptions {
+    // The endpoints to listen on
+    std::vector<std::string> endpoints;
+    // The number of worker threads, one per hardware thread if zero
+    size_t threads = 0;
+    // The number of bytes in each page
+    size_t pageLen = MAX_PAGE_LEN;
+    // The most requests a worker takes at once
+    size_t batchLen = 32;
+    // The most megabytes of pages kept in the search cache shared by the workers, or zero for no cache
+    size_t cacheMb = 256;
+    // The path of the address index shared by the workers, if any
+    std::string indexPath;
+    // Whether addresses of data padded with zeros are zero-filled
+    bool zeroFilled = false;
+    // The alphabet addresses are computed in and searched in
+    AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET;
+    // The scheme short hexagons are padded with when a request names none
+    PaddingScheme paddingScheme = DEFAULT_PADDING_SCHEME;
+    // The most requests of a connection being worked on before the server stops reading from it
+    size_t maxInFlight = 256;
+};
+
+
+/**
+ * A request read from a connection, waiting for a worker
+ */
+struct Request {
+    uint64_t connection = 0;
+    FrameHeader header;
+    std::vector<unsigned char> payload;
+};
+
+
+/**
+ * A response waiting to be written to its connection
+ */
+struct Response {
+    unsigned char header[HEADER_LEN] = {};
+    // The address or error message of the response, if it has no page
+    std::string text;
+    // The page or range of the response, shared with the search cache so cached pages are written without a copy
+    SharedPage page;
+
+    /**
+     * Get the payload of the response
+     */
+    [[nodiscard]] ByteView body() const {
+        if (page) return ByteView(*page);
+        return ByteView(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+    }
+};
+
+
+// The padding schemes a worker has an engine for, in the order of its engines
+constexpr PaddingScheme WORKER_SCHEMES[] = {PaddingScheme::Legacy, PaddingScheme::Counter};
+constexpr size_t SCHEME_COUNT = std::size(WORKER_SCHEMES);
+
+// The pages already found for a batch by address, one map for each padding scheme
+using BatchPages = std::unordered_map<std::string, SharedPage>[SCHEME_COUNT];
+
+
+/**
+ * Build a response from its status and payload
+ */
+Response makeResponse(const uint32_t id, const Status status, std::string text, SharedPage page = nullptr) {
+    Response response;
+    response.text = std::move(text);
+    response.page = std::move(page);
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(response.body().size());
+    header.id = id;
+    header.code = static_cast<uint8_t>(status);
+    writeHeader(response.header, header);
+    return response;
+}
+
+
+/**
+ * A client connection and the bytes waiting to be read from or written to it
+ */
+struct Connection {
+    int fd = -1;
+    // The bytes read that do not yet make up a whole frame
+    std::vector<unsigned char> input;
+    // The responses waiting to be written, and the bytes of the first that were already written
+    std::deque<Response> output;
+    size_t sent = 0;
+    // The requests read from the connection whose responses are not yet queued
+    size_t inFlight = 0;
+    // The events the connection is registered for
+    uint32_t events = 0;
+    // Whether the client shut down its side, after which the connection stays open until every request it sent is
+    // answered
+    bool readClosed = false;
+
+    /**
+     * Get whether every request of a client that shut down its side has been answered
+     */
+    [[nodiscard]] bool finished() const {
+        if (!readClosed || inFlight > 0 || !output.empty()) return false;
+        return input.size() < HEADER_LEN || input.size() < HEADER_LEN + readHeader(input.data()).length;
+    }
+};
+
+
+/**
+ * An epoll loop that reads requests from its connections, hands them to a pool of workers in batches and writes back
+ * each response as soon as its worker finishes it
+ */
+class Server {
+public:
+    explicit Server(const ServerOptions& options);
+
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    /**
+     * Serve until the process is interrupted or terminated
+     */
+    void run();
+
+private:
+    /**
+     * Accept every pending connection of a listener
+     */
+    void accept(int listener);
+
+    /**
+     * Read what a connection has sent and queue the whole requests it holds, marking it read-closed once the client
+     * shuts down its side
+     * @return Whether the connection is still open
+     */
+    bool read(uint64_t id, Connection& connection);
+
+    /**
+     * Queue the whole requests held in the input of a connection, up to its limit of requests in flight
+     * @return Whether the requests were well formed
+     */
+    bool parse(uint64_t id, Connection& connection);
+
+    /**
+     * Split the queued requests into batches and hand them to the workers
+     */
+    void dispatch();
+
+    /**
+     * Work through a batch of requests, handing back the response of each as soon as it is done
+     */
+    void process(size_t worker, std::vector<Request>& batch);
+
+    /**
+     * Get the padding scheme a request searches with
+     * @return The index of the scheme in WORKER_SCHEMES
+     */
+    size_t schemeOf(const Request& request) const;
+
+    /**
+     * Run a request on the engines of a worker
+     * @param worker The index of the worker
+     * @param pages The pages already found for the batch, so repeated searches of an address decode it once
+     */
+    Response handle(size_t worker, const Request& request, BatchPages& pages);
+
+    /**
+     * Hand a response back to the epoll loop, waking it unless earlier responses are already waiting for it
+     */
+    void complete(uint64_t connection, Response response);
+
+    /**
+     * Queue the responses handed back by the workers on their connections
+     */
+    void drainCompletions();
+
+    /**
+     * Write as much of the output of a connection as it will take
+     * @return Whether the connection is still open
+     */
+    bool flush(Connection& connection);
+
+    /**
+     * Register a connection for reads while it is open for reading and under its limit of requests in flight, and for
+     * writes while it has output left
+     */
+    void updateEvents(uint64_t id, Connection& connection);
+
+    void closeConnection(uint64_t id);
+
+    /**
+     * Register a descriptor for reads under an epoll tag
+     * @throws std::system_error If the descriptor could not be registered
+     */
+    void watch(int fd, uint64_t tag);
+
+    /**
+     * Stop the workers and close every descriptor, removing the socket files of the listeners
+     */
+    void release();
+
+    ServerOptions options_;
+    size_t maxFrameLen_ = 0;
+    // The engines of the workers, one for each padding scheme per worker
+    std::vector<Engine> engines_;
+    std::unique_ptr<TaskQueue> queue_;
+    int epoll_ = -1;
+    int wake_ = -1;
+    int signals_ = -1;
+    std::vector<int> listeners_;
+    std::vector<Endpoint> endpoints_;
+    std::unordered_map<uint64_t, Connection> connections_;
+    uint64_t nextConnection_ = FIRST_CONNECTION;
+    std::vector<Request> pending_;
+    std::mutex completionMutex_;
+    std::vector<std::pair<uint64_t, Response>> completions_;
+};
+
+
+Server::Server(const ServerOptions& options) : options_(options) {
+    // Signals are taken from the loop, so they are blocked before any worker starts and a shutdown never interrupts one
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    EngineOptions engineOptions;
+    engineOptions.pageLen = options_.pageLen;
+    engineOptions.zeroFilledAddresses = options_.zeroFilled;
+    engineOptions.alphabet = options_.alphabet;
+    if (options_.cacheMb > 0) {
+        SearchCacheOptions cacheOptions;
+        cacheOptions.capacity = options_.cacheMb * 1024 * 1024;
+        engineOptions.searchCache = std::make_shared<SearchCache>(cacheOptions);
+    }
+    if (!options_.indexPath.empty()) {
+        AddressIndexOptions indexOptions;
+        indexOptions.pageLen = options_.pageLen;
+        indexOptions.alphabet = options_.alphabet;
+        engineOptions.addressIndex = std::make_shared<AddressIndex>(options_.indexPath, indexOptions);
+    }
+
+    size_t threads = options_.threads;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    engines_.reserve(threads * SCHEME_COUNT);
+    for (size_t i = 0; i < threads; ++i) {
+        for (const PaddingScheme scheme : WORKER_SCHEMES) {
+            engineOptions.paddingScheme = scheme;
+            engines_.emplace_back(engineOptions);
+        }
+    }
+    queue_ = std::make_unique<TaskQueue>(threads);
+
+    // The largest request is a SearchRange of the longest address, or the data of a whole page
+    maxFrameLen_ = std::max(options_.pageLen, engines_[0].maxAddressLength() + RANGE_PREFIX_LEN);
+
+    epoll_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_ < 0 || wake_ < 0) throw std::system_error(errno, std::generic_category(), "Could not create event loop");
+
+    try {
+        // Without the descriptor the blocked signals could never be taken, and only SIGKILL would stop the server
+        signals_ = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (signals_ < 0) throw std::system_error(errno, std::generic_category(), "Could not take signals");
+        watch(wake_, WAKE_TAG);
+        watch(signals_, SIGNAL_TAG);
+
+        for (const std::string& text : options_.endpoints) {
+            const Endpoint endpoint = parseEndpoint(text);
+            endpoints_.push_back(endpoint);
+            listeners_.push_back(openSocket(endpoint, true, SOCK_NONBLOCK));
+            watch(listeners_.back(), FIRST_LISTENER + listeners_.size() - 1);
+        }
+    } catch (...) {
+        // The destructor does not run for a server that failed to start, so the socket files it made are removed here
+        release();
+        throw;
+    }
+}
+
+
+Server::~Server() {
+    release();
+}
+
+
+void Server::watch(const int fd, const uint64_t tag) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = tag;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) != 0) throw std::system_error(errno, std::generic_category(), "Could not watch descriptor");
+}
+
+
+void Server::release() {
+    // Finish the batches already handed out before the engines and descriptors they use go away
+    queue_.reset();
+    for (const auto& [id, connection] : connections_) close(connection.fd);
+    for (size_t i = 0; i < listeners_.size(); ++i) {
+        close(listeners_[i]);
+        if (endpoints_[i].unixSocket) unlink(endpoints_[i].path.c_str());
+    }
+    close(signals_);
+    close(wake_);
+    close(epoll_);
+}
+
+
+void Server::run() {
+    epoll_event events[256];
+    while (true) {
+        const int count = epoll_wait(epoll_, events, 256, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "Could not wait for events");
+        }
+
+        // Every ready connection is read before any request is dispatched, so requests that arrive together are
+        // batched together
+        for (int i = 0; i < count; ++i) {
+            const uint64_t tag = events[i].data.u64;
+            if (tag == SIGNAL_TAG) return;
+            if (tag == WAKE_TAG) {
+                uint64_t wakes;
+                while (::read(wake_, &wakes, sizeof(wakes)) > 0) {}
+                drainCompletions();
+            } else if (tag < FIRST_CONNECTION) {
+                accept(listeners_[tag - FIRST_LISTENER]);
+            } else {
+                const auto it = connections_.find(tag);
+                if (it == connections_.end()) continue;
+                Connection& connection = it->second;
+                bool open = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0 || (events[i].events & EPOLLIN) != 0;
+                if (open && (events[i].events & EPOLLIN) != 0) open = read(tag, connection);
+                if (open && (events[i].events & EPOLLOUT) != 0) open = flush(connection);
+                if (open && connection.finished()) open = false;
+                if (open) updateEvents(tag, connection);
+                else closeConnection(tag);
+            }
+        }
+        dispatch();
+    }
+}
+
+
+void Server::accept(const int listener) {
+    while (true) {
+        const int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            return;
+        }
+        const int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        const uint64_t id = nextConnection_++;
+        try {
+            watch(fd, id);
+        } catch (const std::system_error&) {
+            // A connection the loop cannot watch would never be served
+            close(fd);
+            continue;
+        }
+        Connection& connection = connections_[id];
+        connection.fd = fd;
+        connection.events = EPOLLIN;
+    }
+}
+
+
+bool Server::read(const uint64_t id, Connection& connection) {
+    while (connection.inFlight < options_.maxInFlight) {
+        const size_t len = connection.input.size();
+        connection.input.resize(len + READ_CHUNK_LEN);
+        const ssize_t got = ::read(connection.fd, connection.input.data() + len, READ_CHUNK_LEN);
+        connection.input.resize(len + static_cast<size_t>(std::max<ssize_t>(got, 0)));
+        if (got == 0) {
+            // The responses still owed to a client that only shut down its side are written before it is closed
+            connection.readClosed = true;
+            return true;
+        }
+        if (got < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        if (!parse(id, connection)) return false;
+        if (static_cast<size_t>(got) < READ_CHUNK_LEN) break;
+    }
+    return true;
+}
+
+
+bool Server::parse(const uint64_t id, Connection& connection) {
+    size_t offset = 0;
+    while (connection.inFlight < options_.maxInFlight && connection.input.size() - offset >= HEADER_LEN) {
+        const FrameHeader header = readHeader(connection.input.data() + offset);
+        // A frame too long for any request means the client is not speaking the protocol
+        if (header.length > maxFrameLen_) return false;
+        if (connection.input.size() - offset < HEADER_LEN + header.length) break;
+
+        const auto payload = connection.input.begin() + static_cast<long>(offset + HEADER_LEN);
+        Request& request = pending_.emplace_back();
+        request.connection = id;
+        request.header = header;
+        request.payload.assign(payload, payload + header.length);
+        connection.inFlight++;
+        offset += HEADER_LEN + header.length;
+    }
+    connection.input.erase(connection.input.begin(), connection.input.begin() + static_cast<long>(offset));
+    return true;
+}
+
+
+void Server::dispatch() {
+    if (pending_.empty()) return;
+
+    // Under light load every request gets a worker to itself, and under heavy load each worker takes a batch of them
+    const size_t count = pending_.size();
+    const size_t batches = std::max((count + options_.batchLen - 1) / options_.batchLen, std::min(count, queue_->size()));
+    auto next = pending_.begin();
+    for (size_t i = 0; i < batches; ++i) {
+        const size_t len = count / batches + (i < count % batches ? 1 : 0);
+        auto batch = std::make_shared<std::vector<Request>>(std::make_move_iterator(next), std::make_move_iterator(next + static_cast<long>(len)));
+        next += static_cast<long>(len);
+        queue_->push([this, batch](const size_t worker) { process(worker, *batch); });
+    }
+    pending_.clear();
+}
+
+
+void Server::process(const size_t worker, std::vector<Request>& batch) {
+    BatchPages pages;
+    for (const Request& request : batch) complete(request.connection, handle(worker, request, pages));
+}
+
+
+size_t Server::schemeOf(const Request& request) const {
+    PaddingScheme scheme = options_.paddingScheme;
+    if (request.header.flags & FLAG_LEGACY_PADDING) scheme = PaddingScheme::Legacy;
+    else if (request.header.flags & FLAG_COUNTER_PADDING) scheme = PaddingScheme::Counter;
+    return static_cast<size_t>(std::find(std::begin(WORKER_SCHEMES), std::end(WORKER_SCHEMES), scheme) - std::begin(WORKER_SCHEMES));
+}
+
+
+Response Server::handle(const size_t worker, const Request& request, BatchPages& pages) {
+    const uint32_t id = request.header.id;
+    const size_t scheme = schemeOf(request);
+    Engine& engine = engines_[worker * SCHEME_COUNT + scheme];
+    const std::vector<unsigned char>& payload = request.payload;
+    try {
+        switch (static_cast<Op>(request.header.code)) {
+            case Op::Compute: {
+                const bool padRandom = (request.header.flags & FLAG_PAD_RANDOM) != 0;
+                std::string address(engine.maxAddressLength(payload.size(), padRandom), '\0');
+                address.resize(engine.computeAddress(ByteView(payload), padRandom, CharBuffer(address)));
+                return makeResponse(id, Status::Ok, std::move(address));
+            }
+            case Op::Search: {
+                std::string address(payload.begin(), payload.end());
+                SharedPage& page = pages[scheme][address];
+                if (!page) page = engine.searchShared(address);
+                return makeResponse(id, Status::Ok, {}, page);
+            }
+            case Op::SearchRange: {
+                if (payload.size() < RANGE_PREFIX_LEN) return makeResponse(id, Status::BadRequest, "Range requests start with an offset and a length");
+                const uint64_t offset = loadBigEndian64(payload.data());
+                const uint64_t length = loadBigEndian64(payload.data() + 8);
+                const std::string address(payload.begin() + RANGE_PREFIX_LEN, payload.end());
+                auto range = std::make_shared<const std::vector<unsigned char>>(engine.searchRange(address, offset, length));
+                return makeResponse(id, Status::Ok, {}, std::move(range));
+            }
+        }
+        return makeResponse(id, Status::BadRequest, "Unknown operation: "+std::to_string(request.header.code));
+    } catch (const std::logic_error& e) {
+        // Invalid addresses, ranges and arguments are the fault of the request
+        return makeResponse(id, Status::BadRequest, e.what());
+    } catch (const std::exception& e) {
+        return makeResponse(id, Status::Failed, e.what());
+    }
+}
+
+
+void Server::complete(const uint64_t connection, Response response) {
+    bool wasEmpty;
+    {
+        std::lock_guard lock(completionMutex_);
+        wasEmpty = completions_.empty();
+        completions_.emplace_back(connection, std::move(response));
+    }
+    // The loop drains every completion once woken, so only the first of a run needs to wake it
+    if (wasEmpty) {
+        const uint64_t one = 1;
+        [[maybe_unused]] const ssize_t written = write(wake_, &one, sizeof(one));
+    }
+}
+
+
+void Server::drainCompletions() {
+    std::vector<std::pair<uint64_t, Response>> completions;
+    {
+        std::lock_guard lock(completionMutex_);
+        completions.swap(completions_);
+    }
+
+    std::vector<uint64_t> touched;
+    for (auto& [id, response] : completions) {
+        // The client may have gone away while its request was worked on
+        const auto it = connections_.find(id);
+        if (it == connections_.end()) continue;
+        Connection& connection = it->second;
+        connection.output.push_back(std::move(response));
+        connection.inFlight--;
+        touched.push_back(id);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    for (const uint64_t id : touched) {
+        Connection& connection = connections_.at(id);
+        // Requests left in the input while the connection was at its limit can now be queued
+        if (!flush(connection) || !parse(id, connection) || connection.finished()) closeConnection(id);
+        else updateEvents(id, connection);
+    }
+}
+
+
+bool Server::flush(Connection& connection) {
+    while (!connection.output.empty()) {
+        // Gather the headers and payloads of as many responses as fit in one call
+        iovec buffers[MAX_WRITE_BUFFERS];
+        int count = 0;
+        size_t skip = connection.sent;
+        for (const Response& response : connection.output) {
+            if (count + 2 > MAX_WRITE_BUFFERS) break;
+            const ByteView body = response.body();
+            const std::pair<const unsigned char*, size_t> parts[2] = {{response.header, HEADER_LEN}, {body.data(), body.size()}};
+            for (const auto& [data, len] : parts) {
+                if (skip >= len) {
+                    skip -= len;
+                    continue;
+                }
+                buffers[count].iov_base = const_cast<unsigned char*>(data + skip);
+                buffers[count].iov_len = len - skip;
+                count++;
+                skip = 0;
+            }
+        }
+
+        msghdr message{};
+        message.msg_iov = buffers;
+        message.msg_iovlen = static_cast<size_t>(count);
+        const ssize_t written = sendmsg(connection.fd, &message, MSG_NOSIGNAL);
+        if (written < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        // Drop the responses that were written whole
+        size_t left = connection.sent + static_cast<size_t>(written);
+        while (!connection.output.empty()) {
+            const size_t len = HEADER_LEN + connection.output.front().body().size();
+            if (left < len) break;
+            left -= len;
+            connection.output.pop_front();
+        }
+        connection.sent = left;
+    }
+    return true;
+}
+
+
+void Server::updateEvents(const uint64_t id, Connection& connection) {
+    uint32_t events = 0;
+    if (!connection.readClosed && connection.inFlight < options_.maxInFlight) events |= EPOLLIN;
+    if (!connection.output.empty()) events |= EPOLLOUT;
+    if (events == connection.events) return;
+
+    connection.events = events;
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = id;
+    epoll_ctl(epoll_, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+
+void Server::closeConnection(const uint64_t id) {
+    const auto it = connections_.find(id);
+    if (it == connections_.end()) return;
+    close(it->second.fd);
+    connections_.erase(it);
+    // Requests of the connection that were not yet dispatched are dropped with it
+    pending_.erase(std::remove_if(pending_.begin(), pending_.end(), [&](const Request& r) { return r.connection == id; }), pending_.end());
+}
+
+
+/**
+ * Print the usage of the server and exit
+ */
+[[noreturn]] void exitWithUsage(const char* program, const int status) {
+    std::cerr << "Usage: " << program << " [--listen unix:PATH|tcp:PORT]... [--threads N] [--page-len N] [--batch N]"
+              << " [--cache-mb N] [--index FILE] [--zero-filled] [--alphabet base64|base64url]"
+              << " [--padding legacy|counter] [--max-in-flight N]" << std::endl;
+    std::exit(status);
+}
+
+
+/**
+ * Parse the command line into the configuration of the server
+ */
+ServerOptions parseArgs(const int argc, char** argv) {
+    ServerOptions options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+            if (arg == "--listen" && hasValue) options.endpoints.emplace_back(argv[++i]);
+            else if (arg == "--threads" && hasValue) options.threads = std::stoul(argv[++i]);
+            else if (arg == "--page-len" && hasValue) options.pageLen = std::stoul(argv[++i]);
+            else if (arg == "--batch" && hasValue) options.batchLen = std::max(1ul, std::stoul(argv[++i]));
+            else if (arg == "--cache-mb" && hasValue) options.cacheMb = std::stoul(argv[++i]);
+            else if (arg == "--index" && hasValue) options.indexPath = argv[++i];
+            else if (arg == "--zero-filled") options.zeroFilled = true;
+            else if (arg == "--alphabet" && hasValue && std::string(argv[i + 1]) == "base64") options.alphabet = AddressAlphabet::Base64, ++i;
+            else if (arg == "--alphabet" && hasValue && std::string(argv[i + 1]) == "base64url") options.alphabet = AddressAlphabet::Base64Url, ++i;
+            else if (arg == "--padding" && hasValue && std::string(argv[i + 1]) == "legacy") options.paddingScheme = PaddingScheme::Legacy, ++i;
+            else if (arg == "--padding" && hasValue && std::string(argv[i + 1]) == "counter") options.paddingScheme = PaddingScheme::Counter, ++i;
+            else if (arg == "--max-in-flight" && hasValue) options.maxInFlight = std::max(1ul, std::stoul(argv[++i]));
+            else exitWithUsage(argv[0], arg == "--help" ? 0 : 1);
+        }
+    } catch (const std::exception&) {
+        // A value that is not a number, or is too large for one
+        exitWithUsage(argv[0], 1);
+    }
+    if (options.endpoints.empty()) options.endpoints.emplace_back("unix:/tmp/babel.sock");
+    return options;
+}
+
+
+int main(const int argc, char** argv) {
+    const ServerOptions options = parseArgs(argc, argv);
+    try {
+        Server server(options);
+        for (const std::string& endpoint : options.endpoints) std::cerr << "Listening on " << endpoint << std::endl;
+        server.run();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+#ifndef BABEL_PROTOCOL_H
+#define BABEL_PROTOCOL_H
+
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace Babel::Protocol {
+
+    // Every frame starts with a header of a big-endian payload length, a big-endian request id, an opcode or status,
+    // flags and two reserved bytes.  Responses carry the id of their request and may arrive in any order.
+    constexpr size_t HEADER_LEN = 12;
+    // The bytes of the offset and length that start the payload of a SearchRange request
+    constexpr size_t RANGE_PREFIX_LEN = 16;
+
+    /**
+     * The operations a client can request
+     */
+    enum class Op : uint8_t {
+        // Compute the address of the payload, padding it randomly if FLAG_PAD_RANDOM is set
+        Compute = 1,
+        // Search the page of the address in the payload
+        Search = 2,
+        // Search part of the page of an address, the payload being the offset, the length and then the address
+        SearchRange = 3,
+    };
+
+    // Pads the data of a Compute request with random bytes rather than zeros
+    constexpr uint8_t FLAG_PAD_RANDOM = 1 << 0;
+    // Pads the short hexagons of a Search or SearchRange request with the Legacy or Counter scheme rather than the
+    // default scheme of the server, which is Legacy unless it was started with --padding counter
+    constexpr uint8_t FLAG_LEGACY_PADDING = 1 << 1;
+    constexpr uint8_t FLAG_COUNTER_PADDING = 1 << 2;
+
+    /**
+     * The outcome of a request, whose response payload is the result when Ok and an error message otherwise
+     */
+    enum class Status : uint8_t {
+        Ok = 0,
+        // The request was malformed or named an invalid address, and will fail again if repeated
+        BadRequest = 1,
+        // The request failed within the server
+        Failed = 2,
+    };
+
+
+    /**
+     * The header of a request or response frame
+     */
+    struct FrameHeader {
+        uint32_t length = 0;
+        uint32_t id = 0;
+        // The Op of a request or the Status of a response
+        uint8_t code = 0;
+        uint8_t flags = 0;
+    };
+
+
+    inline void storeBigEndian32(unsigned char* dst, const uint32_t value) {
+        dst[0] = static_cast<unsigned char>(value >> 24);
+        dst[1] = static_cast<unsigned char>(value >> 16);
+        dst[2] = static_cast<unsigned char>(value >> 8);
+        dst[3] = static_cast<unsigned char>(value);
+    }
+
+    inline uint32_t loadBigEndian32(const unsigned char* src) {
+        return static_cast<uint32_t>(src[0]) << 24 | static_cast<uint32_t>(src[1]) << 16 |
+               static_cast<uint32_t>(src[2]) << 8 | src[3];
+    }
+
+    inline void storeBigEndian64(unsigned char* dst, const uint64_t value) {
+        storeBigEndian32(dst, static_cast<uint32_t>(value >> 32));
+        storeBigEndian32(dst + 4, static_cast<uint32_t>(value));
+    }
+
+    inline uint64_t loadBigEndian64(const unsigned char* src) {
+        return static_cast<uint64_t>(loadBigEndian32(src)) << 32 | loadBigEndian32(src + 4);
+    }
+
+
+    /**
+     * Write a frame header
+     * @param dst The HEADER_LEN bytes to write the header to
+     */
+    inline void writeHeader(unsigned char* dst, const FrameHeader& header) {
+        storeBigEndian32(dst, header.length);
+        storeBigEndian32(dst + 4, header.id);
+        dst[8] = header.code;
+        dst[9] = header.flags;
+        dst[10] = 0;
+        dst[11] = 0;
+    }
+
+    /**
+     * Read a frame header
+     * @param src The HEADER_LEN bytes of the header
+     */
+    inline FrameHeader readHeader(const unsigned char* src) {
+        FrameHeader header;
+        header.length = loadBigEndian32(src);
+        header.id = loadBigEndian32(src + 4);
+        header.code = src[8];
+        header.flags = src[9];
+        return header;
+    }
+
+
+    /**
+     * A local address to listen on or connect to, written as unix:PATH for a Unix domain socket or tcp:PORT for a TCP
+     * port of the loopback interface
+     */
+    struct Endpoint {
+        bool unixSocket = true;
+        std::string path;
+        uint16_t port = 0;
+    };
+
+
+    /**
+     * Parse an endpoint
+     * @throws std::invalid_argument If the endpoint is neither unix:PATH nor tcp:PORT
+     */
+    inline Endpoint parseEndpoint(const std::string& text) {
+        Endpoint endpoint;
+        if (text.rfind("unix:", 0) == 0 && text.size() > 5) {
+            endpoint.path = text.substr(5);
+            if (endpoint.path.size() >= sizeof(sockaddr_un::sun_path))
+                throw std::invalid_argument("Socket path is too long: "+endpoint.path);
+            return endpoint;
+        }
+        if (text.rfind("tcp:", 0) == 0 && text.size() > 4) {
+            const std::string digits = text.substr(4);
+            unsigned long port = 0;
+            for (const char c : digits) {
+                if (c < '0' || c > '9' || port > 65535) throw std::invalid_argument("Invalid port: "+digits);
+                port = port * 10 + static_cast<unsigned long>(c - '0');
+            }
+            if (port == 0 || port > 65535) throw std::invalid_argument("Invalid port: "+digits);
+            endpoint.unixSocket = false;
+            endpoint.port = static_cast<uint16_t>(port);
+            return endpoint;
+        }
+        throw std::invalid_argument("Endpoints are unix:PATH or tcp:PORT: "+text);
+    }
+
+
+    /**
+     * Open a socket for an endpoint and bind or connect it
+     * @param endpoint The endpoint of the socket
+     * @param listen Whether to listen on the endpoint rather than connect to it
+     * @param flags The flags the socket is created with, such as SOCK_NONBLOCK
+     * @return The descriptor of the socket
+     * @throws std::system_error If the socket could not be opened, bound or connected
+     */
+    inline int openSocket(const Endpoint& endpoint, const bool listen, const int flags = 0) {
+        const int fd = socket(endpoint.unixSocket ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC | flags, 0);
+        if (fd < 0) throw std::system_error(errno, std::generic_category(), "Could not open socket");
+
+        sockaddr_un unixAddress{};
+        sockaddr_in tcpAddress{};
+        sockaddr* address;
+        socklen_t addressLen;
+        if (endpoint.unixSocket) {
+            unixAddress.sun_family = AF_UNIX;
+            std::strncpy(unixAddress.sun_path, endpoint.path.c_str(), sizeof(unixAddress.sun_path) - 1);
+            address = reinterpret_cast<sockaddr*>(&unixAddress);
+            addressLen = sizeof(unixAddress);
+            // A socket file left behind by a server that did not shut down cleanly would block the bind
+            struct stat info{};
+            if (listen && stat(endpoint.path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) unlink(endpoint.path.c_str());
+        } else {
+            // Only the loopback interface is served, so the server is never reachable from outside the machine
+            tcpAddress.sin_family = AF_INET;
+            tcpAddress.sin_port = htons(endpoint.port);
+            tcpAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address = reinterpret_cast<sockaddr*>(&tcpAddress);
+            addressLen = sizeof(tcpAddress);
+            const int on = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            if (listen) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        }
+
+        const int result = listen ? bind(fd, address, addressLen) : connect(fd, address, addressLen);
+        if (result != 0 || (listen && ::listen(fd, SOMAXCONN) != 0)) {
+            const int error = errno;
+            close(fd);
+            throw std::system_error(error, std::generic_category(), listen ? "Could not listen" : "Could not connect");
+        }
+        return fd;
+    }
+}
+
+#endif //BABEL_PROTOCOL_H
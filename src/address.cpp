@@ -0,0 +1,215 @@
+#include "babel_engine.h"
+#include "base64.h"
+#include "codec.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+
+using namespace Babel;
+
+
+// The header bit marking a negative hexagon, the shift of the number of digits in its final partial group, and the bit
+// marking a zero-filled hexagon
+constexpr unsigned char PACKED_NEGATIVE = 1;
+constexpr int PACKED_PARTIAL_SHIFT = 1;
+constexpr unsigned char PACKED_ZERO_FILLED = 1 << 3;
+// The number of bytes of the coordinate that ends a packed address
+constexpr size_t PACKED_COORDINATE_LEN = 4;
+
+
+/**
+ * Get the number of decimal digits in a positive number
+ */
+constexpr size_t digitCount(int value) {
+    size_t count = 1;
+    while (value >= 10) {
+        value /= 10;
+        count++;
+    }
+    return count;
+}
+
+
+/**
+ * Parse a component of a coordinate
+ * @param text The digits of the component, optionally padded with zeros up to the width of its largest value
+ * @param maxValue The largest value of the component
+ * @param name The name of the component, for errors
+ * @return The value of the component
+ */
+int parseComponent(const std::string_view text, const int maxValue, const char* name) {
+    int value = 0;
+    const char* end = text.data() + text.size();
+    const auto [ptr, error] = std::from_chars(text.data(), end, value);
+    if (error != std::errc() || ptr != end)
+        throw std::invalid_argument(std::string(name)+" is not a number: "+std::string(text));
+    if (value < 1 || value > maxValue || text.size() > digitCount(maxValue))
+        throw std::invalid_argument(std::string(name)+" out of range: "+std::string(text));
+    return value;
+}
+
+
+/**
+ * Write a number padded with zeros to a fixed width
+ * @param value The number to write, which must fit within the width
+ * @param width The number of digits to write
+ * @param dst The buffer to write to
+ * @return The end of the written digits
+ */
+char* writePadded(unsigned int value, const size_t width, char* dst) {
+    for (size_t i = width; i > 0; --i) {
+        dst[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return dst + width;
+}
+
+
+ParsedAddress Babel::parseAddress(const std::string_view address) {
+    std::string_view parts[5];
+    size_t start = 0;
+    for (size_t i = 0; i < 5; ++i) {
+        if (start > address.size()) throw std::invalid_argument("Address is missing coordinate components");
+        // The page takes the rest of the address, so any further colon is rejected as part of it
+        const size_t end = i < 4 ? std::min(address.find(':', start), address.size()) : address.size();
+        parts[i] = address.substr(start, end - start);
+        start = end + 1;
+    }
+
+    ParsedAddress parsed;
+    parsed.hexagon = parts[0];
+    parsed.coordinate.wall = static_cast<uint8_t>(parseComponent(parts[1], WALLS_PER_HEXAGON, "Wall"));
+    parsed.coordinate.shelf = static_cast<uint8_t>(parseComponent(parts[2], SHELVES_PER_WALL, "Shelf"));
+    parsed.coordinate.volume = static_cast<uint8_t>(parseComponent(parts[3], VOLUMES_PER_SHELF, "Volume"));
+    parsed.coordinate.page = static_cast<uint16_t>(parseComponent(parts[4], PAGES_PER_VOLUME, "Page"));
+    return parsed;
+}
+
+
+size_t Babel::formatCoordinate(const PackedCoordinate &coord, char* dst) {
+    char* end = dst;
+    *end++ = ':';
+    end = writePadded(coord.wall, digitCount(WALLS_PER_HEXAGON), end);
+    *end++ = ':';
+    end = writePadded(coord.shelf, digitCount(SHELVES_PER_WALL), end);
+    *end++ = ':';
+    end = writePadded(coord.volume, digitCount(VOLUMES_PER_SHELF), end);
+    *end++ = ':';
+    end = writePadded(coord.page, digitCount(PAGES_PER_VOLUME), end);
+    return end - dst;
+}
+
+
+size_t Babel::packAddress(const std::string_view address, const ByteBuffer packed, const AddressAlphabet alphabet) {
+    const ParsedAddress parsed = parseAddress(address);
+    const bool negative = !parsed.hexagon.empty() && parsed.hexagon[0] == alphabetSign(alphabet);
+    const bool zeroFilled = !parsed.hexagon.empty() && parsed.hexagon.back() == ZERO_FILL_MARK;
+    std::string_view digits = parsed.hexagon.substr(negative ? 1 : 0);
+    if (zeroFilled) digits.remove_suffix(1);
+    const size_t len = packedAddressLength(digits.size());
+    if (packed.size() < len)
+        throw std::length_error("Packed address buffer holds "+std::to_string(packed.size())+" of "+std::to_string(len)+" bytes");
+
+    const size_t whole = digits.size() / 4 * 4;
+    const size_t partial = digits.size() % 4;
+    unsigned char* dst = packed.data();
+    *dst++ = (negative ? PACKED_NEGATIVE : 0) | partial << PACKED_PARTIAL_SHIFT | (zeroFilled ? PACKED_ZERO_FILLED : 0);
+    if (decodeBase64(digits.data(), whole, dst, alphabet) != whole)
+        throw std::invalid_argument("Hexagon is not base64: "+std::string(parsed.hexagon.substr(0, 64)));
+    dst += whole / 4 * 3;
+
+    // A final group of one to three digits fits in as many bytes, its missing digits being zero
+    if (partial > 0) {
+        char group[4] = {'A', 'A', 'A', 'A'};
+        std::copy_n(digits.data() + whole, partial, group);
+        unsigned char bytes[3];
+        if (decodeBase64(group, 4, bytes, alphabet) != 4)
+            throw std::invalid_argument("Hexagon is not base64: "+std::string(parsed.hexagon.substr(0, 64)));
+        dst = std::copy_n(bytes, partial, dst);
+    }
+
+    const uint32_t index = parsed.coordinate.index();
+    for (size_t i = 0; i < PACKED_COORDINATE_LEN; ++i) *dst++ = static_cast<unsigned char>(index >> (24 - 8 * i));
+    return len;
+}
+
+
+std::vector<unsigned char> Babel::packAddress(const std::string_view address, const AddressAlphabet alphabet) {
+    // The hexagon is no longer than the address, so this always holds the packed address
+    std::vector<unsigned char> packed(packedAddressLength(address.size()));
+    packed.resize(packAddress(address, ByteBuffer(packed), alphabet));
+    return packed;
+}
+
+
+size_t Babel::unpackedAddressLength(const ByteView packed) {
+    if (packed.size() < 1 + PACKED_COORDINATE_LEN) throw std::invalid_argument("Packed address is too short");
+
+    const unsigned char header = packed[0];
+    const size_t partial = header >> PACKED_PARTIAL_SHIFT & 3;
+    const size_t digitBytes = packed.size() - 1 - PACKED_COORDINATE_LEN;
+    if (header >> 4 != 0 || digitBytes < partial || (digitBytes - partial) % 3 != 0)
+        throw std::invalid_argument("Malformed packed address header: "+std::to_string(header));
+    return (header & PACKED_NEGATIVE) + (digitBytes - partial) / 3 * 4 + partial + (header & PACKED_ZERO_FILLED ? 1 : 0) +
+           MAX_COORDINATE_LEN;
+}
+
+
+size_t Babel::unpackAddress(const ByteView packed, const CharBuffer address, const AddressAlphabet alphabet) {
+    const size_t len = unpackedAddressLength(packed);
+    if (address.size() < len)
+        throw std::length_error("Address buffer holds "+std::to_string(address.size())+" of "+std::to_string(len)+" characters");
+
+    const unsigned char* coordinate = packed.end() - PACKED_COORDINATE_LEN;
+    uint32_t index = 0;
+    for (size_t i = 0; i < PACKED_COORDINATE_LEN; ++i) index = index << 8 | coordinate[i];
+    if (index >= COORDINATES_PER_HEXAGON) throw std::invalid_argument("Packed coordinate out of range: "+std::to_string(index));
+
+    const size_t partial = packed[0] >> PACKED_PARTIAL_SHIFT & 3;
+    const size_t wholeBytes = packed.size() - 1 - PACKED_COORDINATE_LEN - partial;
+    char* dst = address.data();
+    if (packed[0] & PACKED_NEGATIVE) *dst++ = alphabetSign(alphabet);
+    encodeBase64(packed.data() + 1, wholeBytes, dst, alphabet);
+    dst += wholeBytes / 3 * 4;
+    if (partial > 0) {
+        unsigned char bytes[3] = {};
+        std::copy_n(packed.data() + 1 + wholeBytes, partial, bytes);
+        char group[4];
+        encodeBase64(bytes, 3, group, alphabet);
+        dst = std::copy_n(group, partial, dst);
+    }
+    if (packed[0] & PACKED_ZERO_FILLED) *dst++ = ZERO_FILL_MARK;
+    dst += formatCoordinate(PackedCoordinate::fromIndex(index), dst);
+    return dst - address.data();
+}
+
+
+std::string Babel::unpackAddress(const ByteView packed, const AddressAlphabet alphabet) {
+    std::string address(unpackedAddressLength(packed), '\0');
+    unpackAddress(packed, CharBuffer(address), alphabet);
+    return address;
+}
+
+
+std::string Babel::transcodeAddress(const std::string_view address, const AddressAlphabet from, const AddressAlphabet to) {
+    const ParsedAddress parsed = parseAddress(address);
+    const std::array<unsigned char, 256>& values = alphabetValues(from);
+    const std::string_view digits = alphabetDigits(to);
+
+    std::string transcoded(address);
+    const bool negative = !parsed.hexagon.empty() && parsed.hexagon[0] == alphabetSign(from);
+    const bool zeroFilled = !parsed.hexagon.empty() && parsed.hexagon.back() == ZERO_FILL_MARK;
+    if (negative) transcoded[0] = alphabetSign(to);
+    // The coordinate and the zero-fill mark are the same in every alphabet, so only the digits of the hexagon change
+    for (size_t i = negative ? 1 : 0; i < parsed.hexagon.size() - (zeroFilled ? 1 : 0); ++i) {
+        const unsigned char value = values[static_cast<unsigned char>(parsed.hexagon[i])];
+        if (value == Codec<Base64Alphabet>::INVALID)
+            throw std::invalid_argument("Value not found in address charset: "+std::to_string(static_cast<unsigned char>(parsed.hexagon[i])));
+        transcoded[i] = digits[value];
+    }
+    return transcoded;
+}
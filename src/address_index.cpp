@@ -0,0 +1,266 @@
+#include "babel_engine.h"
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+using namespace Babel;
+
+
+constexpr char INDEX_MAGIC[8] = {'B', 'A', 'B', 'E', 'L', 'I', 'D', 'X'};
+constexpr uint32_t INDEX_VERSION = 1;
+// The room left for records past the buckets of a new index, which doubles whenever it runs out
+constexpr size_t INITIAL_RECORD_BYTES = 1024 * 64;
+
+
+// The start of an index file, followed by the bucket offsets and then the records
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t alphabet;
+    uint64_t pageLen;
+    uint64_t buckets;
+    // The offset past the last record, stored before any bucket points at the record
+    uint64_t end;
+    uint64_t entries;
+    uint64_t reserved[2];
+};
+
+// A record of the index, followed by the characters of its address and padded to eight bytes
+struct IndexRecord {
+    // The offset of the next record in the chain of the bucket, or zero at the end of the chain
+    uint64_t next;
+    unsigned char digest[32];
+    uint32_t addressLen;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(IndexHeader) == 64 && sizeof(IndexRecord) == 48);
+
+
+/**
+ * Throw the error of the last failed system call on an index file
+ * @param action What was being done when the call failed
+ * @param path The path of the index file
+ */
+[[noreturn]] void throwIndexError(const std::string& action, const std::string& path) {
+    throw std::system_error(errno, std::generic_category(), "Could not "+action+" address index "+path);
+}
+
+
+/**
+ * Read a word of the index that another thread or process may be writing
+ */
+uint64_t loadWord(const unsigned char* word) {
+    return __atomic_load_n(reinterpret_cast<const uint64_t*>(word), __ATOMIC_ACQUIRE);
+}
+
+
+/**
+ * Publish a word of the index, after every write before it
+ */
+void storeWord(unsigned char* word, const uint64_t value) {
+    __atomic_store_n(reinterpret_cast<uint64_t*>(word), value, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * Get the offset of the bucket of a digest within the index file
+ */
+size_t bucketOffset(const ContentDigest& digest, const uint64_t buckets) {
+    // The digest is already uniform, so its first bytes pick the bucket
+    uint64_t hash;
+    std::memcpy(&hash, digest.data(), sizeof(hash));
+    return sizeof(IndexHeader) + (hash & (buckets - 1)) * sizeof(uint64_t);
+}
+
+
+/**
+ * Get the number of bytes a record takes up in the index file
+ */
+size_t recordLength(const size_t addressLen) { return (sizeof(IndexRecord) + addressLen + 7) & ~size_t{7}; }
+
+
+Babel::AddressIndex::AddressIndex(const std::string &path, const AddressIndexOptions &options)
+    : options_(options), path_(path) {
+    fd_ = open(path.c_str(), options_.readOnly ? O_RDONLY | O_CLOEXEC : O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) throwIndexError("open", path);
+
+    try {
+        if (!options_.readOnly && flock(fd_, LOCK_EX | LOCK_NB) != 0) throwIndexError("lock", path);
+
+        struct stat info{};
+        if (fstat(fd_, &info) != 0) throwIndexError("stat", path);
+
+        if (info.st_size == 0 && !options_.readOnly) {
+            // Start a new index, whose magic is written last so a partly created file is never taken for an index
+            size_t buckets = 1;
+            while (buckets < options_.buckets) buckets *= 2;
+            const size_t len = sizeof(IndexHeader) + buckets * sizeof(uint64_t) + INITIAL_RECORD_BYTES;
+            if (ftruncate(fd_, static_cast<off_t>(len)) != 0) throwIndexError("resize", path);
+            remap();
+
+            auto* header = reinterpret_cast<IndexHeader*>(data_);
+            header->version = INDEX_VERSION;
+            header->alphabet = static_cast<uint32_t>(options_.alphabet);
+            header->pageLen = options_.pageLen;
+            header->buckets = buckets;
+            header->end = sizeof(IndexHeader) + buckets * sizeof(uint64_t);
+            std::memcpy(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+            msync(data_, size_, MS_SYNC);
+        } else {
+            remap();
+        }
+
+        const auto* header = reinterpret_cast<const IndexHeader*>(data_);
+        if (size_ < sizeof(IndexHeader) || std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 ||
+            header->version != INDEX_VERSION)
+            throw std::runtime_error("Not an address index: "+path);
+        if (header->buckets == 0 || (header->buckets & (header->buckets - 1)) != 0 ||
+            sizeof(IndexHeader) + header->buckets * sizeof(uint64_t) > header->end || header->end > size_)
+            throw std::runtime_error("Corrupt address index: "+path);
+        if (header->pageLen != options_.pageLen)
+            throw std::runtime_error("Address index "+path+" holds addresses for a page length of "+std::to_string(header->pageLen));
+        if (header->alphabet != static_cast<uint32_t>(options_.alphabet))
+            throw std::runtime_error("Address index "+path+" holds addresses of another alphabet");
+        options_.buckets = header->buckets;
+    } catch (...) {
+        if (data_ != nullptr) munmap(data_, size_);
+        close(fd_);
+        throw;
+    }
+}
+
+
+Babel::AddressIndex::~AddressIndex() {
+    if (data_ != nullptr) munmap(data_, size_);
+    close(fd_);
+}
+
+
+void Babel::AddressIndex::remap() {
+    struct stat info{};
+    if (fstat(fd_, &info) != 0) throwIndexError("stat", path_);
+    const auto len = static_cast<size_t>(info.st_size);
+    if (len == size_) return;
+
+    if (data_ != nullptr) munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+    if (len == 0) return;
+
+    void* data = mmap(nullptr, len, options_.readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (data == MAP_FAILED) throwIndexError("map", path_);
+    // Lookups jump between buckets and records, so reading ahead would only waste memory
+    madvise(data, len, MADV_RANDOM);
+    data_ = static_cast<unsigned char*>(data);
+    size_ = len;
+}
+
+
+AddressIndexStats Babel::AddressIndex::stats() const {
+    std::shared_lock lock(mutex_);
+    AddressIndexStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.entries = loadWord(data_ + offsetof(IndexHeader, entries));
+    stats.bytes = loadWord(data_ + offsetof(IndexHeader, end));
+    return stats;
+}
+
+
+void Babel::AddressIndex::sync() {
+    std::shared_lock lock(mutex_);
+    if (!options_.readOnly && msync(data_, size_, MS_SYNC) != 0) throwIndexError("sync", path_);
+}
+
+
+size_t Babel::AddressIndex::lookup(const ContentDigest &digest, const CharBuffer address, bool &stale) const {
+    stale = false;
+    uint64_t offset = loadWord(data_ + bucketOffset(digest, options_.buckets));
+    while (offset != 0) {
+        // Records past the mapping were appended by another process since it was made
+        if (offset + sizeof(IndexRecord) > size_) {
+            stale = true;
+            return 0;
+        }
+
+        const auto* record = reinterpret_cast<const IndexRecord*>(data_ + offset);
+        if (std::memcmp(record->digest, digest.data(), digest.size()) == 0) {
+            if (offset + recordLength(record->addressLen) > size_) {
+                stale = true;
+                return 0;
+            }
+            // Addresses for another page length never match, so an address too long for the buffer is a miss
+            if (record->addressLen > address.size()) return 0;
+            std::memcpy(address.data(), data_ + offset + sizeof(IndexRecord), record->addressLen);
+            return record->addressLen;
+        }
+        offset = record->next;
+    }
+    return 0;
+}
+
+
+size_t Babel::AddressIndex::find(const ContentDigest &digest, const CharBuffer address) {
+    size_t len;
+    bool stale;
+    {
+        std::shared_lock lock(mutex_);
+        len = lookup(digest, address, stale);
+    }
+
+    if (stale) {
+        std::unique_lock lock(mutex_);
+        remap();
+        len = lookup(digest, address, stale);
+    }
+    (len > 0 ? hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+    return len;
+}
+
+
+void Babel::AddressIndex::insert(const ContentDigest &digest, const std::string_view address) {
+    if (options_.readOnly) return;
+
+    std::unique_lock lock(mutex_);
+    // Another engine may have added the same data since it was looked up
+    unsigned char* bucket = data_ + bucketOffset(digest, options_.buckets);
+    for (uint64_t offset = loadWord(bucket); offset != 0;) {
+        const auto* record = reinterpret_cast<const IndexRecord*>(data_ + offset);
+        if (std::memcmp(record->digest, digest.data(), digest.size()) == 0) return;
+        offset = record->next;
+    }
+
+    auto* header = reinterpret_cast<IndexHeader*>(data_);
+    const uint64_t offset = header->end;
+    const size_t len = recordLength(address.size());
+    if (offset + len > size_) {
+        size_t fileLen = size_ * 2;
+        while (fileLen < offset + len) fileLen *= 2;
+        if (ftruncate(fd_, static_cast<off_t>(fileLen)) != 0) throwIndexError("grow", path_);
+        remap();
+        header = reinterpret_cast<IndexHeader*>(data_);
+        bucket = data_ + bucketOffset(digest, options_.buckets);
+    }
+
+    // Write the record whole, then claim its bytes, then link it into its bucket for readers to find
+    auto* record = reinterpret_cast<IndexRecord*>(data_ + offset);
+    record->next = loadWord(bucket);
+    std::memcpy(record->digest, digest.data(), digest.size());
+    record->addressLen = static_cast<uint32_t>(address.size());
+    record->reserved = 0;
+    std::memcpy(data_ + offset + sizeof(IndexRecord), address.data(), address.size());
+    storeWord(data_ + offsetof(IndexHeader, end), offset + len);
+    storeWord(bucket, offset);
+    storeWord(data_ + offsetof(IndexHeader, entries), header->entries + 1);
+}
@@ -0,0 +1,133 @@
+#include "babel_engine.h"
+#include "task_queue.h"
+
+#include <algorithm>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+
+using namespace Babel;
+
+
+/**
+ * Get the asynchronous engine that the free asynchronous functions share between threads
+ * @param scheme The scheme the engine pads short hexagons with
+ * @return The shared asynchronous engine, whose workers are started on first use
+ */
+AsyncEngine& sharedAsyncEngine(const PaddingScheme scheme = DEFAULT_PADDING_SCHEME) {
+    const auto makeOptions = [](const PaddingScheme engineScheme) {
+        AsyncOptions options;
+        options.engine.paddingScheme = engineScheme;
+        return options;
+    };
+    if (scheme == PaddingScheme::Legacy) {
+        static AsyncEngine legacyEngine(makeOptions(PaddingScheme::Legacy));
+        return legacyEngine;
+    }
+    static AsyncEngine counterEngine(makeOptions(PaddingScheme::Counter));
+    return counterEngine;
+}
+
+
+std::future<std::string> Babel::computeAddressAsync(std::vector<unsigned char> data, const bool padRandom,
+                                                    CancellationToken token) {
+    return sharedAsyncEngine().computeAddress(std::move(data), padRandom, std::move(token));
+}
+
+
+std::future<std::string> Babel::computeStreamAddressAsync(std::istream &stream, const bool padRandom,
+                                                          CancellationToken token) {
+    return sharedAsyncEngine().computeStreamAddress(stream, padRandom, std::move(token));
+}
+
+
+std::future<std::vector<unsigned char>> Babel::searchAsync(std::string address, CancellationToken token,
+                                                           const PaddingScheme scheme) {
+    return sharedAsyncEngine(scheme).search(std::move(address), std::move(token));
+}
+
+
+std::future<void> Babel::searchStreamAsync(std::string address, std::ostream &stream, CancellationToken token,
+                                           const PaddingScheme scheme) {
+    return sharedAsyncEngine(scheme).searchStream(std::move(address), stream, std::move(token));
+}
+
+
+AsyncEngine::AsyncEngine(const AsyncOptions &options) : options_(options) {
+    const size_t threads = options_.threads > 0 ? options_.threads : std::max(1u, std::thread::hardware_concurrency());
+    engines_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) engines_.emplace_back(options_.engine);
+    queue_ = std::make_unique<TaskQueue>(threads);
+}
+
+
+AsyncEngine::~AsyncEngine() = default;
+
+
+size_t AsyncEngine::threadCount() const {
+    return engines_.size();
+}
+
+
+template<typename Result, typename Work>
+std::future<Result> AsyncEngine::submit(const CancellationToken &token, const bool seeded, Work work) {
+    // The queue holds copyable functions, so the promise is shared with the task rather than moved into it
+    const auto promise = std::make_shared<std::promise<Result>>();
+    std::future<Result> future = promise->get_future();
+    const uint64_t index = seeded ? submitted_.fetch_add(1, std::memory_order_relaxed) : 0;
+
+    queue_->push([this, promise, token, seeded, index, work = std::move(work)](const size_t worker) {
+        Engine& engine = engines_[worker];
+        try {
+            // Work cancelled while it was queued is dropped without starting
+            if (token.cancelled()) throw OperationCancelled();
+            if (seeded && options_.engine.seed) engine.seed(*options_.engine.seed + index);
+
+            engine.cancel_ = &token;
+            if constexpr (std::is_void_v<Result>) {
+                work(engine);
+                engine.cancel_ = nullptr;
+                promise->set_value();
+            } else {
+                Result result = work(engine);
+                engine.cancel_ = nullptr;
+                promise->set_value(std::move(result));
+            }
+        } catch (...) {
+            engine.cancel_ = nullptr;
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+
+
+std::future<std::string> AsyncEngine::computeAddress(std::vector<unsigned char> data, const bool padRandom,
+                                                     CancellationToken token) {
+    return submit<std::string>(token, true, [data = std::move(data), padRandom](Engine& engine) {
+        return engine.computeAddress(data, padRandom);
+    });
+}
+
+
+std::future<std::string> AsyncEngine::computeStreamAddress(std::istream &stream, const bool padRandom,
+                                                           CancellationToken token) {
+    return submit<std::string>(token, true, [&stream, padRandom](Engine& engine) {
+        return engine.computeStreamAddress(stream, padRandom);
+    });
+}
+
+
+std::future<std::vector<unsigned char>> AsyncEngine::search(std::string address, CancellationToken token) {
+    return submit<std::vector<unsigned char>>(token, false, [address = std::move(address)](Engine& engine) {
+        return engine.search(address);
+    });
+}
+
+
+std::future<void> AsyncEngine::searchStream(std::string address, std::ostream &stream, CancellationToken token) {
+    return submit<void>(token, false, [address = std::move(address), &stream](Engine& engine) {
+        engine.searchStream(address, stream);
+    });
+}
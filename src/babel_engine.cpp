@@ -1,256 +1,1040 @@
 #include "babel_engine.h"
+#include "codec.h"
+#include "fitting.h"
+#include "hexagon.h"
+#include "instrumentation.h"
+#include "mapped_file.h"
+#include "padding.h"
+#include "thread_pool.h"
 
 #include <algorithm>
-#include <iomanip>
+#include <cstring>
 #include <iostream>
+#include <optional>
 #include <random>
+#include <stdexcept>
 #include <string>
-#include <sstream>
+#include <string_view>
+#include <thread>
 
 
 using namespace Babel;
 
 
-using random_bytes_engine = std::independent_bits_engine<
-    std::default_random_engine, CHAR_BIT, unsigned char>;
+// The number of bytes read from a stream at a time, a whole number of words so chunked random padding matches fitData()
+constexpr size_t STREAM_CHUNK_LEN = 1024 * 16;
+// The number of page bytes, and of padding characters, each thread decodes or generates at a time
+constexpr size_t PARALLEL_CHUNK_LEN = 1024 * 256;
+constexpr size_t PARALLEL_PADDING_LEN = 1024 * 16;
+// Zeroes to encode zero padding from, without filling a buffer for every page
+static const unsigned char ZERO_CHUNK[STREAM_CHUNK_LEN] = {};
+// The number of pages of a book held per worker, which bounds the memory used by a book of any length
+constexpr size_t BOOK_WINDOW_PAGES = 2;
 
 
 /**
- * Find the index of a value in the charset for the given base
- * @param val The char to get the index of
- * @param base The base of the charset
- * @return The index of the value in the charset
+ * Write the components of a coordinate as strings, with the volume and page padded with zeros
+ * @param packed The coordinate to write
+ * @param coord The coordinate to write the wall, shelf, volume and page to
  */
-int charToIndex(const unsigned char &val, const int base) {
-    if (base == 256) return val;
-
-    if (val > 47 && val < 58) return val + 4;  // 0-9
-    if (val > 64 && val < 91) return val - 65;  // A-Z
-    if (val > 96 && val < 123) return val - 71;  // a-z
-    if (val == 43) return 62;  // +
-    if (val == 47) return 63;  // /
-
-    throw std::invalid_argument("Value not found in address charset: "+std::to_string(val));
+void unpackCoordinate(const PackedCoordinate& packed, LibraryCoordinate& coord) {
+    // The text form is :w:s:vv:ppp, so each component sits at a fixed offset
+    char text[MAX_COORDINATE_LEN];
+    formatCoordinate(packed, text);
+    coord.wall.assign(text + 1, 1);
+    coord.shelf.assign(text + 3, 1);
+    coord.volume.assign(text + 5, 2);
+    coord.page.assign(text + 8, 3);
 }
 
 
 /**
- * Concatenates the components of a library component and return their big integer representation
+ * The contents of the manifest address of a book
  */
-mpz_class makeCoordSeed(const LibraryCoordinate& coord) {
-    // Certain numbers crash mpz_set_str() without first using std::stoi()
-    return {std::stoi(coord.page + coord.volume + coord.shelf + coord.wall)};
-}
+struct BookManifest {
+    // The number of bytes of data in the book
+    uint64_t length;
+    // The coordinate of the first page of the book
+    PackedCoordinate start;
+};
 
 
 /**
- * Ensure the length of the data is equal to the maximum page length
- * @param data The data to fit
- * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
- * @return The data padded or truncated to the maximum page length
+ * Parse the manifest address of a book, book:length:wall:shelf:volume:page
+ * @param manifest The manifest address
+ * @return The length of the book and the coordinate of its first page
  */
-std::vector<unsigned char> fitData(const std::vector<unsigned char> &data, const bool padRandom) {
-    if (data.size() >= MAX_PAGE_LEN) {
+BookManifest parseManifest(const std::string_view manifest) {
+    constexpr std::string_view prefix = "book:";
+    const size_t lengthEnd = manifest.find(':', prefix.length());
+    if (manifest.substr(0, prefix.length()) != prefix || lengthEnd == std::string_view::npos)
+        throw std::invalid_argument("Invalid book manifest: "+std::string(manifest));
+
+    // The coordinate follows the length as it would follow an empty hexagon
+    const PackedCoordinate start = parseAddress(manifest.substr(lengthEnd)).coordinate;
+    const std::string length(manifest.substr(prefix.length(), lengthEnd - prefix.length()));
+    return {std::stoull(length), start};
+}
+
+
+void Babel::fitData(const ByteView data, const bool padRandom, const size_t pageLen, std::mt19937_64& rng,
+                    PaddingGenerator& padding, std::vector<unsigned char>& result) {
+    BABEL_STAGE(Stage::FitData, pageLen);
+    resizeBuffer(result, pageLen, Stage::FitData);
+    if (data.size() >= pageLen) {
         // Truncate the result
-        return {data.begin(), data.begin() + MAX_PAGE_LEN};
+        std::copy_n(data.begin(), pageLen, result.begin());
+        return;
     }
 
     if (!padRandom) {
         // Pad the result with zeroes
-        std::vector result(data);
-        result.resize(MAX_PAGE_LEN, 0);
-        return result;
+        std::copy(data.begin(), data.end(), result.begin());
+        std::fill(result.begin() + static_cast<long>(data.size()), result.end(), 0);
+        return;
     }
 
-    std::vector<unsigned char> result(MAX_PAGE_LEN);
     // Generate random data to pad the result
-    std::random_device rd;
-    std::mt19937 generator(rd());
-    std::uniform_int_distribution<int> placementDistrib(0, MAX_PAGE_LEN - static_cast<int>(data.size()) - 1);
-    const int placement = placementDistrib(generator);
+    std::uniform_int_distribution<size_t> placementDistrib(0, pageLen - data.size() - 1);
+    const size_t placement = placementDistrib(rng);
 
-    random_bytes_engine randGenerator(rd());
     // Add header of random size
-    std::generate_n(begin(result), placement, std::ref(randGenerator));
+    padding.fill(result.data(), placement);
     // Add the data
-    std::copy(data.begin(), data.end(), result.begin() + placement);
+    std::copy(data.begin(), data.end(), result.begin() + static_cast<long>(placement));
     // Add footer of random size
-    std::generate_n(begin(result) + placement + static_cast<int>(data.size()), MAX_PAGE_LEN - placement - data.size(), std::ref(randGenerator));
-    return result;
+    padding.fill(result.data() + placement + data.size(), pageLen - placement - data.size());
 }
 
 
 /**
- * Ensure the length of the address greater than or equal to the minimum address length
- * @param hexAddress The address to fit
- * @return The address padded to the minimum address length
+ * Find how many bytes are left to read from a stream, without consuming them
+ * @param buf The buffer of the stream
+ * @return The number of bytes left, or nothing if the stream cannot seek
  */
-std::vector<unsigned char> fitAddress(const std::string& hexAddress) {
-    std::vector<unsigned char> addrVec = {hexAddress.begin(), hexAddress.end()};
-    if (static_cast<double>(hexAddress.length()) >= MIN_ADDRESS_LEN)
-        return addrVec;
-
-    std::hash<std::string> hasher;
-    const size_t addrSeed = hasher(hexAddress);
+std::optional<size_t> remainingLength(std::streambuf* buf) {
+    const std::streampos start = buf->pubseekoff(0, std::ios_base::cur, std::ios_base::in);
+    if (start == std::streampos(-1)) return std::nullopt;
+    const std::streampos end = buf->pubseekoff(0, std::ios_base::end, std::ios_base::in);
+    buf->pubseekpos(start, std::ios_base::in);
+    if (end == std::streampos(-1)) return std::nullopt;
+    return static_cast<size_t>(end - start);
+}
 
-    // Generate a random integer between 1 and maxValue inclusive
-    std::uniform_int_distribution<> dist(0, 63);
 
-    addrVec.resize(static_cast<int>(MIN_ADDRESS_LEN), 0);
-    for (size_t i = hexAddress.length(); i < MIN_ADDRESS_LEN; i++) {
-        std::mt19937 gen(addrSeed + i);
-        addrVec[i] = BASE64_CHARSET[dist(gen)];
+/**
+ * Read up to a number of raw bytes from a stream, including any whitespace
+ * @param stream The stream to read from
+ * @param dst The buffer to read into
+ * @param len The maximum number of bytes to read
+ * @return The number of bytes read, which is less than len only at the end of the stream
+ */
+size_t readChunk(std::istream& stream, unsigned char* dst, const size_t len) {
+    size_t read = 0;
+    while (read < len) {
+        const std::streamsize got = stream.rdbuf()->sgetn(reinterpret_cast<char*>(dst) + read, static_cast<std::streamsize>(len - read));
+        if (got <= 0) {
+            stream.setstate(std::ios_base::eofbit);
+            break;
+        }
+        read += got;
     }
-    return addrVec;
+    return read;
 }
 
 
-std::vector<unsigned char> Babel::getBaseCharset(const int base) {
+std::string_view Babel::fitAddress(const std::string_view hexAddress, const PaddingScheme scheme, const size_t minAddressLen,
+                                   std::string& fitted, ThreadPool* pool, const AddressAlphabet alphabet) {
+    if (hexAddress.length() >= minAddressLen)
+        return hexAddress;
+
+    BABEL_STAGE(Stage::FitAddress, minAddressLen - hexAddress.length());
+    resizeBuffer(fitted, minAddressLen, Stage::FitAddress);
+    std::copy(hexAddress.begin(), hexAddress.end(), fitted.begin());
+    // Every padding character can be generated on its own, so the padding is split into independent chunks
+    const HexagonPadding padding(hexAddress, scheme, minAddressLen, alphabet);
+    char* dst = fitted.data() + hexAddress.length();
+    forEachChunk(pool, minAddressLen - hexAddress.length(), PARALLEL_PADDING_LEN, [&](const size_t offset, const size_t len) {
+        padding.generate(hexAddress.length() + offset, len, dst + offset);
+    });
+    return fitted;
+}
+
+
+/**
+ * Get the charset for a given base without copying it
+ * @param base The base to get the charset for
+ * @return The charset for the given base
+ */
+const std::vector<unsigned char>& baseCharset(const int base) {
+    static const std::vector<unsigned char> base16Charset(BASE16_DIGITS.begin(), BASE16_DIGITS.end());
+    static const std::vector<unsigned char> base32Charset(BASE32_DIGITS.begin(), BASE32_DIGITS.end());
+    if (base == 16) return base16Charset;
+    if (base == 32) return base32Charset;
     if (base == 64) return BASE64_CHARSET;
     if (base == 256) return BASE256_CHARSET;
     throw std::invalid_argument("Invalid base: "+std::to_string(base));
 }
 
 
-std::string Babel::genRandomPaddedInt(const int maxValue) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    // Generate a random integer between 1 and maxValue inclusive
-    std::uniform_int_distribution<> dist(1, maxValue);
+/**
+ * Append the digits of a positive number in a power-of-two base, without leading zero digits
+ * @param x The number to convert
+ * @param chars The vector to append the digits to
+ */
+template<typename Alphabet>
+void appendDigits(const mpz_class& x, std::vector<unsigned char>& chars) {
+    using BaseCodec = Codec<Alphabet>;
+    // Export the bytes of the number right-aligned in whole groups, so each group encodes to its own digits
+    const size_t byteLen = (mpz_sizeinbase(x.get_mpz_t(), 2) + 7) / 8;
+    const size_t groups = (byteLen + BaseCodec::GROUP_BYTES - 1) / BaseCodec::GROUP_BYTES;
+    std::vector<unsigned char> bytes(groups * BaseCodec::GROUP_BYTES);
+    mpz_export(bytes.data() + bytes.size() - byteLen, nullptr, 1, 1, 1, 0, x.get_mpz_t());
+
+    std::string digits(groups * BaseCodec::GROUP_DIGITS, '\0');
+    BaseCodec::encode(bytes.data(), bytes.size(), digits.data());
+    const size_t skip = digits.find_first_not_of(Alphabet::DIGITS[0]);
+    chars.insert(chars.end(), digits.begin() + static_cast<long>(skip), digits.end());
+}
 
-    const int randInt = dist(gen);
-    const int padding = static_cast<int>(std::to_string(maxValue).length());
-    // Skip padding if the value is 1
-    if (padding == 1) return std::to_string(randInt);
 
-    // Pad the integer with zeros
-    std::stringstream ss;
-    ss << std::setw(padding) << std::setfill('0') << randInt;
-    return ss.str();
+/**
+ * Read the digits of a positive number in a power-of-two base
+ * @param digits The digits of the number
+ * @param len The number of digits
+ * @return The number
+ */
+template<typename Alphabet>
+mpz_class readDigits(const unsigned char* digits, const size_t len) {
+    using BaseCodec = Codec<Alphabet>;
+    // Left-pad the digits with zero digits to whole groups, so each group decodes to its own bytes
+    const size_t groups = (len + BaseCodec::GROUP_DIGITS - 1) / BaseCodec::GROUP_DIGITS;
+    std::string padded(groups * BaseCodec::GROUP_DIGITS - len, Alphabet::DIGITS[0]);
+    padded.append(reinterpret_cast<const char*>(digits), len);
+
+    std::vector<unsigned char> bytes(groups * BaseCodec::GROUP_BYTES);
+    if (const size_t bad = BaseCodec::decode(padded.data(), padded.size(), bytes.data()); bad < padded.size())
+        throw std::invalid_argument("Value not found in address charset: "+std::to_string(static_cast<unsigned char>(padded[bad])));
+
+    mpz_class x;
+    mpz_import(x.get_mpz_t(), bytes.size(), 1, 1, 1, 0, bytes.data());
+    return x;
+}
+
+
+/**
+ * Check whether a hexagon is zero-filled, its digits standing for the full-width hexagon without its final zero digits
+ * @param hexagon The hexagon of an address
+ * @return Whether the hexagon ends with the zero-fill mark
+ */
+bool isZeroFilled(const std::string_view hexagon) {
+    return !hexagon.empty() && hexagon.back() == ZERO_FILL_MARK;
+}
+
+
+/**
+ * Get the default configuration of an engine that pads short hexagons with a given scheme
+ * @param scheme The scheme the engine pads short hexagons with
+ * @return The configuration of the engine
+ */
+EngineOptions schemeOptions(const PaddingScheme scheme) {
+    EngineOptions options;
+    options.paddingScheme = scheme;
+    return options;
+}
+
+
+/**
+ * Get the engine that the free functions use on the calling thread
+ * @param scheme The scheme the engine pads short hexagons with
+ * @return The engine of the calling thread
+ */
+Engine& threadEngine(const PaddingScheme scheme = DEFAULT_PADDING_SCHEME) {
+    thread_local Engine legacyEngine(schemeOptions(PaddingScheme::Legacy));
+    thread_local Engine counterEngine(schemeOptions(PaddingScheme::Counter));
+    return scheme == PaddingScheme::Legacy ? legacyEngine : counterEngine;
+}
+
+
+/**
+ * Get the batch engine that the free batch functions share between threads
+ * @param scheme The scheme the engine pads short hexagons with
+ * @return The shared batch engine, whose workers are started on first use
+ */
+BatchEngine& sharedBatchEngine(const PaddingScheme scheme = DEFAULT_PADDING_SCHEME) {
+    if (scheme == PaddingScheme::Legacy) {
+        static BatchEngine legacyEngine(BatchOptions{schemeOptions(PaddingScheme::Legacy), 0});
+        return legacyEngine;
+    }
+    static BatchEngine counterEngine(BatchOptions{schemeOptions(PaddingScheme::Counter), 0});
+    return counterEngine;
+}
+
+
+std::vector<unsigned char> Babel::getBaseCharset(const int base) {
+    return baseCharset(base);
+}
+
+
+std::string Babel::genRandomPaddedInt(const int maxValue) {
+    return threadEngine().genRandomPaddedInt(maxValue);
 }
 
 
 LibraryCoordinate Babel::genRandomLibraryCoordinate() {
     LibraryCoordinate coord;
-    coord.wall = genRandomPaddedInt(WALLS_PER_HEXAGON);
-    coord.shelf = genRandomPaddedInt(SHELVES_PER_WALL);
-    coord.volume = genRandomPaddedInt(VOLUMES_PER_SHELF);
-    coord.page = genRandomPaddedInt(PAGES_PER_VOLUME);
-
+    threadEngine().genRandomLibraryCoordinate(coord);
     return coord;
 }
 
 
 LibraryCoordinate Babel::getAddressComponents(const std::string &address) {
-    std::istringstream ss(address);
+    // Parsing checks that the address components are within the valid range
+    const ParsedAddress parsed = parseAddress(address);
+
     LibraryCoordinate coord;
-    std::getline(ss, coord.hexagon, ':');
-    std::getline(ss, coord.wall, ':');
-    std::getline(ss, coord.shelf, ':');
-    std::getline(ss, coord.volume, ':');
-    std::getline(ss, coord.page, ':');
-
-    // Check if the address components are within the valid range
-    if (std::stoi(coord.wall) > WALLS_PER_HEXAGON) throw std::invalid_argument("Wall out of range: "+coord.wall);
-    if (std::stoi(coord.shelf) > SHELVES_PER_WALL) throw std::invalid_argument("Shelf out of range: "+coord.shelf);
-    if (std::stoi(coord.volume) > VOLUMES_PER_SHELF) throw std::invalid_argument("Volume out of range: "+coord.volume);
-    if (std::stoi(coord.page) > PAGES_PER_VOLUME) throw std::invalid_argument("Page out of range: "+coord.page);
-
-    // Pad the volume and page with zeros
-    while (coord.volume.length() < 2) coord.volume = "0" + coord.volume;
-    while (coord.page.length() < 3) coord.page = "0" + coord.page;
+    coord.hexagon = parsed.hexagon;
+    unpackCoordinate(parsed.coordinate, coord);
     return coord;
 }
 
 
 std::vector<unsigned char> Babel::numToBase(mpz_class x, const int base) {
-    std::vector<unsigned char> baseCharset = getBaseCharset(base);
+    const std::vector<unsigned char>& baseCharset = ::baseCharset(base);
 
     if (x == 0) return {baseCharset[0]};  // Zero is zero in any base
 
-    const int sqrtBase = base == 256 ? 16 : 8;
+    BABEL_STAGE(Stage::NumToBase, mpz_sizeinbase(x.get_mpz_t(), 256));
+    BABEL_ALLOCATION(Stage::NumToBase);
     std::vector<unsigned char> chars;
-    const int sign = x < 0 ? -1 : 1;
-    x *= sign;  // Ensure the number is positive
-
-    if (sign < 0) chars.push_back(45);  // Add the negative sign
-    std::string xStr = x.get_str(sqrtBase);
-    if (xStr.length() % 2 != 0) xStr = "0" + xStr;  // Ensure the string has an even length
-    for (int i=0; i<xStr.length(); i+=2) {
-        const int byte = std::stoi(xStr.substr(i, 2), nullptr, sqrtBase);  // Convert the hex string to an integer
-        chars.push_back(baseCharset[byte]);
-    }
+    if (x < 0) chars.push_back(45);  // Add the negative sign
+    x = abs(x);
 
+    // Every digit of a power-of-two base covers its own bits, so the digits are read straight off the bytes
+    switch (base) {
+        case 16: appendDigits<Base16Alphabet>(x, chars); break;
+        case 32: appendDigits<Base32Alphabet>(x, chars); break;
+        case 64: appendDigits<Base64Alphabet>(x, chars); break;
+        default: {
+            const size_t start = chars.size();
+            chars.resize(start + (mpz_sizeinbase(x.get_mpz_t(), 2) + 7) / 8);
+            mpz_export(chars.data() + start, nullptr, 1, 1, 1, 0, x.get_mpz_t());
+        }
+    }
     return chars;
 }
 
 
 mpz_class Babel::baseToNum(const std::vector<unsigned char> &vec, const int base) {
-    const std::vector<unsigned char> baseCharset = getBaseCharset(base);
+    const std::vector<unsigned char>& baseCharset = ::baseCharset(base);
 
-    if (vec.size() == 1 && vec[0] == baseCharset[0]) return {0};  // Zero is zero in any base
+    if (vec.empty() || (vec.size() == 1 && vec[0] == baseCharset[0])) return {0};  // Zero is zero in any base
 
-    const int baseShift = base == 256 ? 8 : 6;
-    mpz_class x = {0};
+    BABEL_STAGE(Stage::BaseToNum, vec.size());
     const bool isNeg = vec[0] == static_cast<char>(45);  // Check if the number is negative
+    const unsigned char* digits = vec.data() + (isNeg ? 1 : 0);
+    const size_t len = vec.size() - (isNeg ? 1 : 0);
 
-    for (int i = (isNeg ? 1 : 0); i < vec.size(); ++i) {
-        x = x << baseShift;
-        x += charToIndex(vec[i], base);  // Add the value of the character to the number
+    mpz_class x;
+    switch (base) {
+        case 16: x = readDigits<Base16Alphabet>(digits, len); break;
+        case 32: x = readDigits<Base32Alphabet>(digits, len); break;
+        case 64: x = readDigits<Base64Alphabet>(digits, len); break;
+        default: mpz_import(x.get_mpz_t(), len, 1, 1, 1, 0, digits);
     }
-
-    return x * (isNeg? -1 : 1);
+    return isNeg ? mpz_class(-x) : x;
 }
 
 
 std::string Babel::computeAddress(const std::vector<unsigned char>& data, const bool padRandom) {
-    const std::vector<unsigned char> paddedData = fitData(data, padRandom);
+    return threadEngine().computeAddress(data, padRandom);
+}
+
+
+size_t Babel::computeAddress(const ByteView data, const bool padRandom, const CharBuffer address) {
+    return threadEngine().computeAddress(data, padRandom, address);
+}
+
+
+std::string Babel::computeStreamAddress(std::istream& stream, const bool padRandom) {
+    return threadEngine().computeStreamAddress(stream, padRandom);
+}
+
+
+void Babel::computeStreamAddress(std::istream& stream, std::ostream& address, const bool padRandom) {
+    threadEngine().computeStreamAddress(stream, address, padRandom);
+}
+
+
+std::vector<unsigned char> Babel::search(const std::string &address, const PaddingScheme scheme) {
+    return threadEngine(scheme).search(address);
+}
+
+
+size_t Babel::search(const std::string_view address, const ByteBuffer page, const PaddingScheme scheme) {
+    return threadEngine(scheme).search(address, page);
+}
+
+
+void Babel::searchStream(const std::string &address, std::ostream &stream, const PaddingScheme scheme) {
+    threadEngine(scheme).searchStream(address, stream);
+}
+
+
+std::vector<unsigned char> Babel::searchRange(const std::string &address, const size_t offset, const size_t length,
+                                              const PaddingScheme scheme) {
+    return threadEngine(scheme).searchRange(address, offset, length);
+}
+
+
+size_t Babel::searchRange(const std::string_view address, const size_t offset, const ByteBuffer range,
+                          const PaddingScheme scheme) {
+    return threadEngine(scheme).searchRange(address, offset, range);
+}
+
+
+void Babel::searchRangeStream(const std::string &address, const size_t offset, const size_t length,
+                              std::ostream &stream, const PaddingScheme scheme) {
+    threadEngine(scheme).searchRangeStream(address, offset, length, stream);
+}
+
+
+std::vector<std::string> Babel::computeAddressBatch(const std::vector<std::vector<unsigned char>> &data, const bool padRandom) {
+    return sharedBatchEngine().computeAddressBatch(data, padRandom);
+}
+
+
+std::vector<std::vector<unsigned char>> Babel::searchBatch(const std::vector<std::string> &addresses,
+                                                           const PaddingScheme scheme) {
+    return sharedBatchEngine(scheme).searchBatch(addresses);
+}
+
+
+std::string Babel::computeFileAddress(const std::string &path, const bool padRandom) {
+    return threadEngine().computeFileAddress(path, padRandom);
+}
+
+
+void Babel::searchToFile(const std::string &address, const std::string &path, const PaddingScheme scheme) {
+    threadEngine(scheme).searchToFile(address, path);
+}
+
+
+std::string Babel::computeBook(std::istream &data, std::ostream &book, const bool padRandom) {
+    return sharedBatchEngine().computeBook(data, book, padRandom);
+}
+
+
+void Babel::searchBook(const std::string &manifest, std::istream &book, std::ostream &data, const PaddingScheme scheme) {
+    sharedBatchEngine(scheme).searchBook(manifest, book, data);
+}
+
+
+Engine::Engine(const EngineOptions &options) : options_(options) {
+    if (options_.pageLen == 0) throw std::invalid_argument("Invalid page length: "+std::to_string(options_.pageLen));
+    padding_ = options_.paddingGenerator ? options_.paddingGenerator() : std::make_unique<CounterPaddingGenerator>();
+    if (!padding_) throw std::invalid_argument("The padding generator factory gave no generator");
+    if (options_.addressIndex && (options_.addressIndex->options().pageLen != options_.pageLen ||
+                                  options_.addressIndex->options().alphabet != options_.alphabet))
+        throw std::invalid_argument("The address index holds addresses for another page length or alphabet");
+    if (options_.seed) {
+        seed(*options_.seed);
+    } else {
+        std::random_device rd;
+        seed(static_cast<uint64_t>(rd()) << 32 | rd());
+    }
+
+    const size_t pageThreads = options_.pageThreads > 0 ? options_.pageThreads : std::thread::hardware_concurrency();
+    if (pageThreads > 1) pool_ = std::make_unique<ThreadPool>(pageThreads);
+}
+
+
+Engine::Engine(Engine &&other) noexcept = default;
+
+
+Engine &Engine::operator=(Engine &&other) noexcept = default;
+
+
+Engine::~Engine() = default;
+
+
+void Engine::seed(const uint64_t seed) {
+    rng_.seed(seed);
+    padding_->seed(seed);
+}
+
+
+std::string Engine::genRandomPaddedInt(const int maxValue) {
+    // Generate a random integer between 1 and maxValue inclusive
+    std::uniform_int_distribution<> dist(1, maxValue);
+
+    std::string randInt = std::to_string(dist(rng_));
+    const size_t padding = std::to_string(maxValue).length();
+    // Pad the integer with zeros
+    if (randInt.length() < padding) randInt.insert(0, padding - randInt.length(), '0');
+    return randInt;
+}
+
+
+void Engine::genRandomLibraryCoordinate(LibraryCoordinate &coord) {
+    unpackCoordinate(genRandomCoordinate(), coord);
+}
+
 
-    // Convert data to a number
-    mpz_class dataSum = {0};
-    for (int i = 0; i < paddedData.size(); ++i) {
-        const mpz_class c = paddedData[paddedData.size() - 1 - i];
-        dataSum += c << (8 * i);
+PackedCoordinate Engine::genRandomCoordinate() {
+    // Drawn in the same order and from the same distributions as genRandomPaddedInt()
+    PackedCoordinate coord;
+    coord.wall = static_cast<uint8_t>(std::uniform_int_distribution<>(1, WALLS_PER_HEXAGON)(rng_));
+    coord.shelf = static_cast<uint8_t>(std::uniform_int_distribution<>(1, SHELVES_PER_WALL)(rng_));
+    coord.volume = static_cast<uint8_t>(std::uniform_int_distribution<>(1, VOLUMES_PER_SHELF)(rng_));
+    coord.page = static_cast<uint16_t>(std::uniform_int_distribution<>(1, PAGES_PER_VOLUME)(rng_));
+    return coord;
+}
+
+
+size_t Engine::maxAddressLength(const size_t dataLen, const bool padRandom) const {
+    if (padRandom || !options_.zeroFilledAddresses) return maxAddressLength();
+    // The digits of the seed, the data and the groups they share, then the zero-fill mark
+    const size_t digits = (std::min(dataLen, options_.pageLen) + 4 + 2 + 2) / 3 * 4 + 1;
+    return std::min(digits + MAX_COORDINATE_LEN, maxAddressLength());
+}
+
+
+void Engine::computeAddress(const std::vector<unsigned char> &data, const bool padRandom, std::string &address) {
+    resizeBuffer(address, maxAddressLength(data.size(), padRandom), Stage::Encode);
+    address.resize(computeAddress(ByteView(data), padRandom, CharBuffer(address)));
+}
+
+
+size_t Engine::computeAddress(const ByteView data, const bool padRandom, const CharBuffer address) {
+    if (const size_t maxLen = maxAddressLength(data.size(), padRandom); address.size() < maxLen)
+        throw std::length_error("Address buffer holds "+std::to_string(address.size())+" of "+std::to_string(maxLen)+" characters");
+
+    // Data padded with zeros always gives the same page, so an address already computed for it can be given again
+    AddressIndex* index = padRandom ? nullptr : options_.addressIndex.get();
+    ContentDigest digest;
+    if (index) {
+        digest = sha256(data.subspan(0, options_.pageLen));
+        if (const size_t len = index->find(digest, address)) return len;
     }
 
     // Generate a random library coordinate to serve as the basis for the address
-    LibraryCoordinate coord = genRandomLibraryCoordinate();
-    const mpz_class shifted_coord = makeCoordSeed(coord) << (8 * paddedData.size());
-    const std::vector<unsigned char> hexagonAddr = numToBase(shifted_coord + dataSum, 64);
-    // Encode the base-10 address as a string represented by the address charset
-    const std::string hexagonAddrStr(hexagonAddr.begin(), hexagonAddr.end());
-    return hexagonAddrStr + ":" + coord.wall + ":" + coord.shelf + ":" + coord.volume + ":" + coord.page;
+    const PackedCoordinate coord = genRandomCoordinate();
+
+    // The coordinate seed is shifted by whole bytes, so the page bytes can be encoded directly as base64
+    size_t len;
+    if (!padRandom && options_.zeroFilledAddresses) {
+        // Only the digits of the data are encoded, the zeros after it being left out of the address
+        checkCancelled();
+        const size_t dataLen = std::min(data.size(), options_.pageLen);
+        BABEL_STAGE(Stage::Encode, dataLen);
+        len = encodeZeroFilledHexagon(coord.seed(), data.data(), dataLen, options_.pageLen, address.data(),
+                                      options_.alphabet);
+    } else {
+        len = encodeFitted(coord.seed(), data, padRandom, address.data());
+    }
+    {
+        BABEL_STAGE(Stage::AssembleAddress, MAX_COORDINATE_LEN);
+        len += formatCoordinate(coord, address.data() + len);
+    }
+    if (index) index->insert(digest, std::string_view(address.data(), len));
+    return len;
 }
 
 
-std::string Babel::computeStreamAddress(std::istream& stream, const bool padRandom) {
-    std::vector<unsigned char> signedData;
-    unsigned char c;
-    while (stream >> c) signedData.push_back(c);
-    return computeAddress(signedData, padRandom);
+size_t Engine::encodeFitted(const unsigned int coordSeed, const ByteView data, const bool padRandom, char* dst) {
+    const size_t pageLen = options_.pageLen;
+    BABEL_STAGE(Stage::Encode, pageLen);
+    if (pool_) {
+        // Each thread encodes its own part of a contiguous page
+        checkCancelled();
+        fitData(data, padRandom, pageLen, rng_, *padding_, paddedData_);
+        return encodeHexagon(coordSeed, paddedData_.data(), pageLen, dst, pool_.get(), options_.alphabet);
+    }
+
+    HexagonEncoder encoder(coordSeed, pageLen, options_.alphabet);
+    size_t len = 0;
+    // The page is encoded a chunk at a time, so cancelled work stops between chunks
+    const auto encodeData = [&](const size_t dataLen) {
+        for (size_t done = 0; done < dataLen; done += STREAM_CHUNK_LEN) {
+            checkCancelled();
+            len += encoder.write(data.data() + done, std::min(dataLen - done, STREAM_CHUNK_LEN), dst + len);
+        }
+    };
+    const auto encodePadding = [&](size_t padLen, const bool random) {
+        for (; padLen > 0; padLen -= std::min(padLen, STREAM_CHUNK_LEN)) {
+            checkCancelled();
+            const size_t pieceLen = std::min(padLen, STREAM_CHUNK_LEN);
+            if (random) {
+                resizeBuffer(chunk_, STREAM_CHUNK_LEN, Stage::Encode);
+                padding_->fill(chunk_.data(), pieceLen);
+            }
+            len += encoder.write(random ? chunk_.data() : ZERO_CHUNK, pieceLen, dst + len);
+        }
+    };
+
+    const size_t dataLen = std::min(data.size(), pageLen);
+    if (!padRandom || dataLen == pageLen) {
+        // Truncate the data, or pad it with zeroes
+        encodeData(dataLen);
+        encodePadding(pageLen - dataLen, false);
+    } else {
+        // Surround the data with random bytes, in the same order as fitData() draws them
+        std::uniform_int_distribution<size_t> placementDistrib(0, pageLen - dataLen - 1);
+        const size_t placement = placementDistrib(rng_);
+        encodePadding(placement, true);
+        encodeData(dataLen);
+        encodePadding(pageLen - placement - dataLen, true);
+    }
+    return len + encoder.finish(dst + len);
 }
 
 
-std::vector<unsigned char> Babel::search(const std::string &address) {
-    LibraryCoordinate coord = getAddressComponents(address);
-    const std::vector<unsigned char> addrVec = fitAddress(coord.hexagon);  // Fit address to avoid predictable looking addressed data
-    const mpz_class numericalAddr = baseToNum(addrVec, 64);
+std::string Engine::computeAddress(const std::vector<unsigned char> &data, const bool padRandom) {
+    std::string address;
+    computeAddress(data, padRandom, address);
+    return address;
+}
 
-    mpz_class mult;
-    mpz_class bigBase = {256};
-    // Exponentiate the base to the maximum page length and store the result in mult
-    mpz_pow_ui(mult.get_mpz_t(), bigBase.get_mpz_t(), MAX_PAGE_LEN);
 
-    const mpz_class coordSeed = makeCoordSeed(coord);
-    const mpz_class seed = numericalAddr - coordSeed * mult;
-    // Convert the address base-encoded text to the text charset
-    std::vector<unsigned char> resultText = numToBase(seed, 256);
+std::string Engine::computeStreamAddress(std::istream &stream, const bool padRandom) {
+    std::string address;
+    address.reserve(maxHexagonLength(options_.pageLen) + MAX_COORDINATE_LEN);
+    streamAddress(stream, padRandom, [&address](const char* chars, const size_t len) { address.append(chars, len); });
+    return address;
+}
 
-    return {resultText.begin(), resultText.begin() + MAX_PAGE_LEN};
+
+void Engine::computeStreamAddress(std::istream &stream, std::ostream &address, const bool padRandom) {
+    streamAddress(stream, padRandom, [&address](const char* chars, const size_t len) {
+        address.write(chars, static_cast<std::streamsize>(len));
+    });
 }
 
 
-void Babel::searchStream(const std::string &address, std::ostream &stream) {
-    std::vector<unsigned char> contentBytes = search(address);
-    for (const unsigned char &c : contentBytes) stream << c;
+void Engine::streamAddress(std::istream &stream, const bool padRandom, const std::function<void(const char*, size_t)> &sink) {
+    const size_t pageLen = options_.pageLen;
+    // Generate a random library coordinate to serve as the basis for the address
+    const PackedCoordinate coord = genRandomCoordinate();
+    HexagonEncoder encoder(coord.seed(), pageLen, options_.alphabet);
+
+    std::optional<StageTimer> encodeTimer;
+    if constexpr (INSTRUMENTATION_ENABLED) encodeTimer.emplace(Stage::Encode, pageLen);
+    resizeBuffer(chunk_, STREAM_CHUNK_LEN, Stage::Encode);
+    resizeBuffer(chars_, HexagonEncoder::maxDigits(STREAM_CHUNK_LEN), Stage::Encode);
+    const auto encode = [&](const unsigned char* bytes, const size_t len) {
+        for (size_t done = 0; done < len; done += STREAM_CHUNK_LEN) {
+            checkCancelled();
+            const size_t pieceLen = std::min(len - done, STREAM_CHUNK_LEN);
+            sink(chars_.data(), encoder.write(bytes + done, pieceLen, chars_.data()));
+        }
+    };
+    // Pass along the next bytes of the stream, falling back to zeroes if it ends early
+    const auto encodeStream = [&](size_t len) {
+        while (len > 0) {
+            const size_t read = readChunk(stream, chunk_.data(), std::min(len, STREAM_CHUNK_LEN));
+            if (read == 0) break;
+            encode(chunk_.data(), read);
+            len -= read;
+        }
+        std::fill(chunk_.begin(), chunk_.end(), 0);
+        for (; len > 0; len -= std::min(len, STREAM_CHUNK_LEN)) encode(chunk_.data(), std::min(len, STREAM_CHUNK_LEN));
+    };
+    const auto encodeRandom = [&](size_t len) {
+        for (; len > 0; len -= std::min(len, STREAM_CHUNK_LEN)) {
+            padding_->fill(chunk_.data(), std::min(len, STREAM_CHUNK_LEN));
+            encode(chunk_.data(), std::min(len, STREAM_CHUNK_LEN));
+        }
+    };
+
+    if (!padRandom) {
+        // Pad the data with zeroes as it streams past
+        encodeStream(pageLen);
+    } else {
+        // The placement of random padding depends on the length of the data, so unseekable streams are buffered
+        const std::optional<size_t> available = remainingLength(stream.rdbuf());
+        const bool buffered = !available;
+        if (buffered) {
+            streamData_.resize(pageLen);
+            streamData_.resize(readChunk(stream, streamData_.data(), pageLen));
+        }
+        const size_t dataLen = std::min(buffered ? streamData_.size() : *available, pageLen);
+        const auto encodeData = [&](const size_t len) {
+            if (buffered) encode(streamData_.data(), len);
+            else encodeStream(len);
+        };
+
+        if (dataLen == pageLen) {
+            // Truncate the data
+            encodeData(pageLen);
+        } else {
+            // Surround the data with random bytes, in the same order as fitData() draws them
+            std::uniform_int_distribution<size_t> placementDistrib(0, pageLen - dataLen - 1);
+            const size_t placement = placementDistrib(rng_);
+            encodeRandom(placement);
+            encodeData(dataLen);
+            encodeRandom(pageLen - placement - dataLen);
+        }
+    }
+
+    sink(chars_.data(), encoder.finish(chars_.data()));
+    encodeTimer.reset();
+
+    BABEL_STAGE(Stage::AssembleAddress, MAX_COORDINATE_LEN);
+    char coordText[MAX_COORDINATE_LEN];
+    sink(coordText, formatCoordinate(coord, coordText));
+}
+
+
+HexagonDecoder Engine::pageDecoder(const std::string_view address) {
+    const ParsedAddress parsed = [&] {
+        BABEL_STAGE(Stage::ParseAddress, address.length());
+        return parseAddress(address);
+    }();
+
+    if (isZeroFilled(parsed.hexagon))
+        return {parsed.hexagon.data(), parsed.hexagon.length() - 1, static_cast<int>(parsed.coordinate.seed()),
+                options_.pageLen, high_, nullptr, options_.alphabet, true};
+
+    // Fit address to avoid predictable looking addressed data
+    const std::string_view hexagon = fitAddress(parsed.hexagon, options_.paddingScheme, minAddressLength(), digits_,
+                                                pool_.get(), options_.alphabet);
+    return {hexagon.data(), hexagon.length(), static_cast<int>(parsed.coordinate.seed()), options_.pageLen, high_,
+            nullptr, options_.alphabet};
+}
+
+
+std::string Engine::computeFileAddress(const std::string &path, const bool padRandom) {
+    // Bytes past the first page never reach the address, so they are not mapped
+    const MappedFile file = MappedFile::openForReading(path, options_.pageLen);
+    std::string address(maxAddressLength(), '\0');
+    address.resize(computeAddress(ByteView(file.data(), file.size()), padRandom, CharBuffer(address)));
+    return address;
+}
+
+
+void Engine::searchToFile(const std::string &address, const std::string &path) {
+    if (options_.searchCache) {
+        const SharedPage page = searchShared(address);
+        const MappedFile file = MappedFile::createForWriting(path, options_.pageLen);
+        std::copy(page->begin(), page->end(), file.data());
+        return;
+    }
+
+    const HexagonDecoder decoder = pageDecoder(address);
+    BABEL_STAGE(Stage::Decode, options_.pageLen);
+    const MappedFile file = MappedFile::createForWriting(path, options_.pageLen);
+    forEachChunk(pool_.get(), options_.pageLen, PARALLEL_CHUNK_LEN, [&](const size_t offset, const size_t len) {
+        decoder.read(offset, len, file.data() + offset);
+    });
+}
+
+
+size_t Engine::encodeBookPage(const PackedCoordinate &coord, const ByteBuffer page, const size_t dataLen,
+                              const bool padRandom, char* hexagon) {
+    const size_t pageLen = options_.pageLen;
+    // Pad after the data rather than around it, so the data of the last page is found at its start
+    if (padRandom) padding_->fill(page.data() + dataLen, pageLen - dataLen);
+    else std::fill(page.begin() + dataLen, page.begin() + pageLen, 0);
+
+    return encodeFitted(coord.seed(), ByteView(page.data(), pageLen), false, hexagon);
+}
+
+
+void Engine::searchBookPage(const std::string_view hexagon, const PackedCoordinate &coord, const ByteBuffer page) {
+    const std::string_view fitted = fitAddress(hexagon, options_.paddingScheme, minAddressLength(), digits_,
+                                               pool_.get(), options_.alphabet);
+    BABEL_STAGE(Stage::Decode, options_.pageLen);
+    decodeHexagon(fitted.data(), fitted.length(), static_cast<int>(coord.seed()), options_.pageLen, page.data(), high_,
+                  options_.alphabet);
+}
+
+
+void Engine::search(const std::string &address, std::vector<unsigned char> &page) {
+    resizeBuffer(page, options_.pageLen, Stage::Decode);
+    search(address, ByteBuffer(page));
+}
+
+
+size_t Engine::search(const std::string_view address, const ByteBuffer page) {
+    if (page.size() < options_.pageLen)
+        throw std::length_error("Page buffer holds "+std::to_string(page.size())+" of "+std::to_string(options_.pageLen)+" bytes");
+
+    if (options_.searchCache) {
+        const SharedPage cached = searchShared(address);
+        std::copy(cached->begin(), cached->end(), page.begin());
+    } else {
+        decodePage(address, page.data());
+    }
+    return options_.pageLen;
+}
+
+
+SharedPage Engine::searchShared(const std::string_view address) {
+    if (SharedPage cached = findCached(address)) return cached;
+    SearchCache* cache = options_.searchCache.get();
+
+    BABEL_ALLOCATION(Stage::Decode);
+    const auto page = std::make_shared<std::vector<unsigned char>>(options_.pageLen);
+    decodePage(address, page->data());
+    return cache ? cache->insert(address, options_.pageLen, options_.paddingScheme, options_.alphabet, page) : page;
+}
+
+
+SharedPage Engine::findCached(const std::string_view address) const {
+    if (!options_.searchCache) return nullptr;
+    return options_.searchCache->find(address, options_.pageLen, options_.paddingScheme, options_.alphabet);
+}
+
+
+void Engine::decodePage(const std::string_view address, unsigned char* page) {
+    const HexagonDecoder decoder = pageDecoder(address);
+    BABEL_STAGE(Stage::Decode, options_.pageLen);
+    // Decode the address base-encoded text to the text charset, a chunk at a time so cancelled work stops early
+    forEachChunk(pool_.get(), options_.pageLen, PARALLEL_CHUNK_LEN, [&](const size_t offset, const size_t len) {
+        for (size_t done = 0; done < len; done += STREAM_CHUNK_LEN) {
+            checkCancelled();
+            decoder.read(offset + done, std::min(len - done, STREAM_CHUNK_LEN), page + offset + done);
+        }
+    });
+}
+
+
+std::vector<unsigned char> Engine::search(const std::string &address) {
+    std::vector<unsigned char> page;
+    search(address, page);
+    return page;
+}
+
+
+void Engine::searchStream(const std::string &address, std::ostream &stream) {
+    if (options_.searchCache) {
+        // A cached page is already whole, so it is written at once
+        const SharedPage page = searchShared(address);
+        stream.write(reinterpret_cast<const char*>(page->data()), static_cast<std::streamsize>(page->size()));
+        return;
+    }
+
+    const HexagonDecoder decoder = pageDecoder(address);
+    BABEL_STAGE(Stage::Decode, options_.pageLen);
+    // Write each chunk as soon as it is decoded, so the start of the page is not held back by the rest of it
+    resizeBuffer(page_, std::min(options_.pageLen, STREAM_CHUNK_LEN), Stage::Decode);
+    for (size_t offset = 0; offset < options_.pageLen && stream; offset += page_.size()) {
+        checkCancelled();
+        const size_t len = std::min(page_.size(), options_.pageLen - offset);
+        decoder.read(offset, len, page_.data());
+        stream.write(reinterpret_cast<const char*>(page_.data()), static_cast<std::streamsize>(len));
+    }
+}
+
+
+HexagonDecoder Engine::rangeDecoder(const std::string_view address, std::optional<HexagonPadding> &padding) {
+    const ParsedAddress parsed = [&] {
+        BABEL_STAGE(Stage::ParseAddress, address.length());
+        return parseAddress(address);
+    }();
+
+    if (isZeroFilled(parsed.hexagon))
+        return {parsed.hexagon.data(), parsed.hexagon.length() - 1, static_cast<int>(parsed.coordinate.seed()),
+                options_.pageLen, high_, nullptr, options_.alphabet, true};
+
+    // Short hexagons are padded lazily, as most of the padding usually lies outside the range
+    const size_t minLen = minAddressLength();
+    if (parsed.hexagon.length() < minLen) padding.emplace(parsed.hexagon, options_.paddingScheme, minLen, options_.alphabet);
+    return {parsed.hexagon.data(), parsed.hexagon.length(), static_cast<int>(parsed.coordinate.seed()),
+            options_.pageLen, high_, padding ? &*padding : nullptr, options_.alphabet};
+}
+
+
+size_t Engine::rangeLength(const size_t offset, const size_t length) const {
+    if (offset > options_.pageLen)
+        throw std::out_of_range("Range starts at byte "+std::to_string(offset)+" of a "+std::to_string(options_.pageLen)+" byte page");
+    return std::min(length, options_.pageLen - offset);
+}
+
+
+std::vector<unsigned char> Engine::searchRange(const std::string &address, const size_t offset, const size_t length) {
+    std::vector<unsigned char> range(rangeLength(offset, length));
+    searchRange(address, offset, ByteBuffer(range));
+    return range;
+}
+
+
+size_t Engine::searchRange(const std::string_view address, const size_t offset, const ByteBuffer range) {
+    const size_t len = rangeLength(offset, range.size());
+    if (const SharedPage cached = findCached(address)) {
+        std::copy_n(cached->begin() + static_cast<long>(offset), len, range.begin());
+        return len;
+    }
+
+    std::optional<HexagonPadding> padding;
+    const HexagonDecoder decoder = rangeDecoder(address, padding);
+    BABEL_STAGE(Stage::Decode, len);
+    for (size_t done = 0; done < len; done += STREAM_CHUNK_LEN) {
+        checkCancelled();
+        decoder.read(offset + done, std::min(len - done, STREAM_CHUNK_LEN), range.data() + done);
+    }
+    return len;
+}
+
+
+void Engine::searchRangeStream(const std::string &address, const size_t offset, const size_t length, std::ostream &stream) {
+    const size_t len = rangeLength(offset, length);
+    if (const SharedPage cached = findCached(address)) {
+        stream.write(reinterpret_cast<const char*>(cached->data() + offset), static_cast<std::streamsize>(len));
+        return;
+    }
+
+    std::optional<HexagonPadding> padding;
+    const HexagonDecoder decoder = rangeDecoder(address, padding);
+    BABEL_STAGE(Stage::Decode, len);
+    resizeBuffer(page_, std::min(len, STREAM_CHUNK_LEN), Stage::Decode);
+    for (size_t done = 0; done < len && stream; done += page_.size()) {
+        checkCancelled();
+        const size_t pieceLen = std::min(page_.size(), len - done);
+        decoder.read(offset + done, pieceLen, page_.data());
+        stream.write(reinterpret_cast<const char*>(page_.data()), static_cast<std::streamsize>(pieceLen));
+    }
+}
+
+
+BatchEngine::BatchEngine(const BatchOptions &options) : options_(options) {
+    const size_t threads = options_.threads > 0 ? options_.threads : std::max(1u, std::thread::hardware_concurrency());
+    engines_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) engines_.emplace_back(options_.engine);
+    pool_ = std::make_unique<ThreadPool>(threads);
+}
+
+
+BatchEngine::~BatchEngine() = default;
+
+
+void BatchEngine::computeAddressBatch(const std::vector<std::vector<unsigned char>> &data, const bool padRandom,
+                                      std::vector<std::string> &addresses) {
+    addresses.resize(data.size());
+    pool_->parallelFor(data.size(), [&](const size_t worker, const size_t i) {
+        Engine& engine = engines_[worker];
+        if (options_.engine.seed) engine.seed(*options_.engine.seed + i);
+        engine.computeAddress(data[i], padRandom, addresses[i]);
+    });
+}
+
+
+std::vector<std::string> BatchEngine::computeAddressBatch(const std::vector<std::vector<unsigned char>> &data,
+                                                          const bool padRandom) {
+    std::vector<std::string> addresses;
+    computeAddressBatch(data, padRandom, addresses);
+    return addresses;
+}
+
+
+void BatchEngine::searchBatch(const std::vector<std::string> &addresses, std::vector<std::vector<unsigned char>> &pages) {
+    pages.resize(addresses.size());
+    pool_->parallelFor(addresses.size(), [&](const size_t worker, const size_t i) {
+        engines_[worker].search(addresses[i], pages[i]);
+    });
+}
+
+
+std::vector<std::vector<unsigned char>> BatchEngine::searchBatch(const std::vector<std::string> &addresses) {
+    std::vector<std::vector<unsigned char>> pages;
+    searchBatch(addresses, pages);
+    return pages;
+}
+
+
+std::vector<std::string> BatchEngine::computeFileAddressBatch(const std::vector<std::string> &paths, const bool padRandom) {
+    std::vector<std::string> addresses(paths.size());
+    pool_->parallelFor(paths.size(), [&](const size_t worker, const size_t i) {
+        Engine& engine = engines_[worker];
+        if (options_.engine.seed) engine.seed(*options_.engine.seed + i);
+        addresses[i] = engine.computeFileAddress(paths[i], padRandom);
+    });
+    return addresses;
+}
+
+
+void BatchEngine::searchToFileBatch(const std::vector<std::string> &addresses, const std::vector<std::string> &paths) {
+    if (paths.size() != addresses.size())
+        throw std::invalid_argument("Got "+std::to_string(paths.size())+" paths for "+std::to_string(addresses.size())+" addresses");
+    pool_->parallelFor(addresses.size(), [&](const size_t worker, const size_t i) {
+        engines_[worker].searchToFile(addresses[i], paths[i]);
+    });
+}
+
+
+std::string BatchEngine::computeBook(std::istream &data, std::ostream &book, const bool padRandom) {
+    const size_t pageLen = options_.engine.pageLen;
+    const size_t hexagonLen = maxHexagonLength(pageLen);
+    const std::optional<uint64_t>& seed = options_.engine.seed;
+
+    // Engines are only used by the workers, so books computed from several threads at once never share one
+    PackedCoordinate start;
+    pool_->parallelFor(1, [&](const size_t worker, size_t) {
+        if (seed) engines_[worker].seed(*seed);
+        start = engines_[worker].genRandomCoordinate();
+    });
+
+    const size_t window = BOOK_WINDOW_PAGES * engines_.size();
+    std::vector<unsigned char> pages(window * pageLen);
+    std::vector<char> hexagons(window * hexagonLen);
+    std::vector<size_t> dataLens(window);
+    std::vector<size_t> hexagonLens(window);
+    uint64_t length = 0;
+    for (size_t first = 0; ; first += window) {
+        // Read a window of pages, stopping at the first page the data does not fill
+        size_t count = 0;
+        bool ended = false;
+        while (count < window && !ended) {
+            dataLens[count] = readChunk(data, pages.data() + count * pageLen, pageLen);
+            ended = dataLens[count] < pageLen;
+            length += dataLens[count];
+            if (dataLens[count] > 0) count++;
+        }
+
+        pool_->parallelFor(count, [&](const size_t worker, const size_t i) {
+            Engine& engine = engines_[worker];
+            if (seed) engine.seed(*seed + first + i + 1);
+            const PackedCoordinate coord = PackedCoordinate::fromIndex(start.index() + first + i);
+            hexagonLens[i] = engine.encodeBookPage(coord, ByteBuffer(pages.data() + i * pageLen, pageLen), dataLens[i],
+                                                   padRandom, hexagons.data() + i * hexagonLen);
+        });
+        for (size_t i = 0; i < count; ++i) {
+            book.write(hexagons.data() + i * hexagonLen, static_cast<std::streamsize>(hexagonLens[i]));
+            book.put('\n');
+        }
+        if (ended) break;
+    }
+
+    char startText[MAX_COORDINATE_LEN];
+    return "book:"+std::to_string(length)+std::string(startText, formatCoordinate(start, startText));
+}
+
+
+void BatchEngine::searchBook(const std::string &manifest, std::istream &book, std::ostream &data) {
+    const BookManifest parsed = parseManifest(manifest);
+    const size_t pageLen = options_.engine.pageLen;
+    const uint64_t pageCount = (parsed.length + pageLen - 1) / pageLen;
+
+    const size_t window = BOOK_WINDOW_PAGES * engines_.size();
+    std::vector<unsigned char> pages(window * pageLen);
+    std::vector<std::string> hexagons(window);
+    for (uint64_t first = 0; first < pageCount; first += window) {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(window, pageCount - first));
+        for (size_t i = 0; i < count; ++i) {
+            if (!std::getline(book, hexagons[i]))
+                throw std::invalid_argument("Book ended after "+std::to_string(first + i)+" of "+std::to_string(pageCount)+" pages");
+        }
+
+        pool_->parallelFor(count, [&](const size_t worker, const size_t i) {
+            const PackedCoordinate coord = PackedCoordinate::fromIndex(parsed.start.index() + first + i);
+            engines_[worker].searchBookPage(hexagons[i], coord, ByteBuffer(pages.data() + i * pageLen, pageLen));
+        });
+        // The last page is cut back to the length of the data
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t offset = (first + i) * pageLen;
+            data.write(reinterpret_cast<const char*>(pages.data() + i * pageLen),
+                       static_cast<std::streamsize>(std::min<uint64_t>(pageLen, parsed.length - offset)));
+        }
+    }
 }
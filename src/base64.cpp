@@ -0,0 +1,226 @@
+#include "base64.h"
+#include "codec.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BABEL_BASE64_SSSE3
+#include <immintrin.h>
+#endif
+
+
+using namespace Babel;
+
+
+/**
+ * Encode whole three byte groups one at a time
+ * @param src The bytes to encode, the length must be a multiple of three
+ * @param len The number of bytes to encode
+ * @param dst The buffer to write the characters to
+ */
+template<typename Alphabet>
+void encodeBase64Scalar(const unsigned char* src, const size_t len, char* dst) {
+    constexpr std::string_view table = Alphabet::DIGITS;
+    for (size_t i = 0; i < len; i += 3) {
+        const unsigned int group = src[i] << 16 | src[i + 1] << 8 | src[i + 2];
+        *dst++ = table[group >> 18 & 63];
+        *dst++ = table[group >> 12 & 63];
+        *dst++ = table[group >> 6 & 63];
+        *dst++ = table[group & 63];
+    }
+}
+
+
+/**
+ * Decode whole four character groups one at a time
+ * @param src The characters to decode, the length must be a multiple of four
+ * @param len The number of characters to decode
+ * @param dst The buffer to write the bytes to
+ * @return The index of the first character outside the charset, or len if all characters were decoded
+ */
+template<typename Alphabet>
+size_t decodeBase64Scalar(const char* src, const size_t len, unsigned char* dst) {
+    constexpr const std::array<unsigned char, 256>& values = Codec<Alphabet>::VALUES;
+    for (size_t i = 0; i < len; i += 4) {
+        const unsigned char a = values[static_cast<unsigned char>(src[i])];
+        const unsigned char b = values[static_cast<unsigned char>(src[i + 1])];
+        const unsigned char c = values[static_cast<unsigned char>(src[i + 2])];
+        const unsigned char d = values[static_cast<unsigned char>(src[i + 3])];
+        if ((a | b | c | d) & 0xc0) {
+            for (size_t j = i;; ++j)
+                if (values[static_cast<unsigned char>(src[j])] == Codec<Alphabet>::INVALID) return j;
+        }
+
+        const unsigned int group = a << 18 | b << 12 | c << 6 | d;
+        *dst++ = group >> 16;
+        *dst++ = group >> 8;
+        *dst++ = group;
+    }
+    return len;
+}
+
+
+#ifdef BABEL_BASE64_SSSE3
+/**
+ * Encode twelve bytes at a time with SSSE3 shuffles, following Wojciech Muła's base64 kernel
+ * @param src The bytes to encode, the length must be a multiple of three
+ * @param len The number of bytes to encode
+ * @param dst The buffer to write the characters to
+ * @return The number of bytes that were encoded, the remainder is left to the scalar kernel
+ */
+template<typename Alphabet>
+__attribute__((target("ssse3")))
+size_t encodeBase64SSSE3(const unsigned char* src, const size_t len, char* dst) {
+    // Only the last two digits differ between the base64 alphabets, and each has its own entry in the shifts
+    constexpr char digit62 = Alphabet::DIGITS[62] - 62;
+    constexpr char digit63 = Alphabet::DIGITS[63] - 63;
+    const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m128i shiftLut = _mm_setr_epi8(
+        'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+        '0' - 52, '0' - 52, '0' - 52, digit62, digit63, 'A', 0, 0);
+
+    size_t i = 0;
+    // Each load reads sixteen bytes but only consumes twelve of them
+    for (; i + 16 <= len; i += 12, dst += 16) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+        // Spread each three byte group over four bytes, then move every 6-bit index into its own byte
+        in = _mm_shuffle_epi8(in, shuffle);
+        const __m128i hi = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        const __m128i lo = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(hi, lo);
+
+        // Translate each index to its character by adding the offset of its range in the charset
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        const __m128i isUpper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        range = _mm_or_si128(range, _mm_and_si128(isUpper, _mm_set1_epi8(13)));
+        const __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(shiftLut, range), indices);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), chars);
+    }
+    return i;
+}
+
+
+/**
+ * Decode sixteen characters at a time with SSSE3 shuffles, validating the charset with nibble lookup tables
+ * @param src The characters to decode, the length must be a multiple of four
+ * @param len The number of characters to decode
+ * @param dst The buffer to write the bytes to
+ * @return The number of characters that were decoded, stopping early at the first block with an invalid character
+ */
+template<typename Alphabet>
+__attribute__((target("ssse3")))
+size_t decodeBase64SSSE3(const char* src, const size_t len, unsigned char* dst) {
+    // Every character class sets a bit in both tables, so only characters within the charset give a zero intersection
+    const __m128i lutLo = _mm_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lutHi = _mm_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    size_t i = 0;
+    // Each store writes sixteen bytes but only twelve of them are decoded, so keep clear of the end of the output
+    for (; i + 24 <= len; i += 16, dst += 12) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if constexpr (Alphabet::DIGITS[62] != '+' || Alphabet::DIGITS[63] != '/') {
+            // Reject the standard last digits, then move this alphabet's last digits onto them for the standard tables
+            const __m128i standard = _mm_or_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('+')), _mm_cmpeq_epi8(in, _mm_set1_epi8('/')));
+            if (_mm_movemask_epi8(standard) != 0) break;
+            const __m128i is62 = _mm_cmpeq_epi8(in, _mm_set1_epi8(Alphabet::DIGITS[62]));
+            const __m128i is63 = _mm_cmpeq_epi8(in, _mm_set1_epi8(Alphabet::DIGITS[63]));
+            in = _mm_add_epi8(in, _mm_and_si128(is62, _mm_set1_epi8(static_cast<char>('+' - Alphabet::DIGITS[62]))));
+            in = _mm_add_epi8(in, _mm_and_si128(is63, _mm_set1_epi8(static_cast<char>('/' - Alphabet::DIGITS[63]))));
+        }
+        const __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+        const __m128i loNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+
+        const __m128i classes = _mm_and_si128(_mm_shuffle_epi8(lutLo, loNibbles), _mm_shuffle_epi8(lutHi, hiNibbles));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(classes, _mm_setzero_si128())) != 0xffff) break;
+
+        // Shift each character range onto its index, '/' being the only character sharing its nibble with another range
+        const __m128i isSlash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+        const __m128i indices = _mm_add_epi8(in, _mm_shuffle_epi8(lutRoll, _mm_add_epi8(isSlash, hiNibbles)));
+
+        // Merge the 6-bit indices into 24-bit groups and gather their bytes in big-endian order
+        const __m128i pairs = _mm_maddubs_epi16(indices, _mm_set1_epi32(0x01400140));
+        const __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi8(groups, pack));
+    }
+    return i;
+}
+#endif
+
+
+/**
+ * Check once whether the processor supports the vectorized kernels
+ */
+bool hasSSSE3() {
+#ifdef BABEL_BASE64_SSSE3
+    static const bool supported = __builtin_cpu_supports("ssse3");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+
+/**
+ * Encode whole three byte groups with the fastest kernel the processor supports
+ */
+template<typename Alphabet>
+void encodeBase64Groups(const unsigned char* src, const size_t len, char* dst) {
+    size_t done = 0;
+#ifdef BABEL_BASE64_SSSE3
+    if (hasSSSE3()) done = encodeBase64SSSE3<Alphabet>(src, len, dst);
+#endif
+    encodeBase64Scalar<Alphabet>(src + done, len - done, dst + done / 3 * 4);
+}
+
+
+/**
+ * Decode whole four character groups with the fastest kernel the processor supports
+ */
+template<typename Alphabet>
+size_t decodeBase64Groups(const char* src, const size_t len, unsigned char* dst) {
+    size_t done = 0;
+#ifdef BABEL_BASE64_SSSE3
+    if (hasSSSE3()) done = decodeBase64SSSE3<Alphabet>(src, len, dst);
+#endif
+    return done + decodeBase64Scalar<Alphabet>(src + done, len - done, dst + done / 4 * 3);
+}
+
+
+template<>
+void Codec<Base64Alphabet>::encode(const unsigned char* src, const size_t len, char* dst) {
+    encodeBase64Groups<Base64Alphabet>(src, len, dst);
+}
+
+
+template<>
+size_t Codec<Base64Alphabet>::decode(const char* src, const size_t len, unsigned char* dst) {
+    return decodeBase64Groups<Base64Alphabet>(src, len, dst);
+}
+
+
+template<>
+void Codec<Base64UrlAlphabet>::encode(const unsigned char* src, const size_t len, char* dst) {
+    encodeBase64Groups<Base64UrlAlphabet>(src, len, dst);
+}
+
+
+template<>
+size_t Codec<Base64UrlAlphabet>::decode(const char* src, const size_t len, unsigned char* dst) {
+    return decodeBase64Groups<Base64UrlAlphabet>(src, len, dst);
+}
+
+
+void Babel::encodeBase64(const unsigned char* src, const size_t len, char* dst, const AddressAlphabet alphabet) {
+    if (alphabet == AddressAlphabet::Base64Url) Codec<Base64UrlAlphabet>::encode(src, len, dst);
+    else Codec<Base64Alphabet>::encode(src, len, dst);
+}
+
+
+size_t Babel::decodeBase64(const char* src, const size_t len, unsigned char* dst, const AddressAlphabet alphabet) {
+    if (alphabet == AddressAlphabet::Base64Url) return Codec<Base64UrlAlphabet>::decode(src, len, dst);
+    return Codec<Base64Alphabet>::decode(src, len, dst);
+}
@@ -0,0 +1,34 @@
+#ifndef BABEL_BASE64_H
+#define BABEL_BASE64_H
+
+
+#include <cstddef>
+
+#include "babel_engine.h"
+
+namespace Babel {
+
+    /**
+     * Encode a sequence of bytes as base64 characters, without any '=' padding
+     * @param src The bytes to encode, the length must be a multiple of three
+     * @param len The number of bytes to encode
+     * @param dst The buffer to write to, must hold at least len / 3 * 4 characters
+     * @param alphabet The base64 alphabet to write the characters in
+     */
+    void encodeBase64(const unsigned char* src, size_t len, char* dst,
+                      AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+
+    /**
+     * Decode base64 characters into bytes, validating that every character is within the charset
+     * @param src The characters to decode, the length must be a multiple of four
+     * @param len The number of characters to decode
+     * @param dst The buffer to write to, must hold at least len / 4 * 3 bytes
+     * @param alphabet The base64 alphabet the characters are in
+     * @return The index of the first character outside the charset, or len if all characters were decoded
+     */
+    size_t decodeBase64(const char* src, size_t len, unsigned char* dst,
+                        AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+}
+
+#endif //BABEL_BASE64_H
@@ -0,0 +1,130 @@
+#ifndef BABEL_CODEC_H
+#define BABEL_CODEC_H
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string_view>
+
+#include "babel_engine.h"
+
+namespace Babel {
+
+    // The power-of-two alphabets, each giving the number of bits in a digit and the characters of the digits
+
+    struct Base16Alphabet {
+        static constexpr unsigned BITS = 4;
+        static constexpr std::string_view DIGITS = BASE16_DIGITS;
+    };
+
+    struct Base32Alphabet {
+        static constexpr unsigned BITS = 5;
+        static constexpr std::string_view DIGITS = BASE32_DIGITS;
+    };
+
+    struct Base64Alphabet {
+        static constexpr unsigned BITS = 6;
+        static constexpr std::string_view DIGITS = BASE64_DIGITS;
+    };
+
+    struct Base64UrlAlphabet {
+        static constexpr unsigned BITS = 6;
+        static constexpr std::string_view DIGITS = BASE64URL_DIGITS;
+    };
+
+
+    /**
+     * Encodes bytes as the digits of a power-of-two alphabet, and decodes them back, with tables built at compile time.
+     * Bytes are handled in groups, the fewest bytes that fill a whole number of digits, so every group of bytes maps to
+     * its own group of digits.  The base64 alphabets have vectorized kernels, the others unrolled scalar kernels.
+     */
+    template<typename Alphabet>
+    class Codec {
+    public:
+        static constexpr unsigned BITS = Alphabet::BITS;
+        static constexpr unsigned char MASK = (1u << BITS) - 1;
+        // The number of bytes and digits in a group
+        static constexpr size_t GROUP_BYTES = std::lcm(BITS, 8u) / 8;
+        static constexpr size_t GROUP_DIGITS = std::lcm(BITS, 8u) / BITS;
+        static constexpr unsigned char INVALID = 0xff;
+
+        static_assert(Alphabet::DIGITS.size() == 1u << BITS, "An alphabet needs a character for every digit");
+        static_assert(GROUP_BYTES <= sizeof(uint64_t), "A group must fit in a word");
+
+        // The value of every character, or INVALID for the characters outside the alphabet
+        static constexpr std::array<unsigned char, 256> VALUES = [] {
+            std::array<unsigned char, 256> values{};
+            for (unsigned char &value : values) value = INVALID;
+            for (size_t i = 0; i < Alphabet::DIGITS.size(); ++i)
+                values[static_cast<unsigned char>(Alphabet::DIGITS[i])] = static_cast<unsigned char>(i);
+            return values;
+        }();
+
+        /**
+         * Encode whole groups of bytes as digits
+         * @param src The bytes to encode, the length must be a multiple of GROUP_BYTES
+         * @param len The number of bytes to encode
+         * @param dst The buffer to write to, must hold at least len / GROUP_BYTES * GROUP_DIGITS characters
+         */
+        static void encode(const unsigned char* src, size_t len, char* dst);
+
+        /**
+         * Decode whole groups of digits into bytes, validating that every character is within the alphabet
+         * @param src The characters to decode, the length must be a multiple of GROUP_DIGITS
+         * @param len The number of characters to decode
+         * @param dst The buffer to write to, must hold at least len / GROUP_DIGITS * GROUP_BYTES bytes
+         * @return The index of the first character outside the alphabet, or len if all characters were decoded
+         */
+        static size_t decode(const char* src, size_t len, unsigned char* dst);
+    };
+
+
+    template<typename Alphabet>
+    void Codec<Alphabet>::encode(const unsigned char* src, const size_t len, char* dst) {
+        for (size_t i = 0; i < len; i += GROUP_BYTES, dst += GROUP_DIGITS) {
+            uint64_t group = 0;
+            for (size_t j = 0; j < GROUP_BYTES; ++j) group = group << 8 | src[i + j];
+            for (size_t j = GROUP_DIGITS; j-- > 0; group >>= BITS) dst[j] = Alphabet::DIGITS[group & MASK];
+        }
+    }
+
+
+    template<typename Alphabet>
+    size_t Codec<Alphabet>::decode(const char* src, const size_t len, unsigned char* dst) {
+        for (size_t i = 0; i < len; i += GROUP_DIGITS, dst += GROUP_BYTES) {
+            uint64_t group = 0;
+            unsigned char seen = 0;
+            for (size_t j = 0; j < GROUP_DIGITS; ++j) {
+                const unsigned char value = VALUES[static_cast<unsigned char>(src[i + j])];
+                seen |= value;
+                group = group << BITS | (value & MASK);
+            }
+            // Only INVALID sets bits above the digit
+            if (seen & ~MASK) {
+                for (size_t j = i;; ++j)
+                    if (VALUES[static_cast<unsigned char>(src[j])] == INVALID) return j;
+            }
+            for (size_t j = GROUP_BYTES; j-- > 0; group >>= 8) dst[j] = static_cast<unsigned char>(group);
+        }
+        return len;
+    }
+
+
+    /**
+     * Get the value of every character in an address alphabet, or Codec::INVALID for the characters outside it
+     */
+    inline const std::array<unsigned char, 256> &alphabetValues(const AddressAlphabet alphabet) {
+        return alphabet == AddressAlphabet::Base64Url ? Codec<Base64UrlAlphabet>::VALUES : Codec<Base64Alphabet>::VALUES;
+    }
+
+
+    // The base64 alphabets are specialized with vectorized kernels
+    template<> void Codec<Base64Alphabet>::encode(const unsigned char* src, size_t len, char* dst);
+    template<> size_t Codec<Base64Alphabet>::decode(const char* src, size_t len, unsigned char* dst);
+    template<> void Codec<Base64UrlAlphabet>::encode(const unsigned char* src, size_t len, char* dst);
+    template<> size_t Codec<Base64UrlAlphabet>::decode(const char* src, size_t len, unsigned char* dst);
+}
+
+#endif //BABEL_CODEC_H
@@ -0,0 +1,43 @@
+#ifndef BABEL_FITTING_H
+#define BABEL_FITTING_H
+
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "babel_engine.h"
+
+namespace Babel {
+
+    /**
+     * Ensure the length of the data is equal to the page length
+     * @param data The data to fit
+     * @param padRandom Whether to pad with random bytes, otherwise pad with zeros
+     * @param pageLen The number of bytes in a page
+     * @param rng The generator to draw the placement of the data from
+     * @param padding The generator to draw the random padding from
+     * @param result The vector to write the data padded or truncated to the page length to
+     */
+    void fitData(ByteView data, bool padRandom, size_t pageLen, std::mt19937_64& rng, PaddingGenerator& padding,
+                 std::vector<unsigned char>& result);
+
+
+    /**
+     * Ensure the length of the address greater than or equal to the minimum address length
+     * @param hexAddress The address to fit
+     * @param scheme The scheme used to generate the padding
+     * @param minAddressLen The minimum address length
+     * @param fitted Scratch space for the padded address
+     * @param pool The pool to spread the padding across, or null to generate it on the calling thread
+     * @param alphabet The alphabet the address is written in
+     * @return The address padded to the minimum address length
+     */
+    std::string_view fitAddress(std::string_view hexAddress, PaddingScheme scheme, size_t minAddressLen,
+                                std::string& fitted, ThreadPool* pool = nullptr,
+                                AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+}
+
+#endif //BABEL_FITTING_H
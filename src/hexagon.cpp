@@ -0,0 +1,418 @@
+#include "hexagon.h"
+#include "base64.h"
+#include "padding.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+
+static constexpr char ZERO_DIGIT = 'A';
+// The number of page bytes each thread encodes at a time, a whole number of groups
+static constexpr size_t PARALLEL_CHUNK_LEN = 3 * 1024 * 64;
+
+
+/**
+ * Report a character of an address that is not within the address charset
+ * @param val The invalid character
+ */
+[[noreturn]] void throwInvalidDigit(const char val) {
+    throw std::invalid_argument("Value not found in address charset: "+std::to_string(static_cast<unsigned char>(val)));
+}
+
+
+/**
+ * Decode a range of the three byte groups of a hexagon, whose digits are left-padded with zero digits to whole groups
+ * @param digits The base64 digits of the hexagon
+ * @param digitLen The number of digits in the hexagon
+ * @param firstGroup The index of the first group to decode
+ * @param groupCount The number of groups to decode
+ * @param dst The buffer to write the groupCount * 3 decoded bytes to
+ * @param alphabet The alphabet the digits are written in
+ */
+void decodeHexagonGroups(const char* digits, const size_t digitLen, size_t firstGroup, const size_t groupCount,
+                         unsigned char* dst, const Babel::AddressAlphabet alphabet) {
+    const size_t lead = (4 - digitLen % 4) % 4;
+    const size_t endGroup = firstGroup + groupCount;
+
+    if (firstGroup == 0 && lead > 0 && groupCount > 0) {
+        // The first group is partially made of the zero digits used for padding
+        char head[4] = {ZERO_DIGIT, ZERO_DIGIT, ZERO_DIGIT, ZERO_DIGIT};
+        std::memcpy(head + lead, digits, 4 - lead);
+        if (const size_t bad = Babel::decodeBase64(head, 4, dst, alphabet); bad < 4) throwInvalidDigit(head[bad]);
+        firstGroup++;
+        dst += 3;
+    }
+    if (firstGroup >= endGroup) return;
+
+    const char* src = digits + firstGroup * 4 - lead;
+    const size_t srcLen = (endGroup - firstGroup) * 4;
+    if (const size_t bad = Babel::decodeBase64(src, srcLen, dst, alphabet); bad < srcLen) throwInvalidDigit(src[bad]);
+}
+
+
+/**
+ * Compare a big-endian magnitude with a small value
+ * @return A negative number, zero, or a positive number if the magnitude is less than, equal to, or greater than the value
+ */
+int compareMagnitude(const std::vector<unsigned char>& mag, const uint64_t value) {
+    size_t i = 0;
+    while (i < mag.size() && mag[i] == 0) i++;
+    if (mag.size() - i > sizeof(uint64_t)) return 1;
+
+    uint64_t magValue = 0;
+    for (; i < mag.size(); ++i) magValue = magValue << 8 | mag[i];
+    return magValue < value ? -1 : magValue > value ? 1 : 0;
+}
+
+
+/**
+ * Add a small value to, or subtract it from, a big-endian magnitude in place
+ * @param mag The magnitude to modify, it must not be smaller than the value when subtracting
+ * @param value The value to add or subtract
+ * @param subtract Whether to subtract the value, otherwise add it
+ */
+void offsetMagnitude(std::vector<unsigned char>& mag, uint64_t value, const bool subtract) {
+    unsigned int carry = 0;
+    for (size_t i = mag.size(); i-- > 0 && (value > 0 || carry > 0);) {
+        const int digit = static_cast<int>(value & 0xff);
+        value >>= 8;
+        int byte = subtract ? mag[i] - digit - static_cast<int>(carry) : mag[i] + digit + static_cast<int>(carry);
+        carry = byte < 0 || byte > 0xff;
+        byte += subtract && carry ? 0x100 : 0;
+        mag[i] = static_cast<unsigned char>(byte);
+    }
+    // Only additions can overflow the magnitude
+    while (value > 0 || carry > 0) {
+        const unsigned int byte = (value & 0xff) + carry;
+        value >>= 8;
+        carry = byte > 0xff;
+        mag.insert(mag.begin(), static_cast<unsigned char>(byte));
+    }
+}
+
+
+size_t Babel::encodeHexagon(const unsigned int coordSeed, const unsigned char* page, const size_t pageLen, char* dst,
+                            ThreadPool* pool, const AddressAlphabet alphabet) {
+    HexagonEncoder encoder(coordSeed, pageLen, alphabet);
+    if (pool == nullptr || pageLen <= PARALLEL_CHUNK_LEN) {
+        const size_t len = encoder.write(page, pageLen, dst);
+        return len + encoder.finish(dst + len);
+    }
+
+    // Encode the groups holding the seed first, which settles how many leading zero digits are dropped
+    const size_t headLen = encoder.seedGroupBytes();
+    size_t len = encoder.write(page, headLen, dst);
+    if (len == 0) {
+        // The seed and the start of the page are all zeroes, which is too rare to be worth spreading out
+        len = encoder.write(page + headLen, pageLen - headLen, dst);
+        return len + encoder.finish(dst + len);
+    }
+
+    // The rest of the page is made of whole groups, each encoding to its own place in the hexagon
+    char* digits = dst + len;
+    const unsigned char* body = page + headLen;
+    forEachChunk(pool, pageLen - headLen, PARALLEL_CHUNK_LEN, [&](const size_t offset, const size_t chunkLen) {
+        encodeBase64(body + offset, chunkLen, digits + offset / 3 * 4, alphabet);
+    });
+    return len + (pageLen - headLen) / 3 * 4;
+}
+
+
+size_t Babel::encodeZeroFilledHexagon(const unsigned int coordSeed, const unsigned char* data, const size_t dataLen,
+                                      const size_t pageLen, char* dst, const AddressAlphabet alphabet) {
+    // Lay the seed out as the full-width hexagon does, completing its group with the first bytes of the page
+    unsigned char head[9] = {};
+    size_t headLen = (3 - (4 + pageLen) % 3) % 3;
+    head[headLen++] = coordSeed >> 24;
+    head[headLen++] = coordSeed >> 16;
+    head[headLen++] = coordSeed >> 8;
+    head[headLen++] = coordSeed;
+    const size_t headData = (3 - headLen % 3) % 3;
+    std::copy_n(data, std::min(headData, dataLen), head + headLen);
+    headLen += headData;
+    encodeBase64(head, headLen, dst, alphabet);
+    size_t len = headLen / 3 * 4;
+
+    // Then the data in whole groups, and the group split by its end, past which every digit is zero
+    if (dataLen > headData) {
+        const size_t body = dataLen - headData;
+        const size_t whole = body / 3 * 3;
+        encodeBase64(data + headData, whole, dst + len, alphabet);
+        len += whole / 3 * 4;
+        if (whole < body) {
+            unsigned char tail[3] = {};
+            std::copy_n(data + headData + whole, body - whole, tail);
+            encodeBase64(tail, 3, dst + len, alphabet);
+            len += 4;
+        }
+    }
+
+    while (len > 0 && dst[len - 1] == ZERO_DIGIT) len--;
+    if (len < maxHexagonLength(pageLen)) {
+        dst[len] = ZERO_FILL_MARK;
+        return len + 1;
+    }
+
+    // Nothing would be left out, so the hexagon is written as a full one
+    const size_t leading = std::find_if(dst, dst + len, [](const char c) { return c != ZERO_DIGIT; }) - dst;
+    std::memmove(dst, dst + leading, len - leading);
+    return len - leading;
+}
+
+
+Babel::HexagonEncoder::HexagonEncoder(const unsigned int coordSeed, const size_t pageLen, const AddressAlphabet alphabet)
+        : remaining_(pageLen), alphabet_(alphabet) {
+    // The seed takes four big-endian bytes, left-padded with zeroes so the digits line up with the lowest page byte
+    pendingLen_ = (3 - (4 + pageLen) % 3) % 3;
+    pending_[pendingLen_++] = coordSeed >> 24;
+    pending_[pendingLen_++] = coordSeed >> 16;
+    pending_[pendingLen_++] = coordSeed >> 8;
+    pending_[pendingLen_++] = coordSeed;
+}
+
+
+size_t Babel::HexagonEncoder::write(const unsigned char* data, size_t len, char* dst) {
+    len = std::min(len, remaining_);
+    remaining_ -= len;
+
+    size_t written = 0;
+    if (pendingLen_ > 0) {
+        // Complete the group left over from earlier bytes
+        const size_t take = std::min(len, (3 - pendingLen_ % 3) % 3);
+        std::memcpy(pending_ + pendingLen_, data, take);
+        pendingLen_ += take;
+        data += take;
+        len -= take;
+
+        const size_t whole = pendingLen_ / 3 * 3;
+        encodeBase64(pending_, whole, dst, alphabet_);
+        written += stripLeadingZeros(dst, whole / 3 * 4);
+        std::memmove(pending_, pending_ + whole, pendingLen_ - whole);
+        pendingLen_ -= whole;
+        if (pendingLen_ > 0) return written;
+    }
+
+    const size_t whole = len / 3 * 3;
+    encodeBase64(data, whole, dst + written, alphabet_);
+    written += stripLeadingZeros(dst + written, whole / 3 * 4);
+    std::memcpy(pending_, data + whole, len - whole);
+    pendingLen_ = len - whole;
+    return written;
+}
+
+
+size_t Babel::HexagonEncoder::finish(char* dst) {
+    if (remaining_ > 0 || pendingLen_ > 0) throw std::logic_error("Hexagon finished before the end of its page");
+    if (!leading_) return 0;
+
+    dst[0] = ZERO_DIGIT;  // Zero is zero in any base
+    return 1;
+}
+
+
+size_t Babel::HexagonEncoder::stripLeadingZeros(char* dst, const size_t len) {
+    if (!leading_) return len;
+
+    // Skip the leading zero digits, as numToBase() would never have produced them
+    const size_t skip = std::find_if(dst, dst + len, [](const char c) { return c != ZERO_DIGIT; }) - dst;
+    if (skip == len) return 0;
+    leading_ = false;
+    std::memmove(dst, dst + skip, len - skip);
+    return len - skip;
+}
+
+
+Babel::HexagonDecoder::HexagonDecoder(const char* hexagon, const size_t hexagonLen, const int coordSeed,
+                                      const size_t pageLen, std::vector<unsigned char>& high,
+                                      const HexagonPadding* padding, const AddressAlphabet alphabet,
+                                      const bool zeroFilled)
+        : padding_(padding), alphabet_(alphabet), high_(high) {
+    const bool isNeg = hexagonLen > 0 && hexagon[0] == alphabetSign(alphabet);
+    digits_ = hexagon + (isNeg ? 1 : 0);
+    hexagonDigits_ = hexagonLen - (isNeg ? 1 : 0);
+    digitLen_ = (padding ? std::max(padding->fittedLength(), hexagonLen) : hexagonLen) - (isNeg ? 1 : 0);
+    if (zeroFilled) {
+        if (hexagonDigits_ > maxHexagonLength(pageLen))
+            throw std::invalid_argument("Zero-filled hexagon is wider than a page: "+std::to_string(hexagonDigits_)+" digits");
+        digitLen_ = maxHexagonLength(pageLen);
+    }
+    numLen_ = (digitLen_ + 3) / 4 * 3;
+    pageLen_ = pageLen;
+
+    // Keep the bytes of the hexagon above the page aside, the bytes below it are decoded as they are read
+    if (numLen_ <= pageLen) high.clear();
+    else {
+        const size_t highLen = numLen_ - pageLen;
+        const size_t headGroups = (highLen + 2) / 3;
+        high.resize(headGroups * 3);
+        decodeGroups(0, headGroups, high.data());
+        high.resize(highLen);
+    }
+
+    // Subtract the seed from the bytes above the page, giving the signed multiple of 256^pageLen left in the number
+    const bool seedSubNeg = coordSeed > 0;
+    const uint64_t seedMag = coordSeed < 0 ? -static_cast<int64_t>(coordSeed) : coordSeed;
+    bool highNeg = isNeg;
+    if (isNeg == seedSubNeg) {
+        offsetMagnitude(high, seedMag, false);
+    } else if (compareMagnitude(high, seedMag) >= 0) {
+        offsetMagnitude(high, seedMag, true);
+    } else {
+        uint64_t highValue = 0;
+        for (const unsigned char c : high) highValue = highValue << 8 | c;
+        high.assign(sizeof(uint64_t), 0);
+        offsetMagnitude(high, seedMag - highValue, false);
+        highNeg = seedSubNeg;
+    }
+
+    // Only scan the low bytes when the sign of the number depends on them, which a computed address never needs
+    size_t firstLow = pageLen;
+    bool scanned = false;
+    const auto lowZero = [&] {
+        if (!scanned) firstLow = findLow(0, false);
+        scanned = true;
+        return firstLow == pageLen;
+    };
+
+    if (compareMagnitude(high, 0) == 0) highNeg = isNeg;
+    else if (highNeg != isNeg && !lowZero()) {
+        // Borrow from the bytes above the page, leaving 256^pageLen less the page below them
+        offsetMagnitude(high, 1, true);
+        borrow_ = true;
+        lastLow_ = findLow(0, true);
+    }
+
+    // Non-negative numbers that fit in the page are the page itself
+    highStart_ = std::find_if(high.begin(), high.end(), [](const unsigned char c) { return c != 0; }) - high.begin();
+    if (highStart_ == high.size() && (!highNeg || lowZero())) return;
+
+    // Otherwise keep the leading bytes of the signed number, as numToBase() would have
+    sign_ = highNeg;
+    prefixLen_ = std::min((highNeg ? 1 : 0) + high.size() - highStart_, pageLen);
+    if (highStart_ == high.size()) lowStart_ = borrow_ ? std::min(findLow(0xff, false), lastLow_) : firstLow;
+}
+
+
+void Babel::HexagonDecoder::read(size_t offset, size_t len, unsigned char* dst) const {
+    // The sign and the bytes above the page come first
+    for (; len > 0 && offset < prefixLen_; ++offset, --len)
+        *dst++ = sign_ && offset == 0 ? 45 : high_[highStart_ + offset - (sign_ ? 1 : 0)];
+    if (len == 0) return;
+
+    // Then the low bytes, shifted past the sign, the bytes above the page, and any leading zeroes
+    const size_t first = offset - prefixLen_ + lowStart_;
+    const size_t lowLen = first < pageLen_ ? std::min(len, pageLen_ - first) : 0;
+    readLow(first, lowLen, dst);
+    if (borrow_) {
+        for (size_t i = first; i < std::min(first + lowLen, lastLow_); ++i) dst[i - first] = ~dst[i - first];
+        if (lastLow_ >= first && lastLow_ < first + lowLen) dst[lastLow_ - first] = -dst[lastLow_ - first];
+    }
+    std::memset(dst + lowLen, 0, len - lowLen);
+}
+
+
+void Babel::HexagonDecoder::decodeGroups(size_t firstGroup, size_t groupCount, unsigned char* dst) const {
+    const size_t lead = (4 - digitLen_ % 4) % 4;
+    if (digitLen_ == hexagonDigits_ || (firstGroup + groupCount) * 4 - lead <= hexagonDigits_)
+        return decodeHexagonGroups(digits_, digitLen_, firstGroup, groupCount, dst, alphabet_);
+
+    if (padding_ == nullptr) {
+        // Zero-filled hexagons are whole groups wide, and their zero digits decode to zero bytes without a table
+        const size_t endGroup = firstGroup + groupCount;
+        size_t next = std::clamp(hexagonDigits_ / 4, firstGroup, endGroup);
+        decodeHexagonGroups(digits_, digitLen_, firstGroup, next - firstGroup, dst, alphabet_);
+        dst += (next - firstGroup) * 3;
+        if (hexagonDigits_ % 4 != 0 && next == hexagonDigits_ / 4 && next < endGroup) {
+            // The group split by the end of the hexagon
+            char group[4] = {ZERO_DIGIT, ZERO_DIGIT, ZERO_DIGIT, ZERO_DIGIT};
+            std::memcpy(group, digits_ + next * 4, hexagonDigits_ % 4);
+            if (const size_t bad = decodeBase64(group, 4, dst, alphabet_); bad < 4) throwInvalidDigit(group[bad]);
+            dst += 3;
+            next++;
+        }
+        std::memset(dst, 0, (endGroup - next) * 3);
+        return;
+    }
+
+    // Gather the digits of the groups from the hexagon and its padding, a piece at a time
+    constexpr size_t PIECE_GROUPS = 256;
+    char piece[PIECE_GROUPS * 4];
+    const size_t signLen = padding_->hexagonLength() - hexagonDigits_;
+    while (groupCount > 0) {
+        const size_t groups = std::min(groupCount, PIECE_GROUPS);
+        // The zero digits before the first digit only ever fall in the first group
+        const size_t zeros = firstGroup == 0 ? lead : 0;
+        const size_t first = firstGroup * 4 + zeros - lead;
+        const size_t len = groups * 4 - zeros;
+        const size_t real = first < hexagonDigits_ ? std::min(len, hexagonDigits_ - first) : 0;
+
+        std::fill_n(piece, zeros, ZERO_DIGIT);
+        std::memcpy(piece + zeros, digits_ + first, real);
+        padding_->generate(signLen + first + real, len - real, piece + zeros + real);
+        if (const size_t bad = decodeBase64(piece, groups * 4, dst, alphabet_); bad < groups * 4) throwInvalidDigit(piece[bad]);
+
+        firstGroup += groups;
+        groupCount -= groups;
+        dst += groups * 3;
+    }
+}
+
+
+void Babel::HexagonDecoder::readLow(size_t first, const size_t len, unsigned char* dst) const {
+    const size_t end = first + len;
+    // Hexagons shorter than the page are left-padded with zeroes
+    const size_t zeros = numLen_ < pageLen_ ? pageLen_ - numLen_ : 0;
+    if (first < zeros) {
+        const size_t n = std::min(end, zeros) - first;
+        std::memset(dst, 0, n);
+        dst += n;
+        first += n;
+    }
+    if (first >= end) return;
+
+    // Decode the whole groups straight into the output, and the groups split by the ends of the range aside
+    size_t pos = first + numLen_ - pageLen_;
+    const size_t posEnd = end + numLen_ - pageLen_;
+    unsigned char group[3];
+    if (pos % 3 != 0) {
+        decodeGroups(pos / 3, 1, group);
+        const size_t n = std::min(posEnd, pos / 3 * 3 + 3) - pos;
+        std::memcpy(dst, group + pos % 3, n);
+        dst += n;
+        pos += n;
+    }
+    const size_t wholeGroups = (posEnd - pos) / 3;
+    decodeGroups(pos / 3, wholeGroups, dst);
+    dst += wholeGroups * 3;
+    pos += wholeGroups * 3;
+    if (pos < posEnd) {
+        decodeGroups(pos / 3, 1, group);
+        std::memcpy(dst, group, posEnd - pos);
+    }
+}
+
+
+size_t Babel::HexagonDecoder::findLow(const unsigned char skip, const bool reverse) const {
+    unsigned char chunk[256];
+    for (size_t done = 0; done < pageLen_;) {
+        const size_t len = std::min(sizeof(chunk), pageLen_ - done);
+        const size_t first = reverse ? pageLen_ - done - len : done;
+        readLow(first, len, chunk);
+        for (size_t i = 0; i < len; ++i) {
+            const size_t j = reverse ? len - 1 - i : i;
+            if (chunk[j] != skip) return first + j;
+        }
+        done += len;
+    }
+    return pageLen_;
+}
+
+
+void Babel::decodeHexagon(const char* hexagon, const size_t hexagonLen, const int coordSeed, const size_t pageLen,
+                          unsigned char* page, std::vector<unsigned char>& high, const AddressAlphabet alphabet) {
+    HexagonDecoder(hexagon, hexagonLen, coordSeed, pageLen, high, nullptr, alphabet).read(0, pageLen, page);
+}
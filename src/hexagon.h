@@ -0,0 +1,189 @@
+#ifndef BABEL_HEXAGON_H
+#define BABEL_HEXAGON_H
+
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "babel_engine.h"
+
+namespace Babel {
+
+    class HexagonPadding;
+    class ThreadPool;
+
+
+    /**
+     * Encode the hexagon of a page, the base64 representation of the coordinate seed shifted above the page bytes
+     * @param coordSeed The seed of the library coordinate of the page
+     * @param page The bytes of the page
+     * @param pageLen The number of bytes in the page
+     * @param dst The buffer to write the hexagon to, must hold at least maxHexagonLength(pageLen) characters
+     * @param pool The pool to spread long pages across, or null to encode on the calling thread
+     * @param alphabet The alphabet to write the digits in
+     * @return The number of digits in the hexagon, which has no leading zero digits
+     */
+    size_t encodeHexagon(unsigned int coordSeed, const unsigned char* page, size_t pageLen, char* dst,
+                         ThreadPool* pool = nullptr, AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+
+    /**
+     * Encode the zero-filled hexagon of data padded with zeros to a page, the digits of the full-width hexagon with the
+     * zero digits that end it left out and ZERO_FILL_MARK in their place.  Hexagons that would not end in a zero digit
+     * are written in full instead, without their leading zero digits, as encodeHexagon() writes them.
+     * @param coordSeed The seed of the library coordinate of the page
+     * @param data The bytes at the start of the page
+     * @param dataLen The number of bytes of data, at most pageLen
+     * @param pageLen The number of bytes in the page
+     * @param dst The buffer to write the hexagon to, must hold at least maxHexagonLength(pageLen) characters
+     * @param alphabet The alphabet to write the digits in
+     * @return The number of characters in the hexagon
+     */
+    size_t encodeZeroFilledHexagon(unsigned int coordSeed, const unsigned char* data, size_t dataLen, size_t pageLen,
+                                   char* dst, AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+
+    /**
+     * Encodes the hexagon of a page incrementally, as the bytes of the page arrive in pieces of any size.  Each group of
+     * three bytes maps to four digits on its own, so only the bytes of an unfinished group are held between pieces.
+     */
+    class HexagonEncoder {
+    public:
+        /**
+         * @param coordSeed The seed of the library coordinate of the page
+         * @param pageLen The number of bytes in the page
+         * @param alphabet The alphabet to write the digits in
+         */
+        HexagonEncoder(unsigned int coordSeed, size_t pageLen, AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+        /**
+         * Get the maximum number of digits written by a single call to write()
+         * @param len The number of bytes being written
+         * @return The number of digits the output buffer must hold
+         */
+        static size_t maxDigits(const size_t len) { return (len + 2) / 3 * 4 + 8; }
+
+        /**
+         * Encode the next bytes of the page, bytes past the end of the page are ignored
+         * @param data The next bytes of the page
+         * @param len The number of bytes
+         * @param dst The buffer to write the digits to, must hold at least maxDigits(len) characters
+         * @return The number of digits written
+         */
+        size_t write(const unsigned char* data, size_t len, char* dst);
+
+        /**
+         * Get the number of page bytes needed to complete the groups holding the seed, after which every group of
+         * three page bytes lines up with four digits
+         */
+        [[nodiscard]] size_t seedGroupBytes() const { return std::min(remaining_, (3 - pendingLen_ % 3) % 3); }
+
+        /**
+         * Finish the hexagon once every byte of the page has been written
+         * @param dst The buffer to write any final digit to, must hold at least one character
+         * @return The number of digits written
+         */
+        size_t finish(char* dst);
+
+    private:
+        /**
+         * Drop the leading zero digits of the hexagon from newly encoded digits
+         * @return The number of digits kept
+         */
+        size_t stripLeadingZeros(char* dst, size_t len);
+
+        unsigned char pending_[8] = {};
+        size_t pendingLen_ = 0;
+        size_t remaining_;
+        AddressAlphabet alphabet_;
+        bool leading_ = true;
+    };
+
+
+    /**
+     * Decodes the page at a hexagon without big integers, reproducing the page numToBase() gives for the hexagon value
+     * less the coordinate seed shifted above the page.  The bytes above the page are resolved up front, after which any
+     * range of the page can be decoded on its own, so a page can be written out in pieces as it is decoded.  Given the
+     * padding of a short hexagon, only the padding digits under the ranges that are read are ever generated.
+     */
+    class HexagonDecoder {
+    public:
+        /**
+         * @param hexagon The fitted hexagon, optionally starting with the negative sign of its alphabet, which must
+         * outlive the decoder
+         * @param hexagonLen The number of characters in the hexagon
+         * @param coordSeed The seed of the library coordinate of the page
+         * @param pageLen The number of bytes in a page
+         * @param high Scratch space for the bytes of the hexagon above the page, which must outlive the decoder
+         * @param padding The padding of the hexagon, generated as it is read, or null if the hexagon is already fitted.
+         * It must outlive the decoder.
+         * @param alphabet The alphabet the hexagon is written in
+         * @param zeroFilled Whether the hexagon is zero-filled, its digits being followed by zero digits up to the
+         * full width of the page.  The hexagon is given without its ZERO_FILL_MARK.
+         * @throws std::invalid_argument If a zero-filled hexagon is wider than the page
+         */
+        HexagonDecoder(const char* hexagon, size_t hexagonLen, int coordSeed, size_t pageLen,
+                       std::vector<unsigned char>& high, const HexagonPadding* padding = nullptr,
+                       AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET, bool zeroFilled = false);
+
+        /**
+         * Decode a range of the page
+         * @param offset The index of the first byte of the page to decode
+         * @param len The number of bytes to decode, the range must lie within the page
+         * @param dst The buffer to write the len bytes to
+         */
+        void read(size_t offset, size_t len, unsigned char* dst) const;
+
+    private:
+        /**
+         * Decode a range of the three byte groups of the hexagon, generating any padding or zero digits they cover
+         */
+        void decodeGroups(size_t firstGroup, size_t groupCount, unsigned char* dst) const;
+
+        /**
+         * Decode a range of the low pageLen bytes of the hexagon value, before any borrow is applied to them
+         */
+        void readLow(size_t first, size_t len, unsigned char* dst) const;
+
+        /**
+         * Find the first, or last, of the low bytes of the hexagon value that differs from the given byte
+         * @return The index of the byte, or pageLen if every byte matches
+         */
+        size_t findLow(unsigned char skip, bool reverse) const;
+
+        const char* digits_;
+        size_t digitLen_;
+        // The digits past hexagonDigits_ are generated by padding_ when it is set, and are zero digits otherwise
+        size_t hexagonDigits_;
+        const HexagonPadding* padding_;
+        AddressAlphabet alphabet_;
+        size_t numLen_;
+        size_t pageLen_;
+        const std::vector<unsigned char>& high_;
+        // The signed number is written as an optional sign, the bytes of high_ from highStart_, then the low bytes
+        bool sign_ = false;
+        size_t highStart_ = 0;
+        size_t prefixLen_ = 0;
+        size_t lowStart_ = 0;
+        // The low bytes become 256^pageLen less themselves when borrowed from, which only changes bytes up to lastLow_
+        bool borrow_ = false;
+        size_t lastLow_ = 0;
+    };
+
+
+    /**
+     * Decode the whole page at a hexagon
+     * @param hexagon The fitted hexagon, optionally starting with the negative sign of its alphabet
+     * @param hexagonLen The number of characters in the hexagon
+     * @param coordSeed The seed of the library coordinate of the page
+     * @param pageLen The number of bytes in a page
+     * @param page The buffer to write the pageLen bytes of the page to
+     * @param high Scratch space for the bytes of the hexagon above the page
+     * @param alphabet The alphabet the hexagon is written in
+     */
+    void decodeHexagon(const char* hexagon, size_t hexagonLen, int coordSeed, size_t pageLen, unsigned char* page,
+                       std::vector<unsigned char>& high, AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+}
+
+#endif //BABEL_HEXAGON_H
@@ -0,0 +1,87 @@
+#include "instrumentation.h"
+
+#include <atomic>
+#include <memory>
+
+
+using namespace Babel;
+
+
+/**
+ * The counters of a stage, padded so stages recorded by different threads do not share cache lines
+ */
+struct alignas(64) StageCounters {
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> nanoseconds{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> allocations{0};
+};
+
+static StageCounters stageCounters[STAGE_COUNT];
+
+// The trace callback is swapped as a whole, so stages finishing on other threads never see a half-set callback
+static std::shared_ptr<const TraceCallback> traceCallback;
+static std::atomic<bool> tracing{false};
+
+
+const char* Babel::stageName(const Stage stage) {
+    switch (stage) {
+        case Stage::FitData: return "fitData";
+        case Stage::FitAddress: return "fitAddress";
+        case Stage::Encode: return "encode";
+        case Stage::AssembleAddress: return "assembleAddress";
+        case Stage::ParseAddress: return "parseAddress";
+        case Stage::Decode: return "decode";
+        case Stage::NumToBase: return "numToBase";
+        case Stage::BaseToNum: return "baseToNum";
+    }
+    return "unknown";
+}
+
+
+void Babel::recordStage(const Stage stage, const size_t bytes, const uint64_t nanoseconds) {
+    StageCounters& counters = stageCounters[static_cast<size_t>(stage)];
+    counters.calls.fetch_add(1, std::memory_order_relaxed);
+    counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    counters.bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    if (tracing.load(std::memory_order_acquire)) {
+        if (const std::shared_ptr<const TraceCallback> callback = std::atomic_load(&traceCallback))
+            (*callback)(stage, nanoseconds, bytes);
+    }
+}
+
+
+void Babel::recordAllocation(const Stage stage) {
+    stageCounters[static_cast<size_t>(stage)].allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+InstrumentationStats Babel::instrumentationStats() {
+    InstrumentationStats stats;
+    for (size_t i = 0; i < STAGE_COUNT; ++i) {
+        stats.stages[i].calls = stageCounters[i].calls.load(std::memory_order_relaxed);
+        stats.stages[i].nanoseconds = stageCounters[i].nanoseconds.load(std::memory_order_relaxed);
+        stats.stages[i].bytes = stageCounters[i].bytes.load(std::memory_order_relaxed);
+        stats.stages[i].allocations = stageCounters[i].allocations.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+
+void Babel::resetInstrumentation() {
+    for (StageCounters& counters : stageCounters) {
+        counters.calls.store(0, std::memory_order_relaxed);
+        counters.nanoseconds.store(0, std::memory_order_relaxed);
+        counters.bytes.store(0, std::memory_order_relaxed);
+        counters.allocations.store(0, std::memory_order_relaxed);
+    }
+}
+
+
+void Babel::setTraceCallback(TraceCallback callback) {
+    std::shared_ptr<const TraceCallback> shared;
+    if (callback) shared = std::make_shared<const TraceCallback>(std::move(callback));
+    tracing.store(shared != nullptr, std::memory_order_release);
+    std::atomic_store(&traceCallback, std::move(shared));
+}
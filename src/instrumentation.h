@@ -0,0 +1,75 @@
+#ifndef BABEL_INSTRUMENTATION_H
+#define BABEL_INSTRUMENTATION_H
+
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include "babel_engine.h"
+
+namespace Babel {
+
+    /**
+     * Add a finished stage to the counters, and pass it to the trace callback if one is set
+     * @param stage The stage that finished
+     * @param bytes The number of bytes the stage processed
+     * @param nanoseconds The time the stage took
+     */
+    void recordStage(Stage stage, size_t bytes, uint64_t nanoseconds);
+
+    /**
+     * Count a buffer allocated by the library during a stage
+     */
+    void recordAllocation(Stage stage);
+
+
+    /**
+     * Times a stage from its construction to its destruction
+     */
+    class StageTimer {
+    public:
+        StageTimer(const Stage stage, const size_t bytes) : stage_(stage), bytes_(bytes), start_(Clock::now()) {}
+
+        ~StageTimer() {
+            recordStage(stage_, bytes_, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start_).count());
+        }
+
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        Stage stage_;
+        size_t bytes_;
+        Clock::time_point start_;
+    };
+
+
+    /**
+     * Resize a buffer, counting an allocation for the stage if the buffer has to grow
+     */
+    template<typename Buffer>
+    void resizeBuffer(Buffer& buffer, const size_t len, [[maybe_unused]] const Stage stage) {
+#ifdef BABEL_INSTRUMENTATION
+        if (len > buffer.capacity()) recordAllocation(stage);
+#endif
+        buffer.resize(len);
+    }
+}
+
+
+#define BABEL_CONCAT_(a, b) a##b
+#define BABEL_CONCAT(a, b) BABEL_CONCAT_(a, b)
+
+// Time the rest of the enclosing scope as a stage, or do nothing unless instrumentation is compiled in
+#ifdef BABEL_INSTRUMENTATION
+#define BABEL_STAGE(stage, bytes) const ::Babel::StageTimer BABEL_CONCAT(babelStageTimer, __LINE__)(stage, bytes)
+#define BABEL_ALLOCATION(stage) ::Babel::recordAllocation(stage)
+#else
+#define BABEL_STAGE(stage, bytes) static_cast<void>(0)
+#define BABEL_ALLOCATION(stage) static_cast<void>(0)
+#endif
+
+#endif //BABEL_INSTRUMENTATION_H
@@ -0,0 +1,102 @@
+#include "mapped_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/**
+ * Throw the error of the last failed system call
+ * @param action What was being done when the call failed
+ * @param path The path of the file involved
+ */
+[[noreturn]] void throwSystemError(const std::string& action, const std::string& path) {
+    throw std::system_error(errno, std::generic_category(), "Could not "+action+" "+path);
+}
+
+
+/**
+ * Map an open file into memory, closing the descriptor either way since the mapping outlives it
+ * @param fd The descriptor of the file
+ * @param len The number of bytes to map, which must not be zero
+ * @param writable Whether writes to the mapping should reach the file
+ * @param path The path of the file, for errors
+ * @return The first byte of the mapping
+ */
+unsigned char* mapFile(const int fd, const size_t len, const bool writable, const std::string& path) {
+    void* data = mmap(nullptr, len, writable ? PROT_READ | PROT_WRITE : PROT_READ, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    const int mapError = errno;
+    close(fd);
+    if (data == MAP_FAILED) {
+        errno = mapError;
+        throwSystemError("map", path);
+    }
+    // Pages are encoded and decoded front to back, so the kernel can read ahead aggressively
+    madvise(data, len, MADV_SEQUENTIAL);
+    return static_cast<unsigned char*>(data);
+}
+
+
+Babel::MappedFile Babel::MappedFile::openForReading(const std::string& path, const size_t maxLen) {
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throwSystemError("open", path);
+
+    struct stat info{};
+    if (fstat(fd, &info) != 0) {
+        const int statError = errno;
+        close(fd);
+        errno = statError;
+        throwSystemError("stat", path);
+    }
+
+    const size_t len = std::min(static_cast<size_t>(info.st_size), maxLen);
+    if (len == 0) {
+        close(fd);
+        return {nullptr, 0};
+    }
+    return {mapFile(fd, len, false, path), len};
+}
+
+
+Babel::MappedFile Babel::MappedFile::createForWriting(const std::string& path, const size_t len) {
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throwSystemError("create", path);
+
+    if (ftruncate(fd, static_cast<off_t>(len)) != 0) {
+        const int truncateError = errno;
+        close(fd);
+        errno = truncateError;
+        throwSystemError("resize", path);
+    }
+
+    if (len == 0) {
+        close(fd);
+        return {nullptr, 0};
+    }
+    return {mapFile(fd, len, true, path), len};
+}
+
+
+Babel::MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+
+Babel::MappedFile& Babel::MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        if (data_ != nullptr) munmap(data_, size_);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+    }
+    return *this;
+}
+
+
+Babel::MappedFile::~MappedFile() {
+    if (data_ != nullptr) munmap(data_, size_);
+}
@@ -0,0 +1,59 @@
+#ifndef BABEL_MAPPED_FILE_H
+#define BABEL_MAPPED_FILE_H
+
+
+#include <cstddef>
+#include <string>
+
+namespace Babel {
+
+    /**
+     * A file mapped into memory, so its bytes can be encoded from or decoded into without reading or writing them
+     * through a buffer.  The mapping is released when the object is destroyed.
+     */
+    class MappedFile {
+    public:
+        /**
+         * Map the start of an existing file for reading
+         * @param path The path of the file
+         * @param maxLen The most bytes of the file to map
+         * @return The mapping, empty if the file is
+         * @throws std::system_error If the file cannot be opened or mapped
+         */
+        static MappedFile openForReading(const std::string& path, size_t maxLen);
+
+        /**
+         * Create or truncate a file of a given length and map it for writing
+         * @param path The path of the file
+         * @param len The length of the file
+         * @return The mapping, whose writes reach the file
+         * @throws std::system_error If the file cannot be created, sized or mapped
+         */
+        static MappedFile createForWriting(const std::string& path, size_t len);
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * Get the first byte of the mapping, null if it is empty
+         */
+        [[nodiscard]] unsigned char* data() const { return data_; }
+
+        /**
+         * Get the number of bytes mapped
+         */
+        [[nodiscard]] size_t size() const { return size_; }
+
+    private:
+        MappedFile(unsigned char* data, size_t size) : data_(data), size_(size) {}
+
+        unsigned char* data_ = nullptr;
+        size_t size_ = 0;
+    };
+}
+
+#endif //BABEL_MAPPED_FILE_H
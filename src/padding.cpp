@@ -0,0 +1,221 @@
+#include "padding.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+
+/**
+ * The leading outputs of a std::mt19937 seeded with a single value, computed without initializing and twisting the
+ * whole state.  The first 227 outputs only depend on the first 624 words of the seeded state, which can be generated on
+ * demand, so drawing one value costs roughly 400 steps of the seeding recurrence rather than a full state twist.
+ */
+class LeadingMersenneTwister {
+public:
+    using result_type = std::mt19937::result_type;
+
+    static constexpr result_type min() { return std::mt19937::min(); }
+    static constexpr result_type max() { return std::mt19937::max(); }
+
+    explicit LeadingMersenneTwister(const result_type seed) : seed_(seed) {
+        state_[0] = static_cast<uint32_t>(seed);
+    }
+
+    result_type operator()() {
+        const size_t i = drawn_++;
+        if (i >= LEADING_OUTPUTS) {
+            // Values past the untwisted part of the state are vanishingly rare, so defer to the full generator
+            if (!fallback_) {
+                fallback_.emplace(seed_);
+                fallback_->discard(i);
+            }
+            return (*fallback_)();
+        }
+
+        for (; seeded_ <= i + SHIFT_SIZE; ++seeded_)
+            state_[seeded_] = 1812433253u * (state_[seeded_ - 1] ^ state_[seeded_ - 1] >> 30) + static_cast<uint32_t>(seeded_);
+
+        // Twist a single word of the state, then temper it as std::mt19937 does
+        const uint32_t mixed = (state_[i] & 0x80000000u) | (state_[i + 1] & 0x7fffffffu);
+        uint32_t y = state_[i + SHIFT_SIZE] ^ mixed >> 1 ^ (mixed & 1u ? 0x9908b0dfu : 0u);
+        y ^= y >> 11;
+        y ^= y << 7 & 0x9d2c5680u;
+        y ^= y << 15 & 0xefc60000u;
+        y ^= y >> 18;
+        return y;
+    }
+
+private:
+    static constexpr size_t STATE_SIZE = 624;
+    static constexpr size_t SHIFT_SIZE = 397;
+    static constexpr size_t LEADING_OUTPUTS = STATE_SIZE - SHIFT_SIZE;
+
+    result_type seed_;
+    uint32_t state_[STATE_SIZE];
+    size_t seeded_ = 1;
+    size_t drawn_ = 0;
+    std::optional<std::mt19937> fallback_;
+};
+
+
+/**
+ * Hash a string with 64-bit FNV-1a, which unlike std::hash gives the same value on every platform
+ * @param str The string to hash
+ * @return The hash of the string
+ */
+uint64_t portableHash(const std::string_view str) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (const char c : str) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+
+/**
+ * Draw a word from a counter-based generator, the output of SplitMix64 for the given key and counter
+ * @param key The key of the generator
+ * @param counter The index of the word to draw
+ * @return The word at the given counter
+ */
+uint64_t counterWord(const uint64_t key, const uint64_t counter) {
+    uint64_t z = key + (counter + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ z >> 30) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ z >> 27) * 0x94d049bb133111ebull;
+    return z ^ z >> 31;
+}
+
+
+/**
+ * Store a word as eight little-endian bytes, so generated padding is the same on every platform
+ * @param dst The buffer to store the word in
+ * @param word The word to store
+ */
+void storeLittleEndian(unsigned char* dst, uint64_t word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    std::memcpy(dst, &word, sizeof(uint64_t));
+}
+
+
+/**
+ * Pad a hexagon by reseeding a Mersenne Twister with the std::hash of the hexagon for every character
+ */
+void generateLegacyPadding(const size_t addrSeed, const std::string_view charset, const size_t first, const size_t count,
+                           char* dst) {
+    std::uniform_int_distribution<> dist(0, 63);
+    for (size_t i = 0; i < count; i++) {
+        LeadingMersenneTwister gen(addrSeed + first + i);
+        dst[i] = charset[dist(gen)];
+    }
+}
+
+
+/**
+ * Pad a hexagon with characters taken eight at a time from a counter-based generator keyed by a portable hash
+ */
+void generateCounterPadding(const uint64_t key, const std::string_view charset, const size_t first, const size_t count,
+                            char* dst) {
+    size_t pos = first;
+    const size_t end = first + count;
+    // Each word gives the characters of eight consecutive positions, so any range can be generated independently
+    for (; pos < end && pos % 8 != 0; pos++) *dst++ = charset[counterWord(key, pos / 8) >> 8 * (pos % 8) & 63];
+    for (; pos + 8 <= end; pos += 8) {
+        const uint64_t word = counterWord(key, pos / 8);
+        for (int j = 0; j < 8; ++j) *dst++ = charset[word >> 8 * j & 63];
+    }
+    for (; pos < end; pos++) *dst++ = charset[counterWord(key, pos / 8) >> 8 * (pos % 8) & 63];
+}
+
+
+/**
+ * Write a hexagon in the standard alphabet, so its padding is keyed the same whichever alphabet it was written in
+ * @param hexagon The hexagon to rewrite
+ * @param alphabet The alphabet the hexagon is written in
+ * @return The hexagon in the standard alphabet
+ */
+std::string standardHexagon(const std::string_view hexagon, const Babel::AddressAlphabet alphabet) {
+    const std::string_view from = Babel::alphabetDigits(alphabet);
+    std::string standard(hexagon);
+    for (char &c : standard) {
+        if (c == Babel::alphabetSign(alphabet)) c = '-';
+        else if (c == from[62]) c = Babel::BASE64_DIGITS[62];
+        else if (c == from[63]) c = Babel::BASE64_DIGITS[63];
+    }
+    return standard;
+}
+
+
+Babel::HexagonPadding::HexagonPadding(const std::string_view hexagon, const PaddingScheme scheme, const size_t fittedLen,
+                                      const AddressAlphabet alphabet)
+        : hexagonLen_(hexagon.length()), fittedLen_(std::max(fittedLen, hexagon.length())), scheme_(scheme),
+          charset_(alphabetDigits(alphabet)) {
+    std::string standard;
+    if (alphabet != AddressAlphabet::Base64) standard = standardHexagon(hexagon, alphabet);
+    const std::string_view keyed = alphabet != AddressAlphabet::Base64 ? std::string_view(standard) : hexagon;
+
+    switch (scheme) {
+        case PaddingScheme::Legacy: key_ = std::hash<std::string_view>{}(keyed); return;
+        case PaddingScheme::Counter: key_ = portableHash(keyed); return;
+    }
+    throw std::invalid_argument("Invalid padding scheme: "+std::to_string(static_cast<int>(scheme)));
+}
+
+
+void Babel::HexagonPadding::generate(const size_t first, const size_t count, char* dst) const {
+    if (scheme_ == PaddingScheme::Legacy) generateLegacyPadding(key_, charset_, first, count, dst);
+    else generateCounterPadding(key_, charset_, first, count, dst);
+}
+
+
+void Babel::generateHexagonPadding(const std::string_view hexagon, const PaddingScheme scheme, const size_t first,
+                                   const size_t count, char* dst) {
+    HexagonPadding(hexagon, scheme, 0).generate(first, count, dst);
+}
+
+
+void Babel::CounterPaddingGenerator::seed(const uint64_t seed) {
+    key_ = seed;
+    counter_ = 0;
+}
+
+
+void Babel::CounterPaddingGenerator::fill(unsigned char* dst, const size_t len) {
+    // Keep the state in locals, as stores through dst could otherwise alias it and serialize the loop
+    const uint64_t key = key_;
+    const uint64_t counter = counter_;
+    const size_t words = len / sizeof(uint64_t);
+    for (size_t i = 0; i < words; ++i) {
+        const uint64_t word = counterWord(key, counter + i);
+        storeLittleEndian(dst + i * sizeof(uint64_t), word);
+    }
+    counter_ = counter + words;
+
+    // A partial word at the end uses up a whole word of the generator
+    if (words * sizeof(uint64_t) == len) return;
+    uint64_t word = counterWord(key, counter_++);
+    for (size_t i = words * sizeof(uint64_t); i < len; ++i, word >>= 8) dst[i] = static_cast<unsigned char>(word);
+}
+
+
+void Babel::MersennePaddingGenerator::seed(const uint64_t seed) {
+    rng_.seed(seed);
+}
+
+
+void Babel::MersennePaddingGenerator::fill(unsigned char* dst, const size_t len) {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        const uint64_t word = rng_();
+        std::memcpy(dst + i, &word, sizeof(uint64_t));
+    }
+    if (i == len) return;
+    for (uint64_t word = rng_(); i < len; ++i, word >>= 8) dst[i] = static_cast<unsigned char>(word);
+}
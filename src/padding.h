@@ -0,0 +1,67 @@
+#ifndef BABEL_PADDING_H
+#define BABEL_PADDING_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "babel_engine.h"
+
+namespace Babel {
+
+    /**
+     * The padding of a short hexagon, any range of which can be generated on its own.  The hash of the hexagon is taken
+     * once, so generating a few characters at a time costs no more than generating them all at once.
+     */
+    class HexagonPadding {
+    public:
+        /**
+         * @param hexagon The hexagon being padded, including any negative sign
+         * @param scheme The padding scheme to generate the characters with
+         * @param fittedLen The length of the hexagon once padded
+         * @param alphabet The alphabet the hexagon is written in, which the padding is generated in too.  The padding
+         * is keyed by the hexagon as written in the standard alphabet, so it has the same digits in every alphabet.
+         */
+        HexagonPadding(std::string_view hexagon, PaddingScheme scheme, size_t fittedLen,
+                       AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET);
+
+        /**
+         * Get the length of the hexagon before it is padded
+         */
+        [[nodiscard]] size_t hexagonLength() const { return hexagonLen_; }
+
+        /**
+         * Get the length of the hexagon once padded, which is never less than its unpadded length
+         */
+        [[nodiscard]] size_t fittedLength() const { return fittedLen_; }
+
+        /**
+         * Generate the characters used to pad the hexagon
+         * @param first The position of the first padding character to generate, at or after the end of the hexagon
+         * @param count The number of padding characters to generate
+         * @param dst The buffer to write the padding characters to
+         */
+        void generate(size_t first, size_t count, char* dst) const;
+
+    private:
+        size_t hexagonLen_;
+        size_t fittedLen_;
+        PaddingScheme scheme_;
+        std::string_view charset_;
+        uint64_t key_ = 0;
+    };
+
+
+    /**
+     * Generate the characters used to pad a hexagon that is shorter than the minimum address length
+     * @param hexagon The hexagon being padded
+     * @param scheme The padding scheme to generate the characters with
+     * @param first The position of the first padding character to generate, at or after the end of the hexagon
+     * @param count The number of padding characters to generate
+     * @param dst The buffer to write the padding characters to
+     */
+    void generateHexagonPadding(std::string_view hexagon, PaddingScheme scheme, size_t first, size_t count, char* dst);
+}
+
+#endif //BABEL_PADDING_H
@@ -0,0 +1,188 @@
+#include "babel_engine.h"
+#include "instrumentation.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+
+using namespace Babel;
+
+
+// The number of words below which a number is converted a word at a time rather than split by a power of the base
+constexpr size_t LEAF_WORDS = 16;
+
+
+Babel::RadixCodec::RadixCodec(const std::string_view charset) : charset_(charset) {
+    if (charset_.size() < 2 || charset_.size() > 256)
+        throw std::invalid_argument("Radix charsets need between 2 and 256 digits: "+std::to_string(charset_.size()));
+
+    std::fill(std::begin(values_), std::end(values_), -1);
+    for (size_t i = 0; i < charset_.size(); ++i) {
+        const auto c = static_cast<unsigned char>(charset_[i]);
+        if (values_[c] >= 0) throw std::invalid_argument("Radix charsets cannot repeat a digit: "+std::to_string(c));
+        values_[c] = static_cast<short>(i);
+    }
+    signed_ = values_[static_cast<unsigned char>('-')] < 0;
+
+    const unsigned long base = charset_.size();
+    wordBase_ = base;
+    wordDigits_ = 1;
+    while (wordBase_ <= ULONG_MAX / base) {
+        wordBase_ *= base;
+        wordDigits_++;
+    }
+    leafDigits_ = wordDigits_ * LEAF_WORDS;
+}
+
+
+void Babel::RadixCodec::cachePowers(const size_t levels) {
+    if (powers_.empty() && levels > 0) {
+        mpz_class power;
+        mpz_ui_pow_ui(power.get_mpz_t(), wordBase_, LEAF_WORDS);
+        powers_.push_back(std::move(power));
+    }
+    // Each power squares the last, doubling the digits it splits off
+    while (powers_.size() < levels) {
+        mpz_class power = powers_.back() * powers_.back();
+        powers_.push_back(std::move(power));
+    }
+}
+
+
+size_t Babel::RadixCodec::levelFor(const size_t digits) const {
+    size_t level = 0;
+    while ((leafDigits_ << level) < digits) level++;
+    return level;
+}
+
+
+void Babel::RadixCodec::writeDigits(const mpz_class& x, const size_t level, unsigned char* dst) const {
+    const size_t width = leafDigits_ << level;
+    if (x == 0) {
+        std::fill_n(dst, width, static_cast<unsigned char>(charset_[0]));
+        return;
+    }
+
+    if (level > 0) {
+        // The high half holds the leading digits and the low half the trailing ones, each a level down
+        mpz_class high, low;
+        mpz_tdiv_qr(high.get_mpz_t(), low.get_mpz_t(), x.get_mpz_t(), powers_[level - 1].get_mpz_t());
+        writeDigits(high, level - 1, dst);
+        writeDigits(low, level - 1, dst + width / 2);
+        return;
+    }
+
+    // Take a word of digits at a time off the bottom of the number
+    const unsigned long base = charset_.size();
+    mpz_class rest = x;
+    for (size_t word = LEAF_WORDS; word-- > 0;) {
+        unsigned long value = mpz_tdiv_q_ui(rest.get_mpz_t(), rest.get_mpz_t(), wordBase_);
+        unsigned char* wordDst = dst + word * wordDigits_;
+        for (size_t i = wordDigits_; i-- > 0;) {
+            wordDst[i] = charset_[value % base];
+            value /= base;
+        }
+    }
+}
+
+
+void Babel::RadixCodec::readDigits(const unsigned char* digits, const size_t len, size_t level, mpz_class& x) const {
+    // Digits that fit in the low half of a level need no split there
+    while (level > 0 && len <= leafDigits_ << (level - 1)) level--;
+
+    if (level > 0) {
+        const size_t half = leafDigits_ << (level - 1);
+        mpz_class low;
+        readDigits(digits, len - half, level - 1, x);
+        readDigits(digits + len - half, half, level - 1, low);
+        x *= powers_[level - 1];
+        x += low;
+        return;
+    }
+
+    // Gather a word of digits at a time, starting with the digits left over above the whole words
+    const unsigned long base = charset_.size();
+    x = 0;
+    size_t i = 0;
+    for (size_t wordLen = len % wordDigits_ == 0 ? wordDigits_ : len % wordDigits_; i < len; wordLen = wordDigits_) {
+        unsigned long value = 0;
+        unsigned long scale = 1;
+        for (const size_t end = i + wordLen; i < end; ++i) {
+            const short digit = values_[digits[i]];
+            if (digit < 0) throw std::invalid_argument("Value not found in address charset: "+std::to_string(digits[i]));
+            value = value * base + digit;
+            scale *= base;
+        }
+        mpz_mul_ui(x.get_mpz_t(), x.get_mpz_t(), scale);
+        mpz_add_ui(x.get_mpz_t(), x.get_mpz_t(), value);
+    }
+}
+
+
+std::vector<unsigned char> Babel::RadixCodec::numToBase(const mpz_class& x) {
+    if (x == 0) return {static_cast<unsigned char>(charset_[0])};  // Zero is zero in any base
+    if (x < 0 && !signed_) throw std::invalid_argument("Negative numbers have no sign in a charset containing '-'");
+
+    BABEL_STAGE(Stage::NumToBase, mpz_sizeinbase(x.get_mpz_t(), 256));
+    BABEL_ALLOCATION(Stage::NumToBase);
+
+    // Bound the digits of the number from its bits, then write it at the width of the first level that holds them
+    const double bitsPerDigit = std::log2(static_cast<double>(charset_.size()));
+    const size_t maxDigits = static_cast<size_t>(static_cast<double>(mpz_sizeinbase(x.get_mpz_t(), 2)) / bitsPerDigit) + 2;
+    const size_t level = levelFor(maxDigits);
+    cachePowers(level);
+
+    std::vector<unsigned char> digits(leafDigits_ << level);
+    writeDigits(abs(x), level, digits.data());
+
+    const auto first = std::find_if(digits.begin(), digits.end(), [&](const unsigned char c) { return c != charset_[0]; });
+    std::vector<unsigned char> chars;
+    chars.reserve(digits.end() - first + 1);
+    if (x < 0) chars.push_back(45);  // Add the negative sign
+    chars.insert(chars.end(), first, digits.end());
+    return chars;
+}
+
+
+mpz_class Babel::RadixCodec::baseToNum(const std::vector<unsigned char>& vec) {
+    const bool isNeg = signed_ && !vec.empty() && vec[0] == 45;
+    const unsigned char* digits = vec.data() + (isNeg ? 1 : 0);
+    const size_t len = vec.size() - (isNeg ? 1 : 0);
+    if (len == 0) return {0};
+
+    BABEL_STAGE(Stage::BaseToNum, vec.size());
+    const size_t level = levelFor(len);
+    cachePowers(level);
+
+    mpz_class x;
+    readDigits(digits, len, level, x);
+    return isNeg ? mpz_class(-x) : x;
+}
+
+
+/**
+ * Get the radix codec for a charset on the calling thread, which keeps the powers it has cached between calls
+ * @param charset The characters of the digits in order of their values
+ * @return The codec of the calling thread
+ */
+RadixCodec& threadRadixCodec(const std::string_view charset) {
+    thread_local std::map<std::string, RadixCodec, std::less<>> codecs;
+    auto it = codecs.find(charset);
+    if (it == codecs.end()) it = codecs.emplace(std::string(charset), RadixCodec(charset)).first;
+    return it->second;
+}
+
+
+std::vector<unsigned char> Babel::numToBase(const mpz_class& x, const std::string_view charset) {
+    return threadRadixCodec(charset).numToBase(x);
+}
+
+
+mpz_class Babel::baseToNum(const std::vector<unsigned char>& vec, const std::string_view charset) {
+    return threadRadixCodec(charset).baseToNum(vec);
+}
@@ -0,0 +1,221 @@
+#include "babel_engine.h"
+
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+
+using namespace Babel;
+
+
+/**
+ * The key of a cached page, the address along with the configuration of the engines that search it the same way
+ */
+struct CacheKey {
+    std::string_view address;
+    size_t pageLen;
+    PaddingScheme scheme;
+    AddressAlphabet alphabet;
+    uint64_t hash;
+
+    bool operator==(const CacheKey& other) const {
+        return hash == other.hash && pageLen == other.pageLen && scheme == other.scheme && alphabet == other.alphabet &&
+               address == other.address;
+    }
+};
+
+
+// Keys carry their hash, so the index never hashes an address again
+struct CacheKeyHash {
+    size_t operator()(const CacheKey& key) const { return key.hash; }
+};
+
+
+/**
+ * A cached page and the key it is cached under, or a free slot if it holds no page
+ */
+struct CacheEntry {
+    std::string address;
+    size_t pageLen = 0;
+    PaddingScheme scheme = DEFAULT_PADDING_SCHEME;
+    AddressAlphabet alphabet = DEFAULT_ADDRESS_ALPHABET;
+    uint64_t hash = 0;
+    SharedPage page;
+    size_t bytes = 0;
+    // Set by every hit, so the clock hand passes over the page once before evicting it
+    std::atomic<bool> referenced{false};
+};
+
+
+struct alignas(64) SearchCache::Shard {
+    std::shared_mutex mutex;
+    std::unordered_map<CacheKey, size_t, CacheKeyHash> index;
+    // Entries are never moved once created, so the index can view their addresses
+    std::deque<CacheEntry> entries;
+    std::vector<size_t> freeSlots;
+    size_t hand = 0;
+    size_t bytes = 0;
+    size_t capacity = 0;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+
+    /**
+     * Evict the first page the clock hand reaches whose reference bit is clear, clearing the bits it passes
+     */
+    void evictOne() {
+        while (true) {
+            if (hand >= entries.size()) hand = 0;
+            CacheEntry& entry = entries[hand++];
+            if (!entry.page || entry.referenced.exchange(false, std::memory_order_relaxed)) continue;
+
+            index.erase({entry.address, entry.pageLen, entry.scheme, entry.alphabet, entry.hash});
+            entry.page.reset();
+            bytes -= entry.bytes;
+            freeSlots.push_back(hand - 1);
+            evictions.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+};
+
+
+/**
+ * Rotate the bits of a word left
+ */
+constexpr uint64_t rotateLeft(const uint64_t word, const int bits) { return word << bits | word >> (64 - bits); }
+
+
+/**
+ * Hash the key of a cached page.  Addresses can be tens of KiB long, so they are hashed a word at a time in four
+ * independent lanes rather than a byte at a time.
+ * @return The hash of the key
+ */
+uint64_t hashKey(const std::string_view address, const size_t pageLen, const PaddingScheme scheme,
+                 const AddressAlphabet alphabet) {
+    constexpr uint64_t MULTIPLIER = 0x9e3779b97f4a7c15ull;
+    const uint64_t variant = static_cast<uint64_t>(scheme) << 8 | static_cast<uint64_t>(alphabet);
+    uint64_t lanes[4] = {pageLen, variant, address.size(), MULTIPLIER};
+    const char* data = address.data();
+    size_t len = address.size();
+    for (; len >= sizeof(lanes); data += sizeof(lanes), len -= sizeof(lanes)) {
+        for (int i = 0; i < 4; ++i) {
+            uint64_t word;
+            std::memcpy(&word, data + i * sizeof(word), sizeof(word));
+            lanes[i] = (lanes[i] ^ word) * MULTIPLIER;
+            lanes[i] ^= lanes[i] >> 32;
+        }
+    }
+
+    uint64_t hash = lanes[0] ^ rotateLeft(lanes[1], 16) ^ rotateLeft(lanes[2], 32) ^ rotateLeft(lanes[3], 48);
+    for (; len > 0; ++data, --len) hash = (hash ^ static_cast<unsigned char>(*data)) * MULTIPLIER;
+    // Mix the high bits into the low ones, which pick the shard and the bucket
+    hash ^= hash >> 31;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    return hash ^ hash >> 29;
+}
+
+
+SearchCache::SearchCache(const SearchCacheOptions &options) : options_(options) {
+    if (options_.shards == 0) throw std::invalid_argument("Search caches need at least one shard");
+    shards_ = std::make_unique<Shard[]>(options_.shards);
+    for (size_t i = 0; i < options_.shards; ++i) shards_[i].capacity = options_.capacity / options_.shards;
+}
+
+
+SearchCache::~SearchCache() = default;
+
+
+SearchCacheStats SearchCache::stats() const {
+    SearchCacheStats stats;
+    for (size_t i = 0; i < options_.shards; ++i) {
+        Shard& shard = shards_[i];
+        std::shared_lock lock(shard.mutex);
+        stats.hits += shard.hits.load(std::memory_order_relaxed);
+        stats.misses += shard.misses.load(std::memory_order_relaxed);
+        stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+        stats.entries += shard.index.size();
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
+
+
+void SearchCache::clear() {
+    for (size_t i = 0; i < options_.shards; ++i) {
+        Shard& shard = shards_[i];
+        std::unique_lock lock(shard.mutex);
+        shard.index.clear();
+        shard.entries.clear();
+        shard.freeSlots.clear();
+        shard.hand = 0;
+        shard.bytes = 0;
+    }
+}
+
+
+SearchCache::Shard &SearchCache::shardOf(const std::string_view address, const size_t pageLen, const PaddingScheme scheme,
+                                         const AddressAlphabet alphabet, uint64_t &hash) const {
+    hash = hashKey(address, pageLen, scheme, alphabet);
+    // The high bits pick the shard, leaving the low bits to pick the bucket within it
+    return shards_[(hash >> 48) % options_.shards];
+}
+
+
+SharedPage SearchCache::find(const std::string_view address, const size_t pageLen, const PaddingScheme scheme,
+                             const AddressAlphabet alphabet) {
+    uint64_t hash;
+    Shard& shard = shardOf(address, pageLen, scheme, alphabet, hash);
+    {
+        std::shared_lock lock(shard.mutex);
+        const auto it = shard.index.find({address, pageLen, scheme, alphabet, hash});
+        if (it != shard.index.end()) {
+            CacheEntry& entry = shard.entries[it->second];
+            entry.referenced.store(true, std::memory_order_relaxed);
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            return entry.page;
+        }
+    }
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+
+SharedPage SearchCache::insert(const std::string_view address, const size_t pageLen, const PaddingScheme scheme,
+                               const AddressAlphabet alphabet, SharedPage page) {
+    uint64_t hash;
+    Shard& shard = shardOf(address, pageLen, scheme, alphabet, hash);
+    const size_t bytes = page->size() + address.size();
+    if (bytes > shard.capacity) return page;
+
+    std::unique_lock lock(shard.mutex);
+    const auto it = shard.index.find({address, pageLen, scheme, alphabet, hash});
+    if (it != shard.index.end()) return shard.entries[it->second].page;
+
+    while (shard.bytes + bytes > shard.capacity) shard.evictOne();
+    size_t slot;
+    if (!shard.freeSlots.empty()) {
+        slot = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+    } else {
+        slot = shard.entries.size();
+        shard.entries.emplace_back();
+    }
+
+    CacheEntry& entry = shard.entries[slot];
+    entry.address.assign(address);
+    entry.pageLen = pageLen;
+    entry.scheme = scheme;
+    entry.alphabet = alphabet;
+    entry.hash = hash;
+    entry.page = std::move(page);
+    entry.bytes = bytes;
+    entry.referenced.store(false, std::memory_order_relaxed);
+    shard.index.emplace(CacheKey{entry.address, pageLen, scheme, alphabet, hash}, slot);
+    shard.bytes += bytes;
+    return entry.page;
+}
@@ -0,0 +1,176 @@
+#include "babel_engine.h"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BABEL_SHA256_SHANI
+#include <immintrin.h>
+#endif
+
+
+using namespace Babel;
+
+
+// The round constants of SHA-256, the fractional parts of the cube roots of the first 64 primes
+alignas(16) constexpr uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// The initial hash value of SHA-256, the fractional parts of the square roots of the first 8 primes
+constexpr uint32_t INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+
+constexpr uint32_t rotateRight(const uint32_t x, const int n) { return x >> n | x << (32 - n); }
+
+
+/**
+ * Compress whole 64 byte blocks into the hash state one round at a time
+ * @param state The eight words of the hash state
+ * @param blocks The blocks to compress
+ * @param count The number of blocks
+ */
+void compressBlocksScalar(uint32_t state[8], const unsigned char* blocks, size_t count) {
+    for (; count > 0; --count, blocks += 64) {
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i)
+            w[i] = static_cast<uint32_t>(blocks[i * 4]) << 24 | blocks[i * 4 + 1] << 16 | blocks[i * 4 + 2] << 8 | blocks[i * 4 + 3];
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ w[i - 15] >> 3;
+            const uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ w[i - 2] >> 10;
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t t1 = h + (rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25)) + ((e & f) ^ (~e & g)) +
+                                ROUND_CONSTANTS[i] + w[i];
+            const uint32_t t2 = (rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+
+#ifdef BABEL_SHA256_SHANI
+/**
+ * Compress whole 64 byte blocks into the hash state with the SHA extensions, four rounds per pair of instructions
+ * @param state The eight words of the hash state
+ * @param blocks The blocks to compress
+ * @param count The number of blocks
+ */
+__attribute__((target("sha,sse4.1")))
+void compressBlocksSHA(uint32_t state[8], const unsigned char* blocks, size_t count) {
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // The instructions hold the state as the words ABEF and CDGH
+    const __m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xb1);
+    const __m128i efgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1b);
+    __m128i abef = _mm_alignr_epi8(dcba, efgh, 8);
+    __m128i cdgh = _mm_blend_epi16(efgh, dcba, 0xf0);
+
+    for (; count > 0; --count, blocks += 64) {
+        const __m128i abefStart = abef;
+        const __m128i cdghStart = cdgh;
+
+        // Each message vector holds four words of the schedule, and the last four are kept to extend it
+        __m128i w[4];
+        for (int i = 0; i < 16; ++i) {
+            if (i < 4) {
+                w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + i * 16)), byteSwap);
+            } else {
+                const __m128i sum = _mm_add_epi32(_mm_sha256msg1_epu32(w[i & 3], w[(i + 1) & 3]),
+                                                  _mm_alignr_epi8(w[(i + 3) & 3], w[(i + 2) & 3], 4));
+                w[i & 3] = _mm_sha256msg2_epu32(sum, w[(i + 3) & 3]);
+            }
+
+            __m128i msg = _mm_add_epi32(w[i & 3], _mm_load_si128(reinterpret_cast<const __m128i*>(ROUND_CONSTANTS + i * 4)));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0e);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, msg);
+        }
+
+        abef = _mm_add_epi32(abef, abefStart);
+        cdgh = _mm_add_epi32(cdgh, cdghStart);
+    }
+
+    const __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+    const __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, dchg, 0xf0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(dchg, feba, 8));
+}
+#endif
+
+
+/**
+ * Check whether the processor supports the SHA extensions, once
+ */
+bool hasSHA() {
+#ifdef BABEL_SHA256_SHANI
+    static const bool supported = __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+
+/**
+ * Compress whole 64 byte blocks with the fastest kernel the processor supports
+ */
+void compressBlocks(uint32_t state[8], const unsigned char* blocks, const size_t count) {
+#ifdef BABEL_SHA256_SHANI
+    if (hasSHA()) {
+        compressBlocksSHA(state, blocks, count);
+        return;
+    }
+#endif
+    compressBlocksScalar(state, blocks, count);
+}
+
+
+ContentDigest Babel::sha256(const ByteView data) {
+    uint32_t state[8];
+    std::memcpy(state, INITIAL_STATE, sizeof(state));
+
+    const size_t whole = data.size() / 64;
+    compressBlocks(state, data.data(), whole);
+
+    // Pad the rest with a one bit, zeros and the bit length, which spill into a second block past 55 bytes
+    unsigned char tail[128] = {};
+    const size_t rest = data.size() - whole * 64;
+    if (rest > 0) std::memcpy(tail, data.data() + whole * 64, rest);
+    tail[rest] = 0x80;
+    const size_t tailLen = rest < 56 ? 64 : 128;
+    const uint64_t bits = static_cast<uint64_t>(data.size()) * 8;
+    for (int i = 0; i < 8; ++i) tail[tailLen - 1 - i] = static_cast<unsigned char>(bits >> i * 8);
+    compressBlocks(state, tail, tailLen / 64);
+
+    ContentDigest digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[i * 4] = static_cast<unsigned char>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<unsigned char>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<unsigned char>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<unsigned char>(state[i]);
+    }
+    return digest;
+}
@@ -0,0 +1,46 @@
+#include "task_queue.h"
+
+#include <stdexcept>
+#include <utility>
+
+
+Babel::TaskQueue::TaskQueue(const size_t threads) {
+    if (threads == 0) throw std::invalid_argument("Task queues need at least one thread");
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) workers_.emplace_back(&TaskQueue::run, this, i);
+}
+
+
+Babel::TaskQueue::~TaskQueue() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+
+void Babel::TaskQueue::push(std::function<void(size_t)> task) {
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+
+void Babel::TaskQueue::run(const size_t worker) {
+    while (true) {
+        std::function<void(size_t)> task;
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            // Workers only stop once the queue has drained
+            if (tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task(worker);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef BABEL_TASK_QUEUE_H
+#define BABEL_TASK_QUEUE_H
+
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Babel {
+
+    /**
+     * A fixed set of worker threads that run independent tasks in the order they were queued.  Unlike a ThreadPool,
+     * queueing a task never blocks, so the queue suits callers that must not wait on the work.
+     */
+    class TaskQueue {
+    public:
+        /**
+         * @param threads The number of worker threads, which must be at least one
+         */
+        explicit TaskQueue(size_t threads);
+
+        /**
+         * Run every task still queued, then stop the workers
+         */
+        ~TaskQueue();
+
+        TaskQueue(const TaskQueue&) = delete;
+        TaskQueue& operator=(const TaskQueue&) = delete;
+
+        /**
+         * Get the number of worker threads
+         */
+        [[nodiscard]] size_t size() const { return workers_.size(); }
+
+        /**
+         * Queue a task for the next free worker
+         * @param task The task to run, given the index of the worker running it
+         */
+        void push(std::function<void(size_t)> task);
+
+    private:
+        /**
+         * Run queued tasks until the queue is destroyed
+         */
+        void run(size_t worker);
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::deque<std::function<void(size_t)>> tasks_;
+        bool stopping_ = false;
+    };
+}
+
+#endif //BABEL_TASK_QUEUE_H
@@ -0,0 +1,115 @@
+#include "thread_pool.h"
+
+#include <stdexcept>
+#include <utility>
+
+
+Babel::ThreadPool::ThreadPool(const size_t threads) : slices_(new Slice[threads]) {
+    if (threads == 0) throw std::invalid_argument("Thread pools need at least one thread");
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) workers_.emplace_back(&ThreadPool::run, this, i);
+}
+
+
+Babel::ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+
+void Babel::ThreadPool::parallelFor(const size_t count, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    std::lock_guard job(jobMutex_);
+
+    // Every worker of the last job has finished, so the slices can be handed out without contention
+    const size_t threads = workers_.size();
+    for (size_t i = 0; i < threads; ++i) {
+        std::lock_guard lock(slices_[i].mutex);
+        slices_[i].begin = count * i / threads;
+        slices_[i].end = count * (i + 1) / threads;
+    }
+
+    std::unique_lock lock(mutex_);
+    body_ = &body;
+    active_ = threads;
+    generation_++;
+    wake_.notify_all();
+    done_.wait(lock, [this] { return active_ == 0; });
+
+    body_ = nullptr;
+    if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+
+void Babel::ThreadPool::run(const size_t worker) {
+    size_t seen = 0;
+    while (true) {
+        const std::function<void(size_t, size_t)>* body;
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) return;
+            seen = generation_;
+            body = body_;
+        }
+
+        size_t index;
+        while (next(worker, index)) {
+            try {
+                (*body)(worker, index);
+            } catch (...) {
+                std::lock_guard lock(mutex_);
+                if (!error_) error_ = std::current_exception();
+            }
+        }
+
+        std::lock_guard lock(mutex_);
+        if (--active_ == 0) done_.notify_all();
+    }
+}
+
+
+bool Babel::ThreadPool::next(const size_t worker, size_t& index) {
+    {
+        std::lock_guard lock(slices_[worker].mutex);
+        if (slices_[worker].begin < slices_[worker].end) {
+            index = slices_[worker].begin++;
+            return true;
+        }
+    }
+
+    while (true) {
+        // Find the worker with the most indices left
+        size_t victim = worker;
+        size_t most = 0;
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            std::lock_guard lock(slices_[i].mutex);
+            if (slices_[i].end - slices_[i].begin > most) {
+                victim = i;
+                most = slices_[i].end - slices_[i].begin;
+            }
+        }
+        if (most == 0) return false;
+
+        // Steal the back half of its slice, unless it was emptied in the meantime
+        size_t begin, end;
+        {
+            std::lock_guard lock(slices_[victim].mutex);
+            if (slices_[victim].begin == slices_[victim].end) continue;
+            end = slices_[victim].end;
+            begin = slices_[victim].begin + (end - slices_[victim].begin) / 2;
+            slices_[victim].end = begin;
+        }
+
+        std::lock_guard lock(slices_[worker].mutex);
+        slices_[worker].begin = begin + 1;
+        slices_[worker].end = end;
+        index = begin;
+        return true;
+    }
+}
+
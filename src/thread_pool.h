@@ -0,0 +1,101 @@
+#ifndef BABEL_THREAD_POOL_H
+#define BABEL_THREAD_POOL_H
+
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Babel {
+
+    /**
+     * A fixed set of worker threads that share out the indices of a job.  Each worker starts with an even slice of the
+     * indices, and a worker that runs out steals the back half of the largest slice left, so items of uneven cost
+     * still balance across the workers.  Jobs run one at a time, each using every worker.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * @param threads The number of worker threads, which must be at least one
+         */
+        explicit ThreadPool(size_t threads);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * Get the number of worker threads
+         */
+        [[nodiscard]] size_t size() const { return workers_.size(); }
+
+        /**
+         * Run a function for every index of a job, blocking until all of them have finished
+         * @param count The number of indices in the job
+         * @param body The function to run, given the index of the worker running it and the index of the item
+         * @throws The first exception thrown by the function, once every other index has run
+         */
+        void parallelFor(size_t count, const std::function<void(size_t, size_t)>& body);
+
+    private:
+        // The indices of a job left to a worker, padded so workers do not share cache lines
+        struct alignas(64) Slice {
+            std::mutex mutex;
+            size_t begin = 0;
+            size_t end = 0;
+        };
+
+        /**
+         * Run the jobs given to a worker until the pool is destroyed
+         */
+        void run(size_t worker);
+
+        /**
+         * Take the next index for a worker, stealing from another worker once its own slice is empty
+         * @return Whether an index was left in the job
+         */
+        bool next(size_t worker, size_t& index);
+
+        std::vector<std::thread> workers_;
+        std::unique_ptr<Slice[]> slices_;
+        std::mutex jobMutex_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        const std::function<void(size_t, size_t)>* body_ = nullptr;
+        size_t generation_ = 0;
+        size_t active_ = 0;
+        bool stopping_ = false;
+        std::exception_ptr error_;
+    };
+
+
+    /**
+     * Run a function over consecutive chunks of a range, spreading the chunks across a pool when there is more than one
+     * @param pool The pool to run the chunks on, or null to run them all on the calling thread
+     * @param len The length of the range
+     * @param chunkLen The length of every chunk but the last
+     * @param body The function to run, given the offset and length of a chunk
+     */
+    template<typename Body>
+    void forEachChunk(ThreadPool* pool, const size_t len, const size_t chunkLen, const Body& body) {
+        if (pool == nullptr || len <= chunkLen) {
+            if (len > 0) body(0, len);
+            return;
+        }
+
+        pool->parallelFor((len + chunkLen - 1) / chunkLen, [&](size_t, const size_t chunk) {
+            const size_t offset = chunk * chunkLen;
+            body(offset, std::min(chunkLen, len - offset));
+        });
+    }
+}
+
+#endif //BABEL_THREAD_POOL_H
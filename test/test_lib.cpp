@@ -2,22 +2,54 @@
 // Created by matthew on 8/10/24.
 //
 
+#include <atomic>
 #include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
 #include <strstream>
 
 #include <catch2/catch_test_macros.hpp>
 
 #include "babel_engine.h"
+#ifdef __linux__
+#include "protocol.h"
+#endif
+#ifdef BABEL_SERVER_PATH
+#include <csignal>
+#include <sys/wait.h>
+#endif
 
 
 using namespace Babel;
 
 
+// Count every allocation made by the tests, so steady-state loops can be checked for allocations
+static std::atomic<size_t> allocationCount{0};
+
+void* operator new(const std::size_t size) {
+    allocationCount++;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+
 class VectorStreamBuf final : public std::streambuf {
 public:
     explicit VectorStreamBuf(std::vector<unsigned char>& vec) : vec_(vec) {}
 
+    // The number of sequences written to the buffer at once
+    size_t writes = 0;
+
 protected:
     // Called when there is no space left in the buffer, forcing it to write to the vector.
     int overflow(const int ch) override {
@@ -29,6 +61,7 @@ protected:
     // Write a sequence of characters to the buffer
     std::streamsize xsputn(const char* s, const std::streamsize count) override {
         vec_.insert(vec_.end(), s, s + count);
+        writes++;
         return count;
     }
 
@@ -45,6 +78,17 @@ private:
     VectorStreamBuf buf_;
 };
 
+// An input stream that cannot seek, so its length is unknown until it has been read
+class UnseekableStreamBuf final : public std::streambuf {
+public:
+    explicit UnseekableStreamBuf(const std::string& data) : data_(data) {
+        setg(data_.data(), data_.data(), data_.data() + data_.size());
+    }
+
+private:
+    std::string data_;
+};
+
 TEST_CASE("Test getBaseCharset") {
 
     REQUIRE( getBaseCharset(64) == BASE64_CHARSET );
@@ -119,6 +163,34 @@ TEST_CASE("Test numToBase") {
         target = {'-', '\x4b'};
         REQUIRE( numToBase({-75}, base) == target);
     }
+
+    SECTION("Test Base 16") {
+        base = 16;
+        target = {'0'};
+        REQUIRE( numToBase({0}, base) == target);
+        target = {'F', 'F'};
+        REQUIRE( numToBase({255}, base) == target);
+        target = {'1', '0', '0'};
+        REQUIRE( numToBase({256}, base) == target);
+        target = {'-', 'A'};
+        REQUIRE( numToBase({-10}, base) == target);
+    }
+
+    SECTION("Test Base 32") {
+        base = 32;
+        target = {'A'};
+        REQUIRE( numToBase({0}, base) == target);
+        target = {'7'};
+        REQUIRE( numToBase({31}, base) == target);
+        target = {'B', 'A'};
+        REQUIRE( numToBase({32}, base) == target);
+        target = {'-', 'B', 'A', 'A'};
+        REQUIRE( numToBase({-1024}, base) == target);
+    }
+
+    SECTION("Test Invalid Base") {
+        REQUIRE_THROWS_AS( numToBase({1}, 10), std::invalid_argument );
+    }
 }
 
 
@@ -142,6 +214,105 @@ TEST_CASE("Test baseToNum") {
         REQUIRE( baseToNum({'\x11'}, base) == 17 );
         REQUIRE( baseToNum({'-', '\x4b'}, base) == -75 );
     }
+
+    SECTION("Test Base 16") {
+        base = 16;
+        REQUIRE( baseToNum({'0'}, base) == 0 );
+        REQUIRE( baseToNum({'F', 'F'}, base) == 255 );
+        REQUIRE( baseToNum({'1', '0', '0'}, base) == 256 );
+        REQUIRE( baseToNum({'-', 'A'}, base) == -10 );
+        REQUIRE_THROWS_AS( baseToNum({'1', 'f'}, base), std::invalid_argument );
+    }
+
+    SECTION("Test Base 32") {
+        base = 32;
+        REQUIRE( baseToNum({'A'}, base) == 0 );
+        REQUIRE( baseToNum({'7'}, base) == 31 );
+        REQUIRE( baseToNum({'B', 'A'}, base) == 32 );
+        REQUIRE( baseToNum({'-', 'B', 'A', 'A'}, base) == -1024 );
+        REQUIRE_THROWS_AS( baseToNum({'B', '1'}, base), std::invalid_argument );
+    }
+
+    SECTION("Test Round Trips") {
+        // Long numbers run through the whole groups of every codec, and the vectorized base64 kernels
+        mpz_class x = 1;
+        for (int i = 0; i < 300; ++i) x = x * 257 + i;
+        for (const int b : {16, 32, 64, 256}) {
+            REQUIRE( baseToNum(numToBase(x, b), b) == x );
+            REQUIRE( baseToNum(numToBase(-x, b), b) == -x );
+            REQUIRE( numToBase(x, b).front() != getBaseCharset(b)[0] );
+        }
+        std::vector<unsigned char> digits = numToBase(x, 64);
+        digits[digits.size() / 2] = '-';
+        REQUIRE_THROWS_AS( baseToNum(digits, 64), std::invalid_argument );
+    }
+}
+
+TEST_CASE("Test Radix Codec") {
+
+    auto toVec = [](const std::string& str) { return std::vector<unsigned char>(str.begin(), str.end()); };
+
+    SECTION("Test Known Values") {
+        REQUIRE( numToBase(mpz_class(0), BABEL_TEXT_DIGITS) == toVec("a") );
+        REQUIRE( numToBase(mpz_class(28), BABEL_TEXT_DIGITS) == toVec(".") );
+        REQUIRE( numToBase(mpz_class(29), BABEL_TEXT_DIGITS) == toVec("ba") );
+        REQUIRE( numToBase(mpz_class(-30), BABEL_TEXT_DIGITS) == toVec("-bb") );
+        REQUIRE( numToBase(mpz_class(57), BASE58_DIGITS) == toVec("z") );
+        REQUIRE( numToBase(mpz_class(58), BASE58_DIGITS) == toVec("21") );
+        REQUIRE( numToBase(mpz_class(84), BASE85_DIGITS) == toVec("u") );
+
+        REQUIRE( baseToNum(toVec("ba"), BABEL_TEXT_DIGITS) == 29 );
+        REQUIRE( baseToNum(toVec("aab"), BABEL_TEXT_DIGITS) == 1 );
+        REQUIRE( baseToNum(toVec("-bb"), BABEL_TEXT_DIGITS) == -30 );
+        REQUIRE( baseToNum(toVec("21"), BASE58_DIGITS) == 58 );
+        REQUIRE( baseToNum({}, BASE58_DIGITS) == 0 );
+    }
+
+    SECTION("Test Matching Other Conversions") {
+        // Numbers of many words run through several levels of splitting
+        mpz_class x;
+        mpz_ui_pow_ui(x.get_mpz_t(), 3, 100000);
+        x -= 1;
+        const std::string decimal = x.get_str(10);
+        REQUIRE( numToBase(x, "0123456789") == toVec(decimal) );
+        REQUIRE( baseToNum(toVec(decimal), "0123456789") == x );
+        REQUIRE( numToBase(-x, "0123456789") == toVec("-" + decimal) );
+
+        const std::string base62 = x.get_str(62);
+        constexpr std::string_view base62Digits = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+        REQUIRE( numToBase(x, base62Digits) == toVec(base62) );
+        REQUIRE( baseToNum(toVec(base62), base62Digits) == x );
+
+        for (const int b : {16, 32, 64})
+            REQUIRE( numToBase(x, std::string_view(reinterpret_cast<const char*>(getBaseCharset(b).data()), b)) == numToBase(x, b) );
+    }
+
+    SECTION("Test Page Round Trips") {
+        std::mt19937 gen(29);
+        std::vector<unsigned char> page(MAX_PAGE_LEN);
+        for (unsigned char& c : page) c = gen();
+        mpz_class x;
+        mpz_import(x.get_mpz_t(), page.size(), 1, 1, 1, 0, page.data());
+
+        for (const std::string_view charset : {BABEL_TEXT_DIGITS, BASE58_DIGITS, BASE85_DIGITS}) {
+            RadixCodec codec(charset);
+            const std::vector<unsigned char> digits = codec.numToBase(x);
+            REQUIRE( digits.front() != charset[0] );
+            REQUIRE( std::all_of(digits.begin(), digits.end(), [&](unsigned char c) { return charset.find(c) != std::string_view::npos; }) );
+            REQUIRE( codec.baseToNum(digits) == x );
+            REQUIRE( codec.baseToNum(digits) == baseToNum(digits, charset) );
+        }
+    }
+
+    SECTION("Test Radix Errors") {
+        REQUIRE_THROWS_AS( RadixCodec("a"), std::invalid_argument );
+        REQUIRE_THROWS_AS( RadixCodec("abca"), std::invalid_argument );
+        REQUIRE_THROWS_AS( baseToNum(toVec("abC"), BABEL_TEXT_DIGITS), std::invalid_argument );
+
+        // '-' is a digit of base85, so it has no negative sign
+        REQUIRE_THROWS_AS( numToBase(mpz_class(-1), BASE85_DIGITS), std::invalid_argument );
+        REQUIRE( baseToNum(toVec("-"), BASE85_DIGITS) == 12 );
+    }
 }
 
 TEST_CASE("Test getAddressComponents") {
@@ -181,6 +352,82 @@ void reverseStreamSearch(const std::string &searchStr) {
 }
 
 
+TEST_CASE("Test parseAddress") {
+
+    const ParsedAddress parsed = parseAddress("simpleaddress:2:4:04:300");
+    REQUIRE( parsed.hexagon == "simpleaddress" );
+    REQUIRE( parsed.coordinate == PackedCoordinate{2, 4, 4, 300} );
+    REQUIRE( parsed.coordinate.seed() == 3000442 );
+    REQUIRE( parseAddress("simpleaddress:2:4:4:300").coordinate == parsed.coordinate );
+
+    // Coordinates are numbered by wall, shelf, volume, then page
+    REQUIRE( PackedCoordinate{1, 1, 1, 1}.index() == 0 );
+    REQUIRE( PackedCoordinate{4, 5, 32, 410}.index() == COORDINATES_PER_HEXAGON - 1 );
+    REQUIRE( PackedCoordinate::fromIndex(parsed.coordinate.index()) == parsed.coordinate );
+    REQUIRE( PackedCoordinate::fromIndex(COORDINATES_PER_HEXAGON) == PackedCoordinate{} );
+
+    char text[MAX_COORDINATE_LEN];
+    REQUIRE( std::string(text, formatCoordinate(parsed.coordinate, text)) == ":2:4:04:300" );
+
+    for (const char* invalid : {"simpleaddress:2:4:4", "simpleaddress:5:4:4:300", "simpleaddress:0:4:4:300",
+                                "simpleaddress:02:4:4:300", "simpleaddress:2:4:4:0300", "simpleaddress:2:4:4:300:1",
+                                "simpleaddress:2:4: 4:300", "simpleaddress:2:4:4x:300", "simpleaddress:-2:4:4:300"})
+        REQUIRE_THROWS_AS( parseAddress(invalid), std::invalid_argument );
+
+    const std::string_view address = "simpleaddress:2:4:04:300";
+    const size_t before = allocationCount;
+    for (int i = 0; i < 10; ++i) parseAddress(address);
+    REQUIRE( allocationCount == before );
+}
+
+
+TEST_CASE("Test Packed Addresses") {
+
+    Engine engine(EngineOptions{});
+    std::vector<std::string> addresses = {"simpleaddress:2:4:04:300", "-simpleaddress:1:1:01:001", "abc:4:5:32:410",
+                                          "ab:3:2:10:099", "a:1:1:01:001", ":1:1:01:001", "-:2:2:02:002"};
+    for (const bool padRandom : {false, true})
+        addresses.push_back(engine.computeAddress(std::vector<unsigned char>(100, 7), padRandom));
+
+    for (const std::string& address : addresses) {
+        const std::vector<unsigned char> packed = packAddress(address);
+        const size_t hexagonLen = address.find(':') - (address[0] == '-' ? 1 : 0);
+        REQUIRE( packed.size() == packedAddressLength(hexagonLen) );
+        REQUIRE( unpackedAddressLength(ByteView(packed)) == address.size() );
+        REQUIRE( unpackAddress(ByteView(packed)) == address );
+    }
+
+    // Computed addresses pack into a quarter less space, whatever the page length
+    const std::string address = addresses.back();
+    REQUIRE( packAddress(address).size() <= address.size() * 3 / 4 + 8 );
+    REQUIRE( packAddress(address).size() <= maxPackedAddressLength(MAX_PAGE_LEN) );
+
+    // Unpadded coordinates unpack padded, to the same page
+    const std::vector<unsigned char> unpadded = packAddress("simpleaddress:2:4:4:300");
+    REQUIRE( unpackAddress(ByteView(unpadded)) == "simpleaddress:2:4:04:300" );
+
+    SECTION("Test Packed Address Errors") {
+        REQUIRE_THROWS_AS( packAddress("simple.address:2:4:4:300"), std::invalid_argument );
+        REQUIRE_THROWS_AS( packAddress("simpleaddress:5:4:4:300"), std::invalid_argument );
+
+        std::vector<unsigned char> small(packedAddressLength(13) - 1);
+        REQUIRE_THROWS_AS( packAddress("simpleaddress:2:4:4:300", ByteBuffer(small)), std::length_error );
+
+        std::vector<unsigned char> packed = packAddress("simpleaddress:2:4:4:300");
+        std::vector<char> smallAddress(unpackedAddressLength(ByteView(packed)) - 1);
+        REQUIRE_THROWS_AS( unpackAddress(ByteView(packed), CharBuffer(smallAddress)), std::length_error );
+
+        REQUIRE_THROWS_AS( unpackAddress(ByteView(packed.data(), 4)), std::invalid_argument );
+        REQUIRE_THROWS_AS( unpackAddress(ByteView(packed.data(), packed.size() - 1)), std::invalid_argument );
+        packed[0] |= 0x80;
+        REQUIRE_THROWS_AS( unpackAddress(ByteView(packed)), std::invalid_argument );
+        packed[0] &= 0x7f;
+        std::fill(packed.end() - 4, packed.end(), 0xff);
+        REQUIRE_THROWS_AS( unpackAddress(ByteView(packed)), std::invalid_argument );
+    }
+}
+
+
 TEST_CASE("Test Reverse Search") {
 
     std::string searchStr = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
@@ -220,6 +467,66 @@ TEST_CASE("Test Address Search Consistency") {
 }
 
 
+TEST_CASE("Test Padding Schemes") {
+
+    const std::string address = "simpleaddress:3:4:4:300";
+    const std::vector<unsigned char> legacyContent = search(address, PaddingScheme::Legacy);
+    const std::vector<unsigned char> counterContent = search(address, PaddingScheme::Counter);
+
+    REQUIRE( legacyContent == search(address, PaddingScheme::Legacy) );
+    // Legacy is the default, so short addresses stored by earlier versions resolve unchanged
+    REQUIRE( legacyContent == search(address) );
+    REQUIRE( legacyContent != counterContent );
+
+    // The counter scheme is portable, so its padding is the same on every platform
+    const std::vector<unsigned char> content = search("simpleaddress:2:4:4:300", PaddingScheme::Counter);
+    const std::vector<unsigned char> tail = {0x4b, 0x54, 0x7f, 0x6b, 0xc9, 0xed, 0x0c, 0xe9};
+    REQUIRE( std::vector<unsigned char>(content.end() - 8, content.end()) == tail );
+}
+
+
+/**
+ * Search an address the way the original implementation did, padding short hexagons by reseeding a std::mt19937 with
+ * the std::hash of the hexagon for every character
+ */
+std::vector<unsigned char> referenceLegacySearch(const std::string &address) {
+    const LibraryCoordinate coord = getAddressComponents(address);
+    std::vector<unsigned char> hexagonVec = {coord.hexagon.begin(), coord.hexagon.end()};
+
+    const size_t addrSeed = std::hash<std::string>{}(coord.hexagon);
+    std::uniform_int_distribution<> dist(0, 63);
+    hexagonVec.resize(MIN_ADDRESS_LEN, 0);
+    for (size_t i = coord.hexagon.length(); i < MIN_ADDRESS_LEN; i++) {
+        std::mt19937 gen(addrSeed + i);
+        hexagonVec[i] = BASE64_CHARSET_STR_[dist(gen)];
+    }
+
+    const mpz_class coordSeed = {std::stoi(coord.page + coord.volume + coord.shelf + coord.wall)};
+    const std::vector<unsigned char> reference = numToBase(baseToNum(hexagonVec, 64) - (coordSeed << (8 * MAX_PAGE_LEN)), 256);
+    return {reference.begin(), reference.begin() + MAX_PAGE_LEN};
+}
+
+
+TEST_CASE("Test Legacy Padding Matches Reference") {
+
+    std::string address;
+    SECTION("Test Word") {
+        address = "simpleaddress:3:4:4:300";
+    }
+    SECTION("Test Single Digit") {
+        address = "Q:1:1:01:001";
+    }
+    SECTION("Test Symbols") {
+        address = "Zz09+/Zz09+/:4:5:32:410";
+    }
+    SECTION("Test Negative Hexagon") {
+        address = "-hexagon:2:3:17:099";
+    }
+
+    REQUIRE( search(address, PaddingScheme::Legacy) == referenceLegacySearch(address) );
+}
+
+
 TEST_CASE("Test Content Search Consistency") {
 
     const std::string searchStr = "hello there general kenobi";
@@ -233,6 +540,117 @@ TEST_CASE("Test Content Search Consistency") {
 }
 
 
+/**
+ * Compute the hexagon of a page the way the original big integer implementation did
+ */
+std::string referenceHexagon(const std::vector<unsigned char> &page, const LibraryCoordinate &coord) {
+    mpz_class dataSum = {0};
+    mpz_import(dataSum.get_mpz_t(), page.size(), 1, 1, 1, 0, page.data());
+    const mpz_class coordSeed = {std::stoi(coord.page + coord.volume + coord.shelf + coord.wall)};
+    const std::vector<unsigned char> hexagon = numToBase((coordSeed << (8 * page.size())) + dataSum, 64);
+    return {hexagon.begin(), hexagon.end()};
+}
+
+
+TEST_CASE("Test Compute Address Matches Reference") {
+
+    std::vector<unsigned char> data;
+    SECTION("Test Text") {
+        const std::string searchStr = "hello there general kenobi";
+        data = {searchStr.begin(), searchStr.end()};
+    }
+    SECTION("Test Leading Zeroes") {
+        data = {0, 0, 0, 1, 2, 3};
+    }
+    SECTION("Test Full Page") {
+        data.resize(MAX_PAGE_LEN);
+        for (int i = 0; i < MAX_PAGE_LEN; ++i) data[i] = static_cast<unsigned char>(i * 131 + (i >> 8));
+    }
+
+    const std::string address = computeAddress(data, false);
+    const LibraryCoordinate coord = getAddressComponents(address);
+    std::vector<unsigned char> page(data);
+    page.resize(MAX_PAGE_LEN, 0);
+    REQUIRE( coord.hexagon == referenceHexagon(page, coord) );
+}
+
+
+TEST_CASE("Test Search Matches Reference") {
+
+    std::string hexagon;
+    for (int i = 0; i < MIN_ADDRESS_LEN + 9; ++i) hexagon += BASE64_CHARSET_STR_[(i * 37 + i / 5) % 64];
+
+    std::string address;
+    SECTION("Test Seed Above Page") {
+        address = hexagon + ":2:4:4:300";
+    }
+    SECTION("Test Seed Below Page") {
+        address = hexagon.substr(0, MIN_ADDRESS_LEN) + ":2:4:4:300";
+    }
+    SECTION("Test Negative Hexagon") {
+        address = "-" + hexagon + ":1:1:01:001";
+    }
+
+    const LibraryCoordinate coord = getAddressComponents(address);
+    const mpz_class coordSeed = {std::stoi(coord.page + coord.volume + coord.shelf + coord.wall)};
+    const std::vector<unsigned char> hexagonVec = {coord.hexagon.begin(), coord.hexagon.end()};
+    const std::vector<unsigned char> reference = numToBase(baseToNum(hexagonVec, 64) - (coordSeed << (8 * MAX_PAGE_LEN)), 256);
+
+    REQUIRE( search(address) == std::vector<unsigned char>(reference.begin(), reference.begin() + MAX_PAGE_LEN) );
+}
+
+
+TEST_CASE("Test Search Leading Zeroes") {
+
+    const std::vector<unsigned char> data = {0, 0, 7, 0, 9};
+    std::vector<unsigned char> content = search(computeAddress(data, false));
+    REQUIRE( content.size() == MAX_PAGE_LEN );
+    content.resize(data.size());
+    REQUIRE( content == data );
+}
+
+
+TEST_CASE("Test Search Stream") {
+
+    EngineOptions options;
+    options.seed = 42;
+    options.pageLen = 1024 * 40 + 1;
+    Engine engine(options);
+
+    std::string hexagon;
+    for (size_t i = 0; i < engine.minAddressLength() + 9; ++i) hexagon += BASE64_CHARSET_STR_[(i * 37 + i / 5) % 64];
+
+    const std::string searchStr = "hello there general kenobi";
+    const std::vector<std::string> addresses = {
+        engine.computeAddress({searchStr.begin(), searchStr.end()}, true),
+        "simpleaddress:2:4:4:300",
+        "-simpleaddress:1:1:01:001",
+        hexagon + ":2:4:4:300",
+        "-" + hexagon + ":1:1:01:001",
+        "A:1:1:01:001",
+    };
+
+    for (const std::string& address : addresses) {
+        std::vector<unsigned char> content;
+        VectorStreamBuf buf(content);
+        std::ostream stream(&buf);
+        engine.searchStream(address, stream);
+
+        // The page is written in several chunks rather than byte by byte or all at once
+        REQUIRE( content == engine.search(address) );
+        REQUIRE( buf.writes > 1 );
+        REQUIRE( buf.writes < 10 );
+    }
+}
+
+
+TEST_CASE("Test Search Invalid Address") {
+
+    REQUIRE_THROWS_AS( search("simple.address:2:4:4:300"), std::invalid_argument );
+    REQUIRE_THROWS_AS( search("simple-address:2:4:4:300"), std::invalid_argument );
+}
+
+
 TEST_CASE("Test Compute Address") {
 
     const std::string searchStr = "hello there general kenobi";
@@ -247,3 +665,1184 @@ TEST_CASE("Test Search") {
     const std::vector<unsigned char> content = search(address);
     REQUIRE( content.size() == MAX_PAGE_LEN );
 }
+
+
+// Pads data with a single repeated byte, so the padding of a page can be recognized
+class ConstantPaddingGenerator final : public PaddingGenerator {
+public:
+    void seed(uint64_t) override {}
+    void fill(unsigned char* dst, const size_t len) override { std::fill_n(dst, len, 0xab); }
+};
+
+
+TEST_CASE("Test Padding Generators") {
+
+    SECTION("Test Counter Generator") {
+        CounterPaddingGenerator whole;
+        whole.seed(42);
+        std::vector<unsigned char> wholeBytes(1000);
+        whole.fill(wholeBytes.data(), wholeBytes.size());
+
+        // The bytes are pinned, so seeded padding is the same on every platform
+        const std::vector<unsigned char> expected = {0x95, 0x6e, 0xeb, 0x2f, 0x26, 0x32, 0xd7, 0xbd, 0x03, 0xf1, 0x66, 0xb2};
+        REQUIRE( std::equal(expected.begin(), expected.end(), wholeBytes.begin()) );
+
+        // Filling in pieces of whole words gives the same bytes as filling at once
+        CounterPaddingGenerator pieces;
+        pieces.seed(42);
+        std::vector<unsigned char> pieceBytes(wholeBytes.size());
+        pieces.fill(pieceBytes.data(), 16);
+        pieces.fill(pieceBytes.data() + 16, 512);
+        pieces.fill(pieceBytes.data() + 528, 472);
+        REQUIRE( pieceBytes == wholeBytes );
+    }
+
+    SECTION("Test Custom Generator") {
+        EngineOptions options;
+        options.pageLen = 1024;
+        options.paddingGenerator = [] { return std::make_unique<ConstantPaddingGenerator>(); };
+        Engine engine(options);
+
+        const std::vector<unsigned char> data = {1, 2, 3, 4, 5};
+        const std::vector<unsigned char> page = engine.search(engine.computeAddress(data, true));
+        const auto dataStart = std::search(page.begin(), page.end(), data.begin(), data.end());
+        REQUIRE( dataStart != page.end() );
+        REQUIRE( std::count(page.begin(), page.end(), 0xab) == static_cast<long>(page.size() - data.size()) );
+    }
+
+    SECTION("Test Seeded Generators") {
+        for (const bool mersenne : {false, true}) {
+            EngineOptions options;
+            options.seed = 7;
+            options.pageLen = 1024 * 40 + 1;
+            if (mersenne) options.paddingGenerator = [] { return std::make_unique<MersennePaddingGenerator>(); };
+            Engine first(options);
+            Engine second(options);
+
+            const std::vector<unsigned char> data = {1, 2, 3, 4, 5};
+            const std::string address = first.computeAddress(data, true);
+            REQUIRE( address == second.computeAddress(data, true) );
+
+            // Reseeding replays the same coordinate and padding
+            first.seed(7);
+            REQUIRE( first.computeAddress(data, true) == address );
+        }
+    }
+}
+
+
+TEST_CASE("Test Caller Buffers") {
+
+    EngineOptions options;
+    options.seed = 42;
+    options.pageLen = 1024 * 40 + 1;
+    Engine viewEngine(options);
+    Engine vectorEngine(options);
+
+    const std::string searchStr = "hello there general kenobi";
+    const std::vector<unsigned char> data = {searchStr.begin(), searchStr.end()};
+    std::vector<char> addressBuffer(viewEngine.maxAddressLength());
+    std::vector<unsigned char> pageBuffer(viewEngine.pageLength());
+
+    for (const bool padRandom : {false, true}) {
+        // Encoding straight from a view gives the same address as the fitted copy of the data did
+        const size_t addressLen = viewEngine.computeAddress(ByteView(data), padRandom, CharBuffer(addressBuffer));
+        const std::string_view address(addressBuffer.data(), addressLen);
+        REQUIRE( address == vectorEngine.computeAddress(data, padRandom) );
+
+        REQUIRE( viewEngine.search(address, ByteBuffer(pageBuffer)) == pageBuffer.size() );
+        REQUIRE( pageBuffer == vectorEngine.search(std::string(address)) );
+    }
+
+    SECTION("Test Views Of Part Of A Buffer") {
+        const ByteView view = ByteView(data).subspan(6, 5);
+        REQUIRE( view.size() == 5 );
+        const size_t addressLen = viewEngine.computeAddress(view, false, CharBuffer(addressBuffer));
+        viewEngine.search({addressBuffer.data(), addressLen}, ByteBuffer(pageBuffer));
+        REQUIRE( std::equal(view.begin(), view.end(), pageBuffer.begin()) );
+    }
+
+    SECTION("Test Free Functions") {
+        std::vector<char> address(MAX_ADDRESS_LEN);
+        std::vector<unsigned char> page(MAX_PAGE_LEN);
+        const size_t addressLen = computeAddress(ByteView(data), false, CharBuffer(address));
+        REQUIRE( search({address.data(), addressLen}, ByteBuffer(page)) == static_cast<size_t>(MAX_PAGE_LEN) );
+        REQUIRE( std::equal(data.begin(), data.end(), page.begin()) );
+    }
+
+    SECTION("Test Small Buffers") {
+        std::vector<char> smallAddress(viewEngine.maxAddressLength() - 1);
+        std::vector<unsigned char> smallPage(viewEngine.pageLength() - 1);
+        REQUIRE_THROWS_AS( viewEngine.computeAddress(ByteView(data), false, CharBuffer(smallAddress)), std::length_error );
+        REQUIRE_THROWS_AS( viewEngine.search("simpleaddress:2:4:4:300", ByteBuffer(smallPage)), std::length_error );
+    }
+
+    SECTION("Test No Allocations") {
+        const std::string shortAddress = "simpleaddress:2:4:4:300";
+        viewEngine.search(shortAddress, ByteBuffer(pageBuffer));
+        const size_t before = allocationCount;
+        for (int i = 0; i < 10; ++i) {
+            const size_t addressLen = viewEngine.computeAddress(ByteView(data), true, CharBuffer(addressBuffer));
+            viewEngine.search({addressBuffer.data(), addressLen}, ByteBuffer(pageBuffer));
+            viewEngine.search(shortAddress, ByteBuffer(pageBuffer));
+        }
+        REQUIRE( allocationCount == before );
+    }
+}
+
+
+TEST_CASE("Test Engine") {
+
+    EngineOptions options;
+    options.seed = 1234;
+    Engine first(options);
+    Engine second(options);
+
+    const std::string searchStr = "hello there general kenobi";
+    const std::vector<unsigned char> data = {searchStr.begin(), searchStr.end()};
+
+    SECTION("Test Seeded Engines Agree") {
+        const std::string address = first.computeAddress(data, true);
+        REQUIRE( address == second.computeAddress(data, true) );
+        REQUIRE( first.search(address) == search(address) );
+    }
+
+    SECTION("Test Steady State Allocations") {
+        const std::string shortAddress = "simpleaddress:2:4:4:300";
+        std::string address;
+        std::vector<unsigned char> content;
+        first.computeAddress(data, true, address);
+        first.search(address, content);
+        first.search(shortAddress, content);
+
+        const size_t allocations = allocationCount;
+        for (int i = 0; i < 8; ++i) {
+            first.computeAddress(data, i % 2 == 0, address);
+            first.search(address, content);
+            first.search(shortAddress, content);
+        }
+        REQUIRE( allocationCount == allocations );
+        REQUIRE( std::search(content.begin(), content.end(), data.begin(), data.end()) == content.end() );
+    }
+}
+
+
+TEST_CASE("Test Page Lengths") {
+
+    const std::string searchStr = "hello there general kenobi";
+    const std::vector<unsigned char> data = {searchStr.begin(), searchStr.end()};
+
+    SECTION("Test Compile Time Page Length") {
+        Engine512 engine;
+        STATIC_REQUIRE( Engine512::MIN_ADDRESS_LEN == 682 );
+        REQUIRE( engine.pageLength() == 512 );
+
+        const std::string address = engine.computeAddress(data, true);
+        const std::vector<unsigned char> content = engine.search(address);
+        REQUIRE( getAddressComponents(address).hexagon.length() >= Engine512::MIN_ADDRESS_LEN );
+        REQUIRE( content.size() == 512 );
+        REQUIRE( std::search(content.begin(), content.end(), data.begin(), data.end()) != content.end() );
+        REQUIRE( engine.search("simpleaddress:2:4:4:300").size() == 512 );
+    }
+
+    SECTION("Test Runtime Page Length") {
+        EngineOptions options;
+        options.pageLen = 3 * 1024 * 1024 + 1;
+        Engine engine(options);
+
+        std::vector<unsigned char> page(options.pageLen);
+        for (size_t i = 0; i < page.size(); ++i) page[i] = static_cast<unsigned char>(i * 7 + (i >> 11));
+        const std::string address = engine.computeAddress(page, false);
+        REQUIRE( engine.search(address) == page );
+    }
+
+    SECTION("Test Small Pages") {
+        for (size_t pageLen = 1; pageLen <= 6; ++pageLen) {
+            EngineOptions options;
+            options.pageLen = pageLen;
+            Engine engine(options);
+            const std::vector<unsigned char> page(data.begin(), data.begin() + static_cast<long>(pageLen));
+            REQUIRE( engine.search(engine.computeAddress(page, false)) == page );
+        }
+    }
+
+    SECTION("Test Empty Page") {
+        EngineOptions options;
+        options.pageLen = 0;
+        REQUIRE_THROWS_AS( Engine(options), std::invalid_argument );
+    }
+}
+
+
+TEST_CASE("Test Stream Address") {
+
+    EngineOptions options;
+    options.seed = 42;
+    options.pageLen = 1024 * 40 + 1;
+
+    // Whitespace must survive streaming, as it is part of the data
+    std::string data = "hello there\n\tgeneral kenobi ";
+
+    for (const bool padRandom : {false, true}) {
+        Engine memoryEngine(options);
+        Engine streamEngine(options);
+
+        std::istringstream seekable(data);
+        REQUIRE( streamEngine.computeStreamAddress(seekable, padRandom) == memoryEngine.computeAddress({data.begin(), data.end()}, padRandom) );
+
+        UnseekableStreamBuf buf(data);
+        std::istream unseekable(&buf);
+        std::ostringstream address;
+        streamEngine.computeStreamAddress(unseekable, address, padRandom);
+        REQUIRE( address.str() == memoryEngine.computeAddress({data.begin(), data.end()}, padRandom) );
+
+        // Data past the end of the page is truncated
+        std::string longData = data;
+        longData.resize(options.pageLen + 100, 'x');
+        std::istringstream longStream(longData);
+        const std::string longAddress = streamEngine.computeStreamAddress(longStream, padRandom);
+        REQUIRE( longAddress == memoryEngine.computeAddress({longData.begin(), longData.end()}, padRandom) );
+        REQUIRE( streamEngine.search(longAddress) == std::vector<unsigned char>(longData.begin(), longData.begin() + static_cast<long>(options.pageLen)) );
+    }
+}
+
+
+TEST_CASE("Test Batch") {
+
+    BatchOptions options;
+    options.engine.seed = 42;
+    options.engine.pageLen = 1024;
+    options.threads = 4;
+    BatchEngine batchEngine(options);
+    REQUIRE( batchEngine.threadCount() == 4 );
+
+    // Inputs of uneven lengths, so workers finish their slices at different times
+    std::vector<std::vector<unsigned char>> data(101);
+    for (size_t i = 0; i < data.size(); ++i)
+        for (size_t j = 0; j < i * 7 % 300; ++j) data[i].push_back(static_cast<unsigned char>(i + j));
+
+    for (const bool padRandom : {false, true}) {
+        const std::vector<std::string> addresses = batchEngine.computeAddressBatch(data, padRandom);
+        REQUIRE( addresses.size() == data.size() );
+
+        // Each address is the one an engine seeded for its index computes, in the order of the inputs
+        for (size_t i = 0; i < data.size(); ++i) {
+            EngineOptions engineOptions = options.engine;
+            engineOptions.seed = *options.engine.seed + i;
+            REQUIRE( addresses[i] == Engine(engineOptions).computeAddress(data[i], padRandom) );
+        }
+
+        const std::vector<std::vector<unsigned char>> pages = batchEngine.searchBatch(addresses);
+        REQUIRE( pages.size() == addresses.size() );
+        Engine engine(options.engine);
+        for (size_t i = 0; i < pages.size(); ++i) REQUIRE( pages[i] == engine.search(addresses[i]) );
+    }
+
+    SECTION("Test Batch Errors") {
+        const std::vector<std::string> addresses = {"simpleaddress:2:4:4:300", "simpleaddress:5:4:4:300"};
+        REQUIRE_THROWS_AS( batchEngine.searchBatch(addresses), std::invalid_argument );
+        REQUIRE( batchEngine.searchBatch({addresses[0]}).size() == 1 );
+    }
+
+    SECTION("Test Free Batch Functions") {
+        const std::vector<std::string> addresses = computeAddressBatch({data[3], data[4]}, false);
+        const std::vector<std::vector<unsigned char>> pages = searchBatch(addresses);
+        REQUIRE( pages.size() == 2 );
+        REQUIRE( pages[0] == search(addresses[0]) );
+        REQUIRE( std::equal(data[4].begin(), data[4].end(), pages[1].begin()) );
+    }
+}
+
+
+// A stream buffer that cancels a token as soon as it is read from or written to
+class CancellingStreamBuf final : public std::streambuf {
+public:
+    CancellingStreamBuf(CancellationToken token, const std::string& data) : token_(std::move(token)), data_(data) {
+        setg(data_.data(), data_.data(), data_.data() + data_.size());
+    }
+
+    // The number of bytes written before the work stopped
+    size_t written = 0;
+
+protected:
+    std::streamsize xsgetn(char* s, const std::streamsize count) override {
+        token_.cancel();
+        return std::streambuf::xsgetn(s, count);
+    }
+
+    std::streamsize xsputn(const char*, const std::streamsize count) override {
+        token_.cancel();
+        written += count;
+        return count;
+    }
+
+private:
+    CancellationToken token_;
+    std::string data_;
+};
+
+
+TEST_CASE("Test Async") {
+
+    AsyncOptions options;
+    options.engine.seed = 42;
+    options.engine.pageLen = 1024 * 64;
+    options.threads = 2;
+    AsyncEngine asyncEngine(options);
+    REQUIRE( asyncEngine.threadCount() == 2 );
+    Engine engine(options.engine);
+
+    // The nth address computed is the one an engine seeded with seed + n computes, whichever worker computes it
+    std::vector<std::future<std::string>> addresses;
+    for (unsigned char i = 0; i < 6; ++i) addresses.push_back(asyncEngine.computeAddress(std::vector<unsigned char>(100, i), i % 2 == 0));
+    for (unsigned char i = 0; i < 6; ++i) {
+        EngineOptions engineOptions = options.engine;
+        engineOptions.seed = *options.engine.seed + i;
+        const std::string address = addresses[i].get();
+        REQUIRE( address == Engine(engineOptions).computeAddress(std::vector<unsigned char>(100, i), i % 2 == 0) );
+        REQUIRE( asyncEngine.search(address).get() == engine.search(address) );
+    }
+
+    const std::string address = "simpleaddress:2:4:4:300";
+    std::ostringstream page;
+    asyncEngine.searchStream(address, page).get();
+    const std::vector<unsigned char> expected = engine.search(address);
+    REQUIRE( page.str() == std::string(expected.begin(), expected.end()) );
+
+    std::istringstream stream("streamed data");
+    const std::string streamAddress = asyncEngine.computeStreamAddress(stream, false).get();
+    const std::vector<unsigned char> streamPage = engine.search(streamAddress);
+    REQUIRE( std::string(streamPage.begin(), streamPage.begin() + 13) == "streamed data" );
+
+    REQUIRE_THROWS_AS( asyncEngine.search("simpleaddress:5:4:4:300").get(), std::invalid_argument );
+
+    SECTION("Test Async Cancellation") {
+        // Work cancelled before it starts never runs
+        CancellationToken cancelled;
+        cancelled.cancel();
+        REQUIRE_THROWS_AS( asyncEngine.search(address, cancelled).get(), OperationCancelled );
+        REQUIRE_THROWS_AS( asyncEngine.computeAddress({1, 2, 3}, false, cancelled).get(), OperationCancelled );
+
+        // Work cancelled part way stops at the next chunk
+        CancellationToken searchToken;
+        CancellingStreamBuf output(searchToken, "");
+        std::ostream outputStream(&output);
+        REQUIRE_THROWS_AS( asyncEngine.searchStream(address, outputStream, searchToken).get(), OperationCancelled );
+        REQUIRE( output.written == 1024 * 16 );
+
+        CancellationToken computeToken;
+        CancellingStreamBuf input(computeToken, std::string(1024 * 64, 'x'));
+        std::istream inputStream(&input);
+        REQUIRE_THROWS_AS( asyncEngine.computeStreamAddress(inputStream, false, computeToken).get(), OperationCancelled );
+
+        // The workers carry on with later work
+        REQUIRE( asyncEngine.search(address).get() == expected );
+    }
+
+    SECTION("Test Free Async Functions") {
+        const std::string freeAddress = computeAddressAsync({'a', 'b', 'c'}, false).get();
+        const std::vector<unsigned char> freePage = searchAsync(freeAddress).get();
+        REQUIRE( std::string(freePage.begin(), freePage.begin() + 3) == "abc" );
+
+        std::istringstream freeStream("abc");
+        REQUIRE( searchAsync(computeStreamAddressAsync(freeStream, true).get()).get().size() == MAX_PAGE_LEN );
+        std::ostringstream freeOutput;
+        searchStreamAsync(freeAddress, freeOutput).get();
+        REQUIRE( freeOutput.str().substr(0, 3) == "abc" );
+    }
+}
+
+
+TEST_CASE("Test Search Cache") {
+
+    EngineOptions options;
+    options.pageLen = 1024;
+    Engine uncachedEngine(options);
+    options.searchCache = std::make_shared<SearchCache>();
+    Engine engine(options);
+    const std::shared_ptr<SearchCache> cache = options.searchCache;
+
+    const std::string address = "simpleaddress:2:4:4:300";
+    const SharedPage first = engine.searchShared(address);
+    const SharedPage second = engine.searchShared(address);
+    REQUIRE( first == second );
+    REQUIRE( *first == uncachedEngine.search(address) );
+    REQUIRE( engine.search(address) == *first );
+
+    SearchCacheStats stats = cache->stats();
+    REQUIRE( stats.hits == 2 );
+    REQUIRE( stats.misses == 1 );
+    REQUIRE( stats.entries == 1 );
+    REQUIRE( stats.bytes == 1024 + address.size() );
+
+    // Engines of another padding scheme or page length find other pages at the same address
+    for (const PaddingScheme scheme : {PaddingScheme::Legacy, PaddingScheme::Counter}) {
+        for (const size_t pageLen : {size_t{1024}, size_t{512}}) {
+            EngineOptions otherOptions = options;
+            otherOptions.paddingScheme = scheme;
+            otherOptions.pageLen = pageLen;
+            otherOptions.searchCache = nullptr;
+            const std::vector<unsigned char> expected = Engine(otherOptions).search(address);
+            otherOptions.searchCache = cache;
+            REQUIRE( *Engine(otherOptions).searchShared(address) == expected );
+        }
+    }
+    REQUIRE( cache->stats().entries == 4 );
+
+    // Every search entry point answers from the cache
+    std::ostringstream stream;
+    engine.searchStream(address, stream);
+    REQUIRE( stream.str() == std::string(first->begin(), first->end()) );
+    REQUIRE_THROWS_AS( engine.searchShared("simpleaddress:5:4:4:300"), std::invalid_argument );
+    REQUIRE( cache->stats().entries == 4 );
+
+    // Cleared pages stay valid for the readers still holding them
+    cache->clear();
+    REQUIRE( cache->stats().entries == 0 );
+    REQUIRE( cache->stats().bytes == 0 );
+    REQUIRE( first->size() == 1024 );
+    REQUIRE( engine.searchShared(address) != first );
+
+    SECTION("Test Search Cache Eviction") {
+        SearchCacheOptions cacheOptions;
+        cacheOptions.shards = 1;
+        cacheOptions.capacity = 3 * (1024 + 32);
+        EngineOptions smallOptions = options;
+        smallOptions.searchCache = std::make_shared<SearchCache>(cacheOptions);
+        Engine smallEngine(smallOptions);
+
+        // The popular address is hit between every insert, so the clock passes over it
+        const std::string popular = "popular:1:1:01:001";
+        smallEngine.searchShared(popular);
+        for (int i = 0; i < 10; ++i) {
+            smallEngine.searchShared(popular);
+            smallEngine.searchShared("other" + std::to_string(i) + ":1:1:01:001");
+        }
+
+        stats = smallOptions.searchCache->stats();
+        REQUIRE( stats.entries <= 3 );
+        REQUIRE( stats.bytes <= cacheOptions.capacity );
+        REQUIRE( stats.evictions == 11 - stats.entries );
+        REQUIRE( stats.hits == 10 );
+        REQUIRE( stats.misses == 11 );
+    }
+
+    SECTION("Test Shared Search Cache") {
+        BatchOptions batchOptions;
+        batchOptions.engine = options;
+        batchOptions.threads = 4;
+        BatchEngine batchEngine(batchOptions);
+
+        std::vector<std::string> addresses;
+        for (int i = 0; i < 50; ++i) addresses.push_back("address" + std::to_string(i % 10) + ":1:1:01:001");
+        const std::vector<std::vector<unsigned char>> pages = batchEngine.searchBatch(addresses);
+        for (size_t i = 0; i < addresses.size(); ++i) REQUIRE( pages[i] == uncachedEngine.search(addresses[i]) );
+
+        stats = cache->stats();
+        REQUIRE( stats.entries == 11 );
+        REQUIRE( stats.hits + stats.misses >= 50 );
+    }
+}
+
+
+TEST_CASE("Test Zero-Filled Addresses") {
+
+    std::mt19937 gen(23);
+    for (const size_t pageLen : {size_t{1024}, size_t{1025}, size_t{1026}}) {
+        EngineOptions options;
+        options.seed = 5;
+        options.pageLen = pageLen;
+        Engine fullEngine(options);
+        options.zeroFilledAddresses = true;
+        Engine engine(options);
+        options.alphabet = AddressAlphabet::Base64Url;
+        Engine urlEngine(options);
+
+        for (const size_t len : {size_t{0}, size_t{1}, size_t{2}, size_t{3}, size_t{4}, size_t{50}, pageLen - 1, pageLen}) {
+            std::vector<unsigned char> data(len);
+            for (unsigned char& c : data) c = static_cast<unsigned char>(gen() % 255 + 1);
+            std::vector<unsigned char> page = data;
+            page.resize(pageLen, 0);
+
+            const std::string address = engine.computeAddress(data, false);
+            const std::string fullAddress = fullEngine.computeAddress(data, false);
+            REQUIRE( engine.search(address) == page );
+            REQUIRE( fullEngine.search(address) == page );
+            REQUIRE( engine.searchRange(address, len / 2, 40) == fullEngine.searchRange(fullAddress, len / 2, 40) );
+
+            // Data that fills the page leaves no zero digits out, so it gets the full address
+            if (len == pageLen) {
+                REQUIRE( address == fullAddress );
+                continue;
+            }
+            REQUIRE( getAddressComponents(address).hexagon.back() == ZERO_FILL_MARK );
+            REQUIRE( address.length() <= (len + 4 + 2) / 3 * 4 + 4 + MAX_COORDINATE_LEN );
+
+            const std::vector<unsigned char> packed = packAddress(address);
+            REQUIRE( unpackAddress(packed) == address );
+            const std::string urlAddress = transcodeAddress(address, DEFAULT_ADDRESS_ALPHABET, AddressAlphabet::Base64Url);
+            REQUIRE( urlEngine.search(urlAddress) == page );
+        }
+    }
+
+    SECTION("Test Trailing Zeros") {
+        // Zeros at the end of the data are left out along with the padding
+        EngineOptions options;
+        options.pageLen = 1024;
+        options.zeroFilledAddresses = true;
+        Engine engine(options);
+        const std::vector<unsigned char> data = {'z', 'e', 'r', 'o', 0, 0, 0, 0, 0, 0};
+        const std::string address = engine.computeAddress(data, false);
+        REQUIRE( getAddressComponents(address).hexagon.length() <= 14 );
+        std::vector<unsigned char> page = engine.search(address);
+        REQUIRE( std::equal(data.begin(), data.end(), page.begin()) );
+
+        // Randomly padded data is never zero-filled
+        REQUIRE( getAddressComponents(engine.computeAddress(data, true)).hexagon.back() != ZERO_FILL_MARK );
+
+        // Buffers only need to fit the address of the data
+        std::vector<char> buffer(engine.maxAddressLength(data.size(), false));
+        REQUIRE( buffer.size() < engine.maxAddressLength() );
+        REQUIRE( engine.computeAddress(ByteView(data), false, CharBuffer(buffer)) <= buffer.size() );
+        REQUIRE_THROWS_AS( engine.computeAddress(ByteView(data), true, CharBuffer(buffer)), std::length_error );
+    }
+
+    SECTION("Test Zero-Filled Errors") {
+        EngineOptions options;
+        options.pageLen = 1024;
+        Engine engine(options);
+        REQUIRE_THROWS_AS( engine.search(std::string(maxHexagonLength(1024) + 4, 'B') + ".:1:1:01:001"), std::invalid_argument );
+        REQUIRE_THROWS_AS( engine.search("AB$C.:1:1:01:001"), std::invalid_argument );
+        REQUIRE( engine.search(".:1:1:01:001") == engine.search(".:1:1:01:001") );
+    }
+}
+
+TEST_CASE("Test SHA-256") {
+
+    const auto hex = [](const ContentDigest& digest) {
+        std::string str;
+        for (const unsigned char byte : digest) str += "0123456789abcdef"[byte >> 4], str += "0123456789abcdef"[byte & 15];
+        return str;
+    };
+    const auto hashString = [&](const std::string& str) {
+        return hex(sha256(ByteView(reinterpret_cast<const unsigned char*>(str.data()), str.size())));
+    };
+
+    // The test vectors of FIPS 180-4, with messages ending either side of the length field
+    REQUIRE( hashString("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" );
+    REQUIRE( hashString("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" );
+    REQUIRE( hashString("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+             "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" );
+    REQUIRE( hashString(std::string(1000000, 'a')) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" );
+}
+
+TEST_CASE("Test Address Index") {
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / ("babel_index_" + std::to_string(std::random_device()()));
+    std::filesystem::create_directories(dir);
+    const std::string path = (dir / "addresses.idx").string();
+
+    AddressIndexOptions indexOptions;
+    indexOptions.pageLen = 1024;
+    indexOptions.buckets = 4;
+    EngineOptions options;
+    options.pageLen = 1024;
+    Engine plainEngine(options);
+    const std::vector<unsigned char> data = {'i', 'n', 'd', 'e', 'x', 'e', 'd'};
+
+    std::string address;
+    {
+        options.addressIndex = std::make_shared<AddressIndex>(path, indexOptions);
+        Engine engine(options);
+        address = engine.computeAddress(data, false);
+        REQUIRE( engine.computeAddress(data, false) == address );
+        REQUIRE( plainEngine.search(address) == engine.search(address) );
+
+        // Randomly padded data gets a new page every time, so it is never indexed
+        REQUIRE( engine.computeAddress(data, true) != engine.computeAddress(data, true) );
+
+        // Enough data to chain records in every bucket and grow the file past its first records
+        std::vector<std::string> addresses;
+        for (int i = 0; i < 200; ++i) {
+            const std::vector<unsigned char> other(static_cast<size_t>(i) + 1, static_cast<unsigned char>(i));
+            addresses.push_back(engine.computeAddress(other, false));
+        }
+        for (int i = 0; i < 200; ++i) {
+            const std::vector<unsigned char> other(static_cast<size_t>(i) + 1, static_cast<unsigned char>(i));
+            REQUIRE( engine.computeAddress(other, false) == addresses[i] );
+        }
+
+        const AddressIndexStats stats = options.addressIndex->stats();
+        REQUIRE( stats.entries == 201 );
+        REQUIRE( stats.hits == 201 );
+        REQUIRE( stats.misses == 201 );
+        REQUIRE( options.addressIndex->options().buckets == 4 );
+
+        // A read-only index sees the inserts of the writer as they are made
+        AddressIndexOptions readerOptions = indexOptions;
+        readerOptions.readOnly = true;
+        EngineOptions readerEngineOptions = options;
+        readerEngineOptions.addressIndex = std::make_shared<AddressIndex>(path, readerOptions);
+        Engine reader(readerEngineOptions);
+        for (int i = 0; i < 2000; ++i) engine.computeAddress(std::vector<unsigned char>(4, static_cast<unsigned char>(i)), false);
+        const std::vector<unsigned char> last(4, static_cast<unsigned char>(1999));
+        REQUIRE( reader.computeAddress(last, false) == engine.computeAddress(last, false) );
+
+        // Only one process or index may write at a time
+        REQUIRE_THROWS_AS( AddressIndex(path, indexOptions), std::system_error );
+        options.addressIndex->sync();
+        options.addressIndex.reset();
+    }
+
+    SECTION("Test Reopening") {
+        options.addressIndex = std::make_shared<AddressIndex>(path, indexOptions);
+        Engine engine(options);
+        REQUIRE( engine.computeAddress(data, false) == address );
+        REQUIRE( options.addressIndex->stats().hits == 1 );
+    }
+
+    SECTION("Test Index Errors") {
+        AddressIndexOptions otherOptions = indexOptions;
+        otherOptions.pageLen = 512;
+        REQUIRE_THROWS_AS( AddressIndex(path, otherOptions), std::runtime_error );
+        otherOptions = indexOptions;
+        otherOptions.alphabet = AddressAlphabet::Base64Url;
+        REQUIRE_THROWS_AS( AddressIndex(path, otherOptions), std::runtime_error );
+
+        otherOptions = indexOptions;
+        otherOptions.readOnly = true;
+        REQUIRE_THROWS_AS( AddressIndex((dir / "missing.idx").string(), otherOptions), std::system_error );
+        std::ofstream((dir / "other.idx").string()) << "not an index";
+        REQUIRE_THROWS_AS( AddressIndex((dir / "other.idx").string(), indexOptions), std::runtime_error );
+
+        // Engines only take an index built for their own page length
+        options.addressIndex = std::make_shared<AddressIndex>(path, indexOptions);
+        options.pageLen = 2048;
+        REQUIRE_THROWS_AS( Engine(options), std::invalid_argument );
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Test Files") {
+
+    const std::filesystem::path dir = std::filesystem::temp_directory_path() / ("babel_files_" + std::to_string(std::random_device()()));
+    std::filesystem::create_directories(dir);
+    const auto readFile = [](const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+
+    EngineOptions options;
+    options.seed = 42;
+    options.pageLen = 1024;
+    Engine fileEngine(options);
+    Engine engine(options);
+
+    // Files shorter than, as long as, and longer than a page
+    for (const size_t len : {size_t{0}, size_t{300}, size_t{1024}, size_t{5000}}) {
+        std::vector<unsigned char> data(len);
+        for (size_t i = 0; i < len; ++i) data[i] = static_cast<unsigned char>(i * 31 + 7);
+        const std::filesystem::path input = dir / ("input_" + std::to_string(len));
+        std::ofstream(input, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(len));
+
+        for (const bool padRandom : {false, true}) {
+            const std::string address = fileEngine.computeFileAddress(input.string(), padRandom);
+            REQUIRE( address == engine.computeAddress(data, padRandom) );
+
+            const std::filesystem::path output = dir / "output";
+            fileEngine.searchToFile(address, output.string());
+            REQUIRE( readFile(output) == engine.search(address) );
+        }
+    }
+
+    SECTION("Test File Errors") {
+        REQUIRE_THROWS_AS( fileEngine.computeFileAddress((dir / "missing").string(), false), std::system_error );
+        REQUIRE_THROWS_AS( fileEngine.searchToFile("simpleaddress:2:4:4:300", (dir / "missing" / "output").string()), std::system_error );
+
+        // An invalid address is caught before the output file is touched
+        const std::filesystem::path output = dir / "kept";
+        std::ofstream(output) << "kept";
+        REQUIRE_THROWS_AS( fileEngine.searchToFile("simpleaddress:5:4:4:300", output.string()), std::invalid_argument );
+        REQUIRE( readFile(output).size() == 4 );
+    }
+
+    SECTION("Test File Batches") {
+        BatchOptions batchOptions;
+        batchOptions.engine = options;
+        batchOptions.threads = 2;
+        BatchEngine batchEngine(batchOptions);
+
+        const std::vector<std::string> inputs = {(dir / "input_300").string(), (dir / "input_5000").string(), (dir / "input_0").string()};
+        const std::vector<std::string> addresses = batchEngine.computeFileAddressBatch(inputs, true);
+        const std::vector<std::string> outputs = {(dir / "out_0").string(), (dir / "out_1").string(), (dir / "out_2").string()};
+        batchEngine.searchToFileBatch(addresses, outputs);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            REQUIRE( readFile(outputs[i]) == engine.search(addresses[i]) );
+            const std::vector<unsigned char> input = readFile(inputs[i]);
+            EngineOptions engineOptions = options;
+            engineOptions.seed = *options.seed + i;
+            REQUIRE( addresses[i] == Engine(engineOptions).computeAddress(input, true) );
+        }
+        REQUIRE_THROWS_AS( batchEngine.searchToFileBatch(addresses, {outputs[0]}), std::invalid_argument );
+
+        REQUIRE( searchBatch({computeFileAddress(inputs[0], false)})[0].size() == MAX_PAGE_LEN );
+        searchToFile(computeFileAddress(inputs[0], false), outputs[0]);
+        REQUIRE( readFile(outputs[0]).size() == MAX_PAGE_LEN );
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+
+TEST_CASE("Test Books") {
+
+    BatchOptions options;
+    options.engine.seed = 42;
+    options.engine.pageLen = 1024;
+    options.threads = 3;
+    BatchEngine batchEngine(options);
+    Engine engine(options.engine);
+
+    // Lengths that end on, just past, and well short of a page boundary, spanning several windows of pages
+    for (const size_t len : {size_t{0}, size_t{1}, size_t{1024}, size_t{1024 * 10 + 517}}) {
+        std::string data(len, '\0');
+        for (size_t i = 0; i < len; ++i) data[i] = static_cast<char>(i * 13 + (i >> 8));
+
+        for (const bool padRandom : {false, true}) {
+            std::istringstream in(data);
+            std::ostringstream book;
+            const std::string manifest = batchEngine.computeBook(in, book, padRandom);
+            REQUIRE( manifest.rfind("book:" + std::to_string(len) + ":", 0) == 0 );
+
+            // One hexagon per page, the first of which is an ordinary address at the coordinate of the manifest
+            const std::string hexagons = book.str();
+            REQUIRE( std::count(hexagons.begin(), hexagons.end(), '\n') == static_cast<long>((len + 1023) / 1024) );
+            if (len > 0) {
+                const std::string coordinate = manifest.substr(manifest.find(':', 5));
+                const std::vector<unsigned char> page = engine.search(hexagons.substr(0, hexagons.find('\n')) + coordinate);
+                const size_t pageData = std::min<size_t>(len, 1024);
+                REQUIRE( std::string(page.begin(), page.begin() + static_cast<long>(pageData)) == data.substr(0, pageData) );
+            }
+
+            std::istringstream bookIn(book.str());
+            std::ostringstream out;
+            batchEngine.searchBook(manifest, bookIn, out);
+            REQUIRE( out.str() == data );
+
+            // Seeded books are reproducible
+            std::istringstream again(data);
+            std::ostringstream secondBook;
+            REQUIRE( batchEngine.computeBook(again, secondBook, padRandom) == manifest );
+            REQUIRE( secondBook.str() == book.str() );
+        }
+    }
+
+    SECTION("Test Book Coordinates Wrap") {
+        // The page after the last coordinate of a hexagon is at its first
+        std::istringstream book("simpleaddress\nanotheraddress\n");
+        std::ostringstream out;
+        batchEngine.searchBook("book:2000:4:5:32:410", book, out);
+
+        std::vector<unsigned char> expected = engine.search("simpleaddress:4:5:32:410");
+        const std::vector<unsigned char> second = engine.search("anotheraddress:1:1:01:001");
+        expected.insert(expected.end(), second.begin(), second.begin() + 2000 - 1024);
+        REQUIRE( out.str() == std::string(expected.begin(), expected.end()) );
+    }
+
+    SECTION("Test Book Errors") {
+        std::istringstream shortBook("simpleaddress\n");
+        std::ostringstream out;
+        REQUIRE_THROWS_AS( batchEngine.searchBook("book:2000:1:1:01:001", shortBook, out), std::invalid_argument );
+        for (const std::string manifest : {"simpleaddress:1:1:01:001", "book:10", "book:10:5:1:01:001", "book:10:0:1:01:001"}) {
+            std::istringstream book("simpleaddress\n");
+            REQUIRE_THROWS_AS( batchEngine.searchBook(manifest, book, out), std::invalid_argument );
+        }
+    }
+
+    SECTION("Test Free Book Functions") {
+        std::istringstream in("a short book");
+        std::ostringstream book;
+        const std::string manifest = computeBook(in, book, true);
+        std::istringstream bookIn(book.str());
+        std::ostringstream out;
+        searchBook(manifest, bookIn, out);
+        REQUIRE( out.str() == "a short book" );
+    }
+}
+
+
+TEST_CASE("Test Address Alphabets") {
+
+    EngineOptions options;
+    options.seed = 42;
+    options.pageLen = 4096;
+    Engine engine(options);
+    options.alphabet = AddressAlphabet::Base64Url;
+    Engine urlEngine(options);
+
+    const std::vector<unsigned char> data(3000, 0xfb);
+    const std::string urlAddress = urlEngine.computeAddress(data, false);
+    const std::string address = engine.computeAddress(data, false);
+    // The same seed gives the same address, written in each alphabet
+    REQUIRE( urlAddress.find_first_of("+/") == std::string::npos );
+    REQUIRE( urlAddress.find_first_of("-_") != std::string::npos );
+    REQUIRE( transcodeAddress(address, AddressAlphabet::Base64, AddressAlphabet::Base64Url) == urlAddress );
+    REQUIRE( transcodeAddress(urlAddress, AddressAlphabet::Base64Url, AddressAlphabet::Base64) == address );
+
+    const std::vector<unsigned char> page = urlEngine.search(urlAddress);
+    REQUIRE( std::equal(data.begin(), data.end(), page.begin()) );
+    REQUIRE( page == engine.search(address) );
+    REQUIRE( urlEngine.searchRange(urlAddress, 100, 50) == engine.searchRange(address, 100, 50) );
+
+    std::istringstream in(std::string(data.begin(), data.end()));
+    REQUIRE( urlEngine.computeStreamAddress(in, false).find_first_of("+/") == std::string::npos );
+
+    // Short hexagons are padded with the same digits in either alphabet
+    for (const std::string& shortAddress : {std::string("simple+add/ress:2:4:4:300"), std::string("-simple+add/ress:1:1:01:001"),
+                                            std::string("+/:1:1:01:001")}) {
+        const std::string urlShort = transcodeAddress(shortAddress, AddressAlphabet::Base64, AddressAlphabet::Base64Url);
+        REQUIRE( urlShort.find_first_of("+/") == std::string::npos );
+        REQUIRE( urlEngine.search(urlShort) == engine.search(shortAddress) );
+        REQUIRE( urlEngine.searchRange(urlShort, 1000, 100) == engine.searchRange(shortAddress, 1000, 100) );
+    }
+    REQUIRE( transcodeAddress("-ab+:1:1:01:001", AddressAlphabet::Base64, AddressAlphabet::Base64Url) == "~ab-:1:1:01:001" );
+
+    SECTION("Test Packed Alphabets") {
+        const std::vector<unsigned char> packed = packAddress(urlAddress, AddressAlphabet::Base64Url);
+        REQUIRE( packed == packAddress(address) );
+        REQUIRE( unpackAddress(ByteView(packed), AddressAlphabet::Base64Url) == urlAddress );
+        REQUIRE( unpackAddress(ByteView(packed)) == address );
+    }
+
+    SECTION("Test Alphabet Errors") {
+        REQUIRE_THROWS_AS( urlEngine.search("simple+address:1:1:01:001"), std::invalid_argument );
+        REQUIRE_THROWS_AS( engine.search("simple_address:1:1:01:001"), std::invalid_argument );
+        REQUIRE_THROWS_AS( transcodeAddress("simple_address:1:1:01:001", AddressAlphabet::Base64, AddressAlphabet::Base64Url),
+                           std::invalid_argument );
+        REQUIRE_THROWS_AS( packAddress("simple+address:1:1:01:001", AddressAlphabet::Base64Url), std::invalid_argument );
+        // Long hexagons are checked by the vectorized kernels too
+        std::string longAddress = urlAddress;
+        longAddress[100] = '+';
+        REQUIRE_THROWS_AS( urlEngine.search(longAddress), std::invalid_argument );
+    }
+
+    SECTION("Test Cached Alphabets") {
+        // The same text is a different hexagon in each alphabet, so pages are cached apart
+        EngineOptions cacheOptions;
+        cacheOptions.searchCache = std::make_shared<SearchCache>();
+        Engine cachedEngine(cacheOptions);
+        cacheOptions.alphabet = AddressAlphabet::Base64Url;
+        Engine cachedUrlEngine(cacheOptions);
+        const std::vector<unsigned char> negative = cachedEngine.search("-abc:1:1:01:001");
+        REQUIRE( cachedUrlEngine.search("-abc:1:1:01:001") != negative );
+        REQUIRE( cacheOptions.searchCache->stats().entries == 2 );
+    }
+}
+
+
+TEST_CASE("Test Search Range") {
+
+    std::string hexagon;
+    for (int i = 0; i < 300; ++i) hexagon += BASE64_CHARSET_STR_[(i * 37 + i / 5) % 64];
+
+    for (const size_t pageLen : {size_t{3000}, size_t{3001}, size_t{3002}}) {
+        for (const PaddingScheme scheme : {PaddingScheme::Counter, PaddingScheme::Legacy}) {
+            EngineOptions options;
+            options.seed = 42;
+            options.pageLen = pageLen;
+            options.paddingScheme = scheme;
+            Engine engine(options);
+
+            const std::vector<std::string> addresses = {
+                engine.computeAddress(std::vector<unsigned char>{'a', 'b', 'c'}, true),
+                engine.computeAddress(std::vector<unsigned char>{'a', 'b', 'c'}, false),
+                "simpleaddress:2:4:4:300",
+                "-simpleaddress:1:1:01:001",
+                hexagon + ":4:5:32:410",
+                "-" + hexagon + ":1:1:01:001",
+                "A:1:1:01:001"
+            };
+            for (const std::string& address : addresses) {
+                const std::vector<unsigned char> page = engine.search(address);
+                for (const auto& [offset, length] : std::vector<std::pair<size_t, size_t>>{{0, 1024}, {0, pageLen}, {1, 2}, {700, 1},
+                                                                                           {1499, 301}, {pageLen - 5, 100}, {pageLen, 10}}) {
+                    const std::vector<unsigned char> range = engine.searchRange(address, offset, length);
+                    const size_t end = std::min(offset + length, pageLen);
+                    REQUIRE( range == std::vector<unsigned char>(page.begin() + offset, page.begin() + end) );
+
+                    std::ostringstream stream;
+                    engine.searchRangeStream(address, offset, length, stream);
+                    REQUIRE( stream.str() == std::string(range.begin(), range.end()) );
+                }
+            }
+        }
+    }
+
+    SECTION("Test Range Errors") {
+        Engine engine;
+        std::vector<unsigned char> range(8);
+        REQUIRE_THROWS_AS( engine.searchRange("simpleaddress:1:1:01:001", MAX_PAGE_LEN + 1, 1), std::out_of_range );
+        REQUIRE_THROWS_AS( engine.searchRange("simpleaddress:1:1:01:001", MAX_PAGE_LEN + 1, ByteBuffer(range)), std::out_of_range );
+        REQUIRE( engine.searchRange("simpleaddress:1:1:01:001", MAX_PAGE_LEN, ByteBuffer(range)) == 0 );
+        REQUIRE_THROWS_AS( engine.searchRange("simpleaddress:9:1:01:001", 0, 1), std::invalid_argument );
+        REQUIRE_THROWS_AS( engine.searchRange("simple&address:1:1:01:001", 0, 1), std::invalid_argument );
+    }
+
+    SECTION("Test Cached Ranges") {
+        EngineOptions options;
+        options.searchCache = std::make_shared<SearchCache>();
+        Engine engine(options);
+        const std::vector<unsigned char> page = engine.search("simpleaddress:1:1:01:001");
+        REQUIRE( options.searchCache->stats().entries == 1 );
+        REQUIRE( engine.searchRange("simpleaddress:1:1:01:001", 10, 20) == std::vector<unsigned char>(page.begin() + 10, page.begin() + 30) );
+        REQUIRE( options.searchCache->stats().hits == 1 );
+
+        // Ranges of uncached pages are decoded without adding the page to the cache
+        engine.searchRange("otheraddress:1:1:01:001", 10, 20);
+        REQUIRE( options.searchCache->stats().entries == 1 );
+    }
+
+    SECTION("Test Free Range Functions") {
+        const std::vector<unsigned char> page = search("simpleaddress:1:1:01:001");
+        std::vector<unsigned char> range(100);
+        REQUIRE( searchRange("simpleaddress:1:1:01:001", 50, ByteBuffer(range)) == 100 );
+        REQUIRE( range == std::vector<unsigned char>(page.begin() + 50, page.begin() + 150) );
+        REQUIRE( searchRange("simpleaddress:1:1:01:001", MAX_PAGE_LEN - 10, 100).size() == 10 );
+        std::ostringstream stream;
+        searchRangeStream("simpleaddress:1:1:01:001", 50, 100, stream);
+        REQUIRE( stream.str() == std::string(range.begin(), range.end()) );
+    }
+}
+
+
+TEST_CASE("Test Instrumentation") {
+
+    EngineOptions options;
+    options.seed = 42;
+    options.pageLen = 4096;
+    Engine engine(options);
+
+    resetInstrumentation();
+    // The callback owns its record, so a failed check cannot leave it pointing at this test
+    const auto traced = std::make_shared<std::vector<Stage>>();
+    setTraceCallback([traced](const Stage stage, uint64_t, size_t) { traced->push_back(stage); });
+
+    const std::string address = engine.computeAddress(std::vector<unsigned char>{'a', 'b', 'c'}, true);
+    REQUIRE( engine.search(address).size() == 4096 );
+    REQUIRE( engine.search("short:1:1:01:001").size() == 4096 );
+    REQUIRE( numToBase(baseToNum(std::vector<unsigned char>{'a', 'b', 'c'}, 256), 64).size() == 4 );
+
+    const InstrumentationStats stats = instrumentationStats();
+    if constexpr (INSTRUMENTATION_ENABLED) {
+        REQUIRE( stats[Stage::Encode].calls == 1 );
+        REQUIRE( stats[Stage::Encode].bytes == 4096 );
+        REQUIRE( stats[Stage::AssembleAddress].calls == 1 );
+        REQUIRE( stats[Stage::ParseAddress].calls == 2 );
+        REQUIRE( stats[Stage::Decode].calls == 2 );
+        REQUIRE( stats[Stage::Decode].bytes == 8192 );
+        REQUIRE( stats[Stage::Decode].allocations == 2 );
+        // Only the short hexagon needs padding
+        REQUIRE( stats[Stage::FitAddress].calls == 1 );
+        REQUIRE( stats[Stage::NumToBase].calls == 1 );
+        REQUIRE( stats[Stage::BaseToNum].calls == 1 );
+        REQUIRE( traced->size() == 9 );
+        REQUIRE( traced->front() == Stage::Encode );
+    } else {
+        for (const StageStats& stage : stats.stages) REQUIRE( stage.calls == 0 );
+        REQUIRE( traced->empty() );
+    }
+
+    SECTION("Test Reset") {
+        setTraceCallback(nullptr);
+        engine.search(address);
+        resetInstrumentation();
+        for (const StageStats& stage : instrumentationStats().stages) {
+            REQUIRE( stage.calls == 0 );
+            REQUIRE( stage.nanoseconds == 0 );
+        }
+        REQUIRE( std::string(stageName(Stage::FitData)) == "fitData" );
+    }
+
+    setTraceCallback(nullptr);
+}
+
+
+TEST_CASE("Test Page Threads") {
+
+    std::string hexagon;
+    for (int i = 0; i < 1000; ++i) hexagon += BASE64_CHARSET_STR_[(i * 37 + i / 5) % 64];
+
+    // Each length lines the seed up differently with the groups of the hexagon
+    for (const size_t pageLen : {1024 * 1024, 1024 * 1024 + 1, 1024 * 1024 + 2}) {
+        EngineOptions options;
+        options.seed = 42;
+        options.pageLen = pageLen;
+        Engine serialEngine(options);
+        options.pageThreads = 4;
+        Engine threadedEngine(options);
+
+        std::vector<unsigned char> data(pageLen / 2);
+        for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<unsigned char>(i * 7 + (i >> 11));
+
+        for (const bool padRandom : {false, true}) {
+            const std::string address = threadedEngine.computeAddress(data, padRandom);
+            REQUIRE( address == serialEngine.computeAddress(data, padRandom) );
+            REQUIRE( threadedEngine.search(address) == serialEngine.search(address) );
+        }
+
+        for (const std::string& address : {std::string("simpleaddress:2:4:4:300"), std::string("-simpleaddress:1:1:01:001"), "-" + hexagon + ":1:1:01:001"})
+            REQUIRE( threadedEngine.search(address) == serialEngine.search(address) );
+    }
+}
+
+
+#ifdef __linux__
+TEST_CASE("Test Server Protocol") {
+
+    SECTION("Test Headers") {
+        Protocol::FrameHeader header;
+        header.length = 0x01020304;
+        header.id = 0xfffffffe;
+        header.code = static_cast<uint8_t>(Protocol::Op::SearchRange);
+        header.flags = Protocol::FLAG_COUNTER_PADDING;
+
+        unsigned char bytes[Protocol::HEADER_LEN];
+        std::fill(std::begin(bytes), std::end(bytes), 0xff);
+        Protocol::writeHeader(bytes, header);
+        // Lengths and ids are big-endian and the reserved bytes are zero
+        REQUIRE( bytes[0] == 0x01 );
+        REQUIRE( bytes[3] == 0x04 );
+        REQUIRE( bytes[10] == 0 );
+        REQUIRE( bytes[11] == 0 );
+
+        const Protocol::FrameHeader read = Protocol::readHeader(bytes);
+        REQUIRE( read.length == header.length );
+        REQUIRE( read.id == header.id );
+        REQUIRE( read.code == header.code );
+        REQUIRE( read.flags == header.flags );
+    }
+
+    SECTION("Test Big-Endian Words") {
+        unsigned char bytes[8];
+        for (const uint64_t value : {uint64_t{0}, uint64_t{1}, uint64_t{0x0102030405060708}, ~uint64_t{0}}) {
+            Protocol::storeBigEndian64(bytes, value);
+            REQUIRE( Protocol::loadBigEndian64(bytes) == value );
+        }
+        Protocol::storeBigEndian64(bytes, 0x0102030405060708);
+        REQUIRE( bytes[0] == 0x01 );
+        REQUIRE( bytes[7] == 0x08 );
+    }
+
+    SECTION("Test Endpoints") {
+        const Protocol::Endpoint unixEndpoint = Protocol::parseEndpoint("unix:/tmp/babel.sock");
+        REQUIRE( unixEndpoint.unixSocket );
+        REQUIRE( unixEndpoint.path == "/tmp/babel.sock" );
+
+        const Protocol::Endpoint tcpEndpoint = Protocol::parseEndpoint("tcp:65535");
+        REQUIRE_FALSE( tcpEndpoint.unixSocket );
+        REQUIRE( tcpEndpoint.port == 65535 );
+
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint("unix:"), std::invalid_argument );
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint("unix:/" + std::string(200, 'a')), std::invalid_argument );
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint("tcp:0"), std::invalid_argument );
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint("tcp:65536"), std::invalid_argument );
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint("tcp:port"), std::invalid_argument );
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint("tcp:80x"), std::invalid_argument );
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint("tcp:99999999999999999999999"), std::invalid_argument );
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint("localhost:7070"), std::invalid_argument );
+        REQUIRE_THROWS_AS( Protocol::parseEndpoint(""), std::invalid_argument );
+    }
+}
+#endif
+
+
+#ifdef BABEL_SERVER_PATH
+TEST_CASE("Test Server Half-Close") {
+    // The path is built before the fork, so the child only execs
+    const std::string socketPath = (std::filesystem::temp_directory_path() / ("babel_test_" + std::to_string(getpid()) + ".sock")).string();
+    const std::string endpoint = "unix:" + socketPath;
+    const pid_t server = fork();
+    REQUIRE( server >= 0 );
+    if (server == 0) {
+        execl(BABEL_SERVER_PATH, BABEL_SERVER_PATH, "--listen", endpoint.c_str(), "--threads", "1", "--cache-mb", "0", static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    // The server is stopped even if the test fails
+    struct ServerGuard {
+        pid_t pid;
+        ~ServerGuard() {
+            if (pid <= 0) return;
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+        }
+    } guard{server};
+
+    // Wait for the server to listen
+    int fd = -1;
+    for (int attempt = 0; attempt < 500 && fd < 0; ++attempt) {
+        try {
+            fd = Protocol::openSocket(Protocol::parseEndpoint(endpoint), false);
+        } catch (const std::system_error&) {
+            usleep(10 * 1000);
+        }
+    }
+    REQUIRE( fd >= 0 );
+    const timeval timeout{10, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::vector<unsigned char> data(1000);
+    std::mt19937 random(7);
+    for (unsigned char& byte : data) byte = static_cast<unsigned char>(random());
+    const std::string address = computeAddress(data, false);
+
+    // Pipeline a computation and a search, then shut down the sending side before any response is read
+    std::vector<unsigned char> requests;
+    const auto addRequest = [&](const uint32_t id, const Protocol::Op op, const unsigned char* payload, const size_t len) {
+        Protocol::FrameHeader header;
+        header.length = static_cast<uint32_t>(len);
+        header.id = id;
+        header.code = static_cast<uint8_t>(op);
+        const size_t start = requests.size();
+        requests.resize(start + Protocol::HEADER_LEN);
+        Protocol::writeHeader(requests.data() + start, header);
+        requests.insert(requests.end(), payload, payload + len);
+    };
+    addRequest(1, Protocol::Op::Compute, data.data(), data.size());
+    addRequest(2, Protocol::Op::Search, reinterpret_cast<const unsigned char*>(address.data()), address.size());
+    REQUIRE( send(fd, requests.data(), requests.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(requests.size()) );
+    REQUIRE( shutdown(fd, SHUT_WR) == 0 );
+
+    // The server answers both requests and then closes the connection
+    std::vector<unsigned char> received;
+    unsigned char chunk[1024 * 16];
+    ssize_t got;
+    while ((got = recv(fd, chunk, sizeof(chunk), 0)) > 0) received.insert(received.end(), chunk, chunk + got);
+    REQUIRE( got == 0 );
+    close(fd);
+
+    std::map<uint32_t, std::vector<unsigned char>> responses;
+    for (size_t offset = 0; offset < received.size();) {
+        REQUIRE( received.size() - offset >= Protocol::HEADER_LEN );
+        const Protocol::FrameHeader header = Protocol::readHeader(received.data() + offset);
+        REQUIRE( header.code == static_cast<uint8_t>(Protocol::Status::Ok) );
+        REQUIRE( received.size() - offset - Protocol::HEADER_LEN >= header.length );
+        const auto payload = received.begin() + static_cast<long>(offset + Protocol::HEADER_LEN);
+        responses[header.id].assign(payload, payload + header.length);
+        offset += Protocol::HEADER_LEN + header.length;
+    }
+    REQUIRE( responses.size() == 2 );
+    // Addresses are placed at random coordinates, so the computed address is checked by searching it
+    const std::vector<unsigned char> page = search(std::string(responses[1].begin(), responses[1].end()));
+    REQUIRE( std::equal(data.begin(), data.end(), page.begin()) );
+    REQUIRE( responses[2].size() == MAX_PAGE_LEN );
+    REQUIRE( std::equal(data.begin(), data.end(), responses[2].begin()) );
+
+    int status = 0;
+    guard.pid = -1;
+    kill(server, SIGTERM);
+    REQUIRE( waitpid(server, &status, 0) == server );
+    REQUIRE( WIFEXITED(status) );
+    REQUIRE( WEXITSTATUS(status) == 0 );
+}
+#endif
@@ -0,0 +1,155 @@
+#
+# Tests of the Python extension module, run by CTest with the built module on the Python path
+#
+
+import io
+import os
+import threading
+import unittest
+
+import babel
+
+
+class StreamError(Exception):
+    """An error raised by a stream, which must reach the caller unchanged"""
+
+
+class FailingStream(io.RawIOBase):
+    """A stream whose reads and writes fail"""
+
+    def readable(self):
+        return True
+
+    def writable(self):
+        return True
+
+    def readinto(self, buffer):
+        raise StreamError("read failed")
+
+    def write(self, data):
+        raise StreamError("write failed")
+
+
+class ReadOnlyStream:
+    """A stream that can only read whole bytes objects, so the module falls back from readinto() to read()"""
+
+    def __init__(self, data):
+        self.stream = io.BytesIO(data)
+
+    def read(self, size):
+        return self.stream.read(size)
+
+
+class KeepingStream(io.BytesIO):
+    """A stream that keeps the buffers it reads into, past the end of each read"""
+
+    def __init__(self, data):
+        super().__init__(data)
+        self.views = []
+
+    def readinto(self, buffer):
+        self.views.append(buffer)
+        return super().readinto(buffer)
+
+
+class TestModule(unittest.TestCase):
+
+    def assertPageStartsWith(self, page, data):
+        self.assertEqual(len(page), babel.MAX_PAGE_LEN)
+        self.assertEqual(bytes(page[:len(data)]), bytes(data))
+
+    def test_buffer_inputs(self):
+        data = os.urandom(1000)
+        for value in (data, bytearray(data), memoryview(data)):
+            address = babel.compute_address(value)
+            self.assertIsInstance(address, str)
+            self.assertLessEqual(len(address), babel.MAX_ADDRESS_LEN)
+            self.assertPageStartsWith(babel.search(address), data)
+
+    def test_search(self):
+        data = b"Hello, world"
+        page = babel.search(babel.compute_address(data))
+        self.assertIsInstance(page, memoryview)
+        self.assertTrue(page.readonly)
+        self.assertEqual(page.nbytes, babel.MAX_PAGE_LEN)
+        self.assertPageStartsWith(page, data)
+        with self.assertRaises(TypeError):
+            page[0] = 1
+
+    def test_addresses(self):
+        data = os.urandom(100)
+        address = babel.compute_address(data)
+        self.assertEqual(bytes(babel.search(address)), bytes(babel.search(address.encode())))
+        self.assertPageStartsWith(babel.search(address.encode()), data)
+
+        components = babel.get_address_components(address)
+        self.assertEqual(":".join(components), address)
+        self.assertEqual(components.hexagon, address.split(":")[0])
+
+    def test_padding_schemes(self):
+        address = "simpleaddress:3:4:4:300"
+        self.assertEqual(bytes(babel.search(address)), bytes(babel.search(address, scheme=babel.PADDING_LEGACY)))
+        self.assertNotEqual(bytes(babel.search(address, babel.PADDING_LEGACY)), bytes(babel.search(address, babel.PADDING_COUNTER)))
+
+    def test_streams(self):
+        data = os.urandom(babel.MAX_PAGE_LEN // 2)
+        address = babel.compute_stream_address(io.BytesIO(data))
+        self.assertPageStartsWith(babel.search(address), data)
+        self.assertPageStartsWith(babel.search(babel.compute_stream_address(ReadOnlyStream(data))), data)
+
+        output = io.BytesIO()
+        self.assertIsNone(babel.search_stream(address, output))
+        self.assertEqual(output.getvalue(), bytes(babel.search(address)))
+
+    def test_invalid_arguments(self):
+        with self.assertRaises(ValueError):
+            babel.search("not an address")
+        with self.assertRaises(ValueError):
+            babel.search_stream("not an address", io.BytesIO())
+        with self.assertRaises(ValueError):
+            babel.search(babel.compute_address(b"data"), scheme=99)
+        with self.assertRaises(ValueError):
+            babel.search_stream(babel.compute_address(b"data"), io.BytesIO(), scheme=-1)
+        with self.assertRaises(TypeError):
+            babel.compute_address(12)
+
+    def test_stream_errors(self):
+        with self.assertRaisesRegex(StreamError, "read failed"):
+            babel.compute_stream_address(FailingStream())
+        with self.assertRaisesRegex(StreamError, "write failed"):
+            babel.search_stream(babel.compute_address(b"data"), FailingStream())
+
+    def test_kept_buffers(self):
+        stream = KeepingStream(b"kept")
+        babel.compute_stream_address(stream)
+        self.assertTrue(stream.views)
+        # The buffers read into are released once each read returns, so a kept one can no longer be used
+        for view in stream.views:
+            with self.assertRaises(ValueError):
+                bytes(view)
+
+    def test_threads(self):
+        data = [os.urandom(2000) for _ in range(8)]
+        errors = []
+
+        def work(item):
+            try:
+                for _ in range(4):
+                    address = babel.compute_address(item)
+                    self.assertPageStartsWith(babel.search(address), item)
+                    output = io.BytesIO()
+                    babel.search_stream(babel.compute_stream_address(io.BytesIO(item)), output)
+                    self.assertEqual(output.getvalue()[:len(item)], item)
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=work, args=(item,)) for item in data]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        self.assertEqual(errors, [])
+
+
+if __name__ == "__main__":
+    unittest.main()